@@ -0,0 +1,405 @@
+/**
+ * Orbit density rendering, aka Buddhabrot and Anti-Buddhabrot.
+ *
+ * Every sampled c is iterated with z0 = 0, and the points visited by the orbit
+ * are counted in a density histogram. Each of the rgb channels has its own
+ * iteration band. Each thread counts into a private histogram, and the
+ * histograms are summed in parallel when all the orbits are done.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "fractal.hpp"
+#include "curvesrobotics.hpp"
+#include "engsupport.hpp"
+#include "raylib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int NumChannels = 3;
+
+/**
+ * The part of the complex plane where c is sampled. The whole Mandelbrot set is inside.
+ */
+constexpr double SampleMinX = -2.0;
+constexpr double SampleMaxX = 1.0;
+constexpr double SampleMinY = -1.5;
+constexpr double SampleMaxY = 1.5;
+
+/**
+ * Resolution of the grid used for importance sampling.
+ */
+constexpr int ImportanceCells = 256;
+
+/**
+ * Two points of an orbit closer than this are taken to be the same, i.e. the orbit is in a cycle.
+ */
+constexpr double CycleEpsilon = 1e-12;
+
+/**
+ * Private histogram for a thread. Aligned so that two threads never share a cache line.
+ */
+struct alignas(64) thread_histogram {
+  std::vector<float> Density{}; //!< NumChannels planes of Width * Height.
+};
+
+/**
+ * Mapping from the complex plane to the canvas.
+ */
+struct view {
+  double PosUpperLeftX{};
+  double PosUpperLeftY{};
+  double Zoom{}; //!< Pixels per unit.
+  int    Width{};
+  int    Height{};
+};
+
+/**
+ * Return true when c is inside the main cardioid or the period 2 bulb, where all orbits stay bounded.
+ */
+auto IsInMainBulbs(double Cx, double Cy) -> bool {
+  auto const Xq = Cx - 0.25;
+  auto const Q  = Xq * Xq + Cy * Cy;
+  if (Q * (Q + Xq) <= 0.25 * Cy * Cy)
+    return true;
+  return (Cx + 1.) * (Cx + 1.) + Cy * Cy <= 1. / 16.;
+}
+
+/**
+ * Number of iterations before the orbit of c escapes, MaxIterations when it does not.
+ */
+auto EscapeIterations(double Cx, double Cy, int MaxIterations) -> int {
+  double Zx{};
+  double Zy{};
+  int    Iteration{};
+  while (Zx * Zx + Zy * Zy <= 4. && Iteration < MaxIterations) {
+    auto const Zr = Zx * Zx - Zy * Zy + Cx;
+    Zy            = 2. * Zx * Zy + Cy;
+    Zx            = Zr;
+    ++Iteration;
+  }
+  return Iteration;
+}
+
+/**
+ * Weights for each cell of a coarse grid over the sample area. Cells where the probes
+ * both escape and stay bounded are on the set boundary and get full weight.
+ */
+auto ImportanceWeights(fluffy::fractal::render_mode Mode, int MaxIterations, int NThreads) -> std::vector<double> {
+  constexpr double Background = 0.01; //!< Keep some samples everywhere so nothing is left out.
+
+  auto const CellW = (SampleMaxX - SampleMinX) / ImportanceCells;
+  auto const CellH = (SampleMaxY - SampleMinY) / ImportanceCells;
+
+  std::vector<double> Result(ImportanceCells * ImportanceCells, Background);
+
+  auto ldaClassifyRows = [&](int YStart, int YEnd) -> void {
+    for (int Y = YStart; Y < YEnd; ++Y) {
+      for (int X = 0; X < ImportanceCells; ++X) {
+        auto const X0 = SampleMinX + X * CellW;
+        auto const Y0 = SampleMinY + Y * CellH;
+
+        double const Probes[5][2]{
+            {X0, Y0}, {X0 + CellW, Y0}, {X0, Y0 + CellH}, {X0 + CellW, Y0 + CellH}, {X0 + CellW / 2, Y0 + CellH / 2}};
+
+        int NumBounded{};
+        for (auto const& P : Probes)
+          NumBounded += EscapeIterations(P[0], P[1], MaxIterations) >= MaxIterations;
+
+        auto const IsBoundary = NumBounded > 0 && NumBounded < 5;
+        auto const IsInterior = NumBounded == 5;
+
+        auto& W = Result[Y * ImportanceCells + X];
+        if (IsBoundary)
+          W = 1.;
+        else if (IsInterior && fluffy::fractal::render_mode::AntiBuddhabrot == Mode)
+          W = 1.;
+      }
+    }
+  };
+
+  auto vT = std::vector<std::thread>{};
+  for (int Idx = 0; Idx < NThreads; ++Idx)
+    vT.push_back(
+        std::thread(ldaClassifyRows, ImportanceCells * Idx / NThreads, ImportanceCells * (Idx + 1) / NThreads));
+  for (auto& T : vT) {
+    if (T.joinable())
+      T.join();
+  }
+  return Result;
+}
+
+/**
+ * Trace NumSamples orbits and count them into Histogram.
+ */
+auto TraceOrbits(fluffy::fractal::render_mode        Mode,
+                 fluffy::fractal::density_cfg const& Cfg,
+                 view const&                         View,
+                 std::vector<double> const&          vCdf,
+                 size_t                              NumSamples,
+                 unsigned                            Seed,
+                 thread_histogram&                   Histogram) -> void {
+
+  auto const NumPixels = size_t(View.Width) * size_t(View.Height);
+  Histogram.Density.assign(NumChannels * NumPixels, 0.f);
+
+  auto const MaxBand = *std::max_element(Cfg.MaxIterations, Cfg.MaxIterations + NumChannels);
+  auto const IsAnti  = fluffy::fractal::render_mode::AntiBuddhabrot == Mode;
+
+  std::vector<int> vOrbit(MaxBand); //!< Pixel index of each orbit point, -1 when outside the view.
+
+  std::mt19937                           Rng(Seed);
+  std::uniform_real_distribution<double> Uniform(0., 1.);
+
+  auto const CellW    = (SampleMaxX - SampleMinX) / ImportanceCells;
+  auto const CellH    = (SampleMaxY - SampleMinY) / ImportanceCells;
+  auto const TotalCdf = vCdf.empty() ? 0. : vCdf.back();
+  auto const MeanCell = TotalCdf / double(ImportanceCells * ImportanceCells);
+
+  for (size_t Sample = 0; Sample < NumSamples; ++Sample) {
+
+    // ---
+    // NOTE: Pick c. With importance sampling a cell is picked based on its weight, and each
+    //       orbit is counted with the weight ratio to keep the density the same as for
+    //       uniform sampling.
+    // ---
+    double Cx{};
+    double Cy{};
+    float  Weight{1.f};
+    if (!vCdf.empty()) {
+      auto const U          = Uniform(Rng) * TotalCdf;
+      auto const Cell       = size_t(std::upper_bound(vCdf.begin(), vCdf.end(), U) - vCdf.begin());
+      auto const Idx        = std::min(Cell, vCdf.size() - 1);
+      auto const CellWeight = vCdf[Idx] - (Idx ? vCdf[Idx - 1] : 0.);
+      Cx     = SampleMinX + (double(Idx % ImportanceCells) + Uniform(Rng)) * CellW;
+      Cy     = SampleMinY + (double(Idx / ImportanceCells) + Uniform(Rng)) * CellH;
+      Weight = float(MeanCell / CellWeight);
+    } else {
+      Cx = SampleMinX + Uniform(Rng) * (SampleMaxX - SampleMinX);
+      Cy = SampleMinY + Uniform(Rng) * (SampleMaxY - SampleMinY);
+    }
+
+    if (!IsAnti && IsInMainBulbs(Cx, Cy))
+      continue;
+
+    // ---
+    // NOTE: Iterate and keep the pixel of each point of the orbit.
+    //       Bounded orbits usually end up in a cycle. The cycle is found by comparing with
+    //       a point saved at each power of two (Brent), and the iteration stops there.
+    // ---
+    double Zx{};
+    double Zy{};
+    double SavedZx{};
+    double SavedZy{};
+    int    SavedLength{};
+    int    Length{};
+    int    Period{};
+    while (Length < MaxBand) {
+      auto const Zr = Zx * Zx - Zy * Zy + Cx;
+      Zy            = 2. * Zx * Zy + Cy;
+      Zx            = Zr;
+      if (Zx * Zx + Zy * Zy > 4.)
+        break;
+
+      auto const X   = std::floor((Zx - View.PosUpperLeftX) * View.Zoom);
+      auto const Y   = std::floor((View.PosUpperLeftY - Zy) * View.Zoom);
+      auto const In  = X >= 0. && X < View.Width && Y >= 0. && Y < View.Height;
+      vOrbit[Length] = In ? int(Y) * View.Width + int(X) : -1;
+      ++Length;
+
+      if (std::abs(Zx - SavedZx) < CycleEpsilon && std::abs(Zy - SavedZy) < CycleEpsilon) {
+        Period = Length - SavedLength;
+        break;
+      }
+      if (!(Length & (Length - 1))) {
+        SavedZx     = Zx;
+        SavedZy     = Zy;
+        SavedLength = Length;
+      }
+    }
+    auto const Escaped = !Period && Length < MaxBand;
+
+    // ---
+    // NOTE: Count the orbit into the channels where it belongs.
+    //       Buddhabrot: orbits escaping within the band.
+    //       Anti-Buddhabrot: orbits still bounded at the end of the band.
+    // ---
+    for (int Channel = 0; Channel < NumChannels; ++Channel) {
+      auto const Band = Cfg.MaxIterations[Channel];
+      int        NumPoints{};
+      if (IsAnti && (!Escaped || Length >= Band))
+        NumPoints = Band;
+      else if (!IsAnti && Escaped && Length <= Band)
+        NumPoints = Length;
+
+      float* pDensity = Histogram.Density.data() + Channel * NumPixels;
+      for (int Idx = 0; Idx < std::min(NumPoints, Length); ++Idx) {
+        if (vOrbit[Idx] >= 0)
+          pDensity[vOrbit[Idx]] += Weight;
+      }
+
+      // ---
+      // NOTE: The rest of the band goes round the cycle.
+      // ---
+      if (Period && NumPoints > Length) {
+        auto const NumRounds = (NumPoints - Length) / Period;
+        auto const Remainder = (NumPoints - Length) % Period;
+        for (int Idx = 0; Idx < Period; ++Idx) {
+          auto const Pixel = vOrbit[Length - Period + Idx];
+          if (Pixel >= 0)
+            pDensity[Pixel] += Weight * float(NumRounds + (Idx < Remainder ? 1 : 0));
+        }
+      }
+    }
+  }
+}
+
+}; // end of anonymous namespace
+
+namespace fluffy {
+namespace fractal {
+
+/**
+ * Render the orbit density of the request into pPixels.
+ */
+auto RenderDensity(render_request const& Request, Color* pPixels, int Stride) -> void {
+  auto const  Mode = Request.Mode;
+  auto const& Cfg  = Request.Density;
+  if (render_mode::Buddhabrot != Mode && render_mode::AntiBuddhabrot != Mode)
+    return;
+
+  auto const PosUpperL = UpperLeft(Request);
+
+  view View{};
+  View.PosUpperLeftX = PosUpperL.x;
+  View.PosUpperLeftY = PosUpperL.y;
+  View.Zoom          = Request.Zoom;
+  View.Width         = Request.Width;
+  View.Height        = Request.Height;
+
+  auto const NumPixels = size_t(View.Width) * size_t(View.Height);
+  auto const NThreads  = std::max(Request.NThreads, 1);
+
+  // ---
+  // NOTE: The cumulative weights used for picking cells when importance sampling.
+  // ---
+  std::vector<double> vCdf{};
+  if (Cfg.ImportanceSampling) {
+    auto const MaxBand = *std::max_element(Cfg.MaxIterations, Cfg.MaxIterations + NumChannels);
+    vCdf               = ImportanceWeights(Mode, std::min(MaxBand, 500), NThreads);
+    for (size_t Idx = 1; Idx < vCdf.size(); ++Idx)
+      vCdf[Idx] += vCdf[Idx - 1];
+  }
+
+  // ---
+  // NOTE: Trace the orbits, each thread with its own histogram.
+  // ---
+  std::vector<thread_histogram> vHistogram(NThreads);
+  {
+    auto vT = std::vector<std::thread>{};
+    for (int Idx = 0; Idx < NThreads; ++Idx) {
+      auto const NumSamples = Cfg.NumSamples / NThreads + (size_t(Idx) < Cfg.NumSamples % NThreads ? 1 : 0);
+      auto const Seed       = Cfg.Seed * 7919u + unsigned(Idx);
+      vT.push_back(std::thread(TraceOrbits,
+                               Mode,
+                               std::cref(Cfg),
+                               std::cref(View),
+                               std::cref(vCdf),
+                               NumSamples,
+                               Seed,
+                               std::ref(vHistogram[Idx])));
+    }
+    for (auto& T : vT) {
+      if (T.joinable())
+        T.join();
+    }
+  }
+
+  // ---
+  // NOTE: Parallel reduction. Each thread sums a range of the pixels from all the
+  //       histograms into the first one, and finds the max of each channel in its range.
+  // ---
+  struct alignas(64) channel_max {
+    float Max[NumChannels]{};
+  };
+  std::vector<channel_max> vMax(NThreads);
+  {
+    auto ldaReduce = [&](int Idx) -> void {
+      auto const Begin = NumPixels * Idx / NThreads;
+      auto const End   = NumPixels * (Idx + 1) / NThreads;
+      for (int Channel = 0; Channel < NumChannels; ++Channel) {
+        float* pSum = vHistogram[0].Density.data() + Channel * NumPixels;
+        for (size_t H = 1; H < vHistogram.size(); ++H) {
+          float const* pSrc = vHistogram[H].Density.data() + Channel * NumPixels;
+          for (size_t P = Begin; P < End; ++P)
+            pSum[P] += pSrc[P];
+        }
+        for (size_t P = Begin; P < End; ++P)
+          vMax[Idx].Max[Channel] = std::max(vMax[Idx].Max[Channel], pSum[P]);
+      }
+    };
+
+    auto vT = std::vector<std::thread>{};
+    for (int Idx = 0; Idx < NThreads; ++Idx)
+      vT.push_back(std::thread(ldaReduce, Idx));
+    for (auto& T : vT) {
+      if (T.joinable())
+        T.join();
+    }
+  }
+
+  float Max[NumChannels]{};
+  for (auto const& M : vMax) {
+    for (int Channel = 0; Channel < NumChannels; ++Channel)
+      Max[Channel] = std::max(Max[Channel], M.Max[Channel]);
+  }
+
+  // ---
+  // NOTE: Map the density to color. Square root to bring out the faint orbits.
+  // ---
+  float const* pDensity = vHistogram[0].Density.data();
+  for (int Y = 0; Y < View.Height; ++Y) {
+    for (int X = 0; X < View.Width; ++X) {
+      auto const    P = size_t(Y) * size_t(View.Width) + size_t(X);
+      unsigned char Channels[NumChannels]{};
+      for (int Channel = 0; Channel < NumChannels; ++Channel) {
+        auto const D = Max[Channel] > 0.f ? pDensity[Channel * NumPixels + P] / Max[Channel] : 0.f;
+        Channels[Channel] = static_cast<unsigned char>(255.f * std::sqrt(std::min(D, 1.f)));
+      }
+      pPixels[size_t(Y) * Stride + X] = Color{Channels[0], Channels[1], Channels[2], 0xFF};
+    }
+  }
+}
+
+}; // namespace fractal
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,267 @@
+/**
+ * Memory for pixel canvases.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "canvasmemory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+/**
+ * Round Value up to a multiple of Alignment, which must be a power of two.
+ */
+auto RoundUp(size_t Value, size_t Alignment) -> size_t { return (Value + Alignment - 1) & ~(Alignment - 1); }
+
+/**
+ * Parse a sysfs cpu list, i.e. "0-15,32-47".
+ */
+auto ParseCpuList(std::string const& List) -> std::vector<int> {
+  std::vector<int>  Result{};
+  std::stringstream Stream(List);
+  std::string       Range{};
+  while (std::getline(Stream, Range, ',')) {
+    int  First{};
+    int  Last{};
+    auto NumParsed = std::sscanf(Range.c_str(), "%d-%d", &First, &Last);
+    if (NumParsed == 1)
+      Last = First;
+    if (NumParsed < 1)
+      continue;
+    for (int Cpu = First; Cpu <= Last; ++Cpu)
+      Result.push_back(Cpu);
+  }
+  return Result;
+}
+
+/**
+ * The CPUs of each NUMA node. Read once.
+ */
+auto NumaNodeCpus() -> std::vector<std::vector<int>> const& {
+  static std::vector<std::vector<int>> const vNodeCpus = []() {
+    std::vector<std::vector<int>> Result{};
+#ifdef __linux__
+    for (int Node = 0;; ++Node) {
+      std::ifstream File("/sys/devices/system/node/node" + std::to_string(Node) + "/cpulist");
+      if (!File)
+        break;
+      std::string List{};
+      std::getline(File, List);
+      Result.push_back(ParseCpuList(List));
+    }
+#endif
+    return Result;
+  }();
+  return vNodeCpus;
+}
+
+}; // end of anonymous namespace
+
+namespace fluffy {
+namespace memory {
+
+/**
+ */
+auto RowStride(int Width, size_t BytesPerPixel) -> int {
+  if (Width <= 0 || !BytesPerPixel)
+    return 0;
+  auto const RowBytes = RoundUp(size_t(Width) * BytesPerPixel, CacheLineSize);
+  return int((RowBytes + BytesPerPixel - 1) / BytesPerPixel);
+}
+
+/**
+ */
+auto AllocateAligned(size_t NumBytes, bool HugePages) -> std::shared_ptr<void> {
+  if (!NumBytes)
+    return {};
+
+#ifdef __linux__
+  if (HugePages && NumBytes >= HugePageSize) {
+    // ---
+    // NOTE: Transparent huge pages need 2MB aligned memory. Map a bit more than needed
+    //       and give back the unaligned head and the tail.
+    // ---
+    auto const Size    = RoundUp(NumBytes, HugePageSize);
+    auto const MapSize = Size + HugePageSize;
+    void*      pMap    = mmap(nullptr, MapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (pMap != MAP_FAILED) {
+      auto const Address = reinterpret_cast<uintptr_t>(pMap);
+      auto const Aligned = RoundUp(Address, HugePageSize);
+      auto const Head    = Aligned - Address;
+      auto const Tail    = MapSize - Head - Size;
+      if (Head)
+        munmap(pMap, Head);
+      if (Tail)
+        munmap(reinterpret_cast<void*>(Aligned + Size), Tail);
+
+      void* pData = reinterpret_cast<void*>(Aligned);
+      madvise(pData, Size, MADV_HUGEPAGE); // Only advice, failure is fine.
+
+      return std::shared_ptr<void>(pData, [Size](void* p) { munmap(p, Size); });
+    }
+  }
+#else
+  (void)HugePages;
+#endif
+
+  auto const Size  = RoundUp(NumBytes, CacheLineSize);
+  void*      pData = ::operator new(Size, std::align_val_t(CacheLineSize), std::nothrow);
+  if (!pData)
+    return {};
+
+  return std::shared_ptr<void>(pData, [](void* p) { ::operator delete(p, std::align_val_t(CacheLineSize)); });
+}
+
+/**
+ */
+auto AllocateColors(size_t NumPixels, bool HugePages) -> std::shared_ptr<Color> {
+  auto spMemory = AllocateAligned(NumPixels * sizeof(Color), HugePages);
+  return std::shared_ptr<Color>(spMemory, static_cast<Color*>(spMemory.get()));
+}
+
+/**
+ * Free buffers, each with the number of pixels it holds.
+ */
+struct buffer_pool::state {
+  std::mutex                                             Mut{};
+  std::vector<std::pair<size_t, std::shared_ptr<Color>>> vFree{};
+  size_t                                                 MaxFree{};
+};
+
+/**
+ */
+buffer_pool::buffer_pool(size_t MaxFree) : spState(std::make_shared<state>()) { spState->MaxFree = MaxFree; }
+
+/**
+ */
+auto buffer_pool::Acquire(size_t NumPixels, bool HugePages) -> std::shared_ptr<Color> {
+  if (!NumPixels)
+    return {};
+
+  std::shared_ptr<Color> spMemory{};
+  size_t                 Capacity{};
+  {
+    // ---
+    // NOTE: Take the smallest free buffer that is large enough.
+    // ---
+    std::lock_guard<std::mutex> Lock(spState->Mut);
+    auto&                       vFree = spState->vFree;
+    auto                        Best  = vFree.end();
+    for (auto It = vFree.begin(); It != vFree.end(); ++It) {
+      if (It->first >= NumPixels && (Best == vFree.end() || It->first < Best->first))
+        Best = It;
+    }
+    if (Best != vFree.end()) {
+      Capacity = Best->first;
+      spMemory = std::move(Best->second);
+      vFree.erase(Best);
+    }
+  }
+
+  if (!spMemory) {
+    Capacity = NumPixels;
+    spMemory = AllocateColors(NumPixels, HugePages);
+    if (!spMemory)
+      return {};
+  }
+
+  // ---
+  // NOTE: The handle given out owns a reference to the memory. When it is released the
+  //       memory goes back to the pool, if the pool still exists and is not full.
+  // ---
+  std::weak_ptr<state> wpState = spState;
+  Color*               pPixels = spMemory.get();
+  return std::shared_ptr<Color>(pPixels, [wpState, spMemory, Capacity](Color*) mutable {
+    if (auto spPool = wpState.lock()) {
+      std::lock_guard<std::mutex> Lock(spPool->Mut);
+      if (spPool->vFree.size() < spPool->MaxFree)
+        spPool->vFree.emplace_back(Capacity, std::move(spMemory));
+    }
+    spMemory.reset();
+  });
+}
+
+/**
+ */
+auto buffer_pool::NumFree() const -> size_t {
+  std::lock_guard<std::mutex> Lock(spState->Mut);
+  return spState->vFree.size();
+}
+
+/**
+ */
+auto NumNumaNodes() -> int { return std::max<int>(1, NumaNodeCpus().size()); }
+
+/**
+ */
+auto NumaNodeForBlock(int Idx, int NumBlocks) -> int {
+  if (NumBlocks <= 0)
+    return 0;
+  return std::clamp(Idx * NumNumaNodes() / NumBlocks, 0, NumNumaNodes() - 1);
+}
+
+/**
+ */
+auto PinThreadToNumaNode(int Node) -> bool {
+#ifdef __linux__
+  auto const& vNodeCpus = NumaNodeCpus();
+  if (vNodeCpus.size() < 2 || Node < 0 || Node >= int(vNodeCpus.size()) || vNodeCpus[Node].empty())
+    return false;
+
+  cpu_set_t CpuSet{};
+  CPU_ZERO(&CpuSet);
+  for (auto Cpu : vNodeCpus[Node]) {
+    if (Cpu < CPU_SETSIZE)
+      CPU_SET(Cpu, &CpuSet);
+  }
+  return 0 == pthread_setaffinity_np(pthread_self(), sizeof(CpuSet), &CpuSet);
+#else
+  (void)Node;
+  return false;
+#endif
+}
+
+}; // namespace memory
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
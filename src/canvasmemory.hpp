@@ -0,0 +1,110 @@
+#ifndef SRC_CANVASMEMORY_HPP
+#define SRC_CANVASMEMORY_HPP
+
+/**
+ * Memory for pixel canvases.
+ *
+ * Buffers are 64 byte aligned, or 2MB aligned and backed by huge pages when
+ * large enough, and the rows are padded so that each row starts on a cache line.
+ * The memory is not touched by the allocator, so the pages end up on the NUMA
+ * node of the worker thread that first writes to them.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace fluffy {
+namespace memory {
+
+constexpr size_t CacheLineSize = 64;
+constexpr size_t HugePageSize  = 2 * 1024 * 1024;
+
+/**
+ * Number of pixels per row so that each row starts at a cache line boundary.
+ */
+auto RowStride(int Width, size_t BytesPerPixel = sizeof(Color)) -> int;
+
+/**
+ * Allocate NumBytes of uninitialized memory aligned to CacheLineSize.
+ * @HugePages - Use 2MB aligned memory and ask for transparent huge pages when
+ *              the buffer is at least HugePageSize. Only has an effect on Linux.
+ */
+auto AllocateAligned(size_t NumBytes, bool HugePages = true) -> std::shared_ptr<void>;
+
+/**
+ * Typed version of AllocateAligned for canvases.
+ */
+auto AllocateColors(size_t NumPixels, bool HugePages = true) -> std::shared_ptr<Color>;
+
+/**
+ * Thread safe pool of pixel buffers, so that renders in flight do not need to go to the
+ * allocator, and fault in new pages, for every image. A buffer goes back to the pool
+ * when the last shared_ptr to it is released, and is freed instead if the pool is gone.
+ */
+struct buffer_pool {
+  explicit buffer_pool(size_t MaxFree = 16);
+
+  /**
+   * Get a buffer of at least NumPixels pixels. The content is undefined.
+   */
+  auto Acquire(size_t NumPixels, bool HugePages = true) -> std::shared_ptr<Color>;
+
+  /**
+   * Number of buffers waiting in the pool.
+   */
+  auto NumFree() const -> size_t;
+
+  struct state;
+  std::shared_ptr<state> spState{};
+};
+
+/**
+ * Number of NUMA nodes in the machine. 1 when it can not be found.
+ */
+auto NumNumaNodes() -> int;
+
+/**
+ * The NUMA node that should handle block Idx out of NumBlocks, so that consecutive
+ * blocks, and thereby consecutive memory, stays on the same node.
+ */
+auto NumaNodeForBlock(int Idx, int NumBlocks) -> int;
+
+/**
+ * Pin the calling thread to the CPUs of a NUMA node.
+ * Return false if that is not possible, the thread is then left as is.
+ */
+auto PinThreadToNumaNode(int Node) -> bool;
+
+}; // namespace memory
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
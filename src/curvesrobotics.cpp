@@ -12,22 +12,32 @@
 
 #include "curvesrobotics.hpp"
 #include "engsupport.hpp"
+#include "fixedstep.hpp"
 #include "fractal.hpp"
+#include "perfcounters.hpp"
+#include "quatjulia.hpp"
+#include "renderbackend.hpp"
+#include "trendbuffer.hpp"
 
 #include "raylib.h"
+#include "rlgl.h"
 
 #define RAYMATH_IMPLEMENTATION // Define external out-of-line implementation
 #include "raymath.h"           // Vector3, Quaternion and Matrix functionality
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
 
 #define _USE_MATH_DEFINES
 #include <cmath>
 
 #include <cstdio>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
-#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -35,18 +45,39 @@
 namespace {
 //------------------------------------------------------------------------------
 
+/**
+ * Trend points kept for the trail on the Fourier page, about a minute at 60 steps per second.
+ */
+constexpr size_t TrendCapacity = 4096;
+
+/**
+ * Size of the trend points in engineering units.
+ */
+constexpr float TrendPointRadius = 0.01f;
+
+/**
+ * Level of detail in pixels of the trails drawn as lines, see fluffy::trend::pixel_trail.
+ * The trails drawn as points keep every point, a point left out would just be missing.
+ */
+constexpr float TrailTolerance = 0.5f;
+
+/**
+ * Samples per second of each simulated live channel, see StartTrendProducers.
+ */
+constexpr double LiveSampleRate = 10000.;
+
 struct data {
 
-  // Declare the function pointer
-  auto (*UpdateDrawFramePointer)(data*) -> void;
   std::vector<std::string> vHelpTextPage{};
   std::string              WikipediaLink{};
 
   int screenWidth  = 1280;
   int screenHeight = 768;
 
-  enum class pages { PageAsteroid, PageFourier, PageFractal, Page3D, PageHelp };
-  pages PageNum{};
+  enum class pages { PageAsteroid, PageFourier, PageFractal, Page3D, PageHelp, NumPages };
+  pages                                     PageNum{};                 //!< The page drawn last.
+  pages                                     Selected{pages::PageHelp}; //!< The page to draw, see Pages.
+  std::array<bool, size_t(pages::NumPages)> aPageReady{};              //!< Init has been called.
 
   int   Key{};
   int   KeyPrv{};
@@ -55,35 +86,50 @@ struct data {
   bool  ShowGrid{true};
   float Xcalc{};
   int   n{5}; //!< Fourier series number of terms.
-  float dt{};
-  float t{};
+  float t{};  //!< Simulated time to draw, between the last two steps of Clock.
 
-  std::mutex           MutTrendPoints{};
-  std::vector<Vector4> vTrendPoints{};
-  size_t               CurrentTrendPoint{};
-  size_t               NumTrendPoints{};
-  currob::grid_cfg     GridCfg{};
+  fluffy::sim::clock Clock{}; //!< Steps the simulation of the page, see StepSimulation.
 
-  fluffy::fractal::config FractalConfig{};
-  Texture2D               FractalTexture{};
+  fluffy::render::backend Render{}; //!< Where the 2D pages draw, see fluffy::render.
 
-  Matrix MhE2P{}; //!< Homogenous matrix for conversion from engineering space
-                  //!< to pixelspace.
+  fluffy::trend::ring_buffer Trend{TrendCapacity};
+  fluffy::trend::pixel_trail TrendPixels{}; //!< Trend in pixels, see DrawTrailPoints. Only culled.
+  uint64_t                   TrendLapStart{}; //!< Trend.NumPushed() when the current lap started.
+  currob::grid_cfg           GridCfg{};
 
-  Matrix MhE2PInv{}; //!< Homogenous matrix for conversion from pixel
-                     //!< space to engineering space.
+  fluffy::trend::channels  LiveTrends{};       //!< Live channels, each fed by one producer thread.
+  std::vector<std::thread> vTrendProducers{};  //!< Empty when the producers are stopped.
+  std::atomic<bool>        RunTrendProducers{};
+  std::vector<fluffy::trend::pixel_trail> vLivePixels{}; //!< One per live channel.
 
-  Matrix MhG2E{}; //!< Homogenous matrix for conversion from grid
-                  //!< space to engineering space.
+  fluffy::fractal::config FractalConfig{};
+  Texture2D               FractalTexture{};
+
+  /**
+   * The first fractal, rendered ahead of time on a thread from a copy of what it needs.
+   */
+  struct fractal_prewarm {
+    std::thread             Worker{};
+    fluffy::fractal::config Config{}; //!< The worker renders into Config.iMage.
+    currob::grid_cfg        GridCfg{};
+    es::vector4_double      Resolution{};
+  };
+  fractal_prewarm FractalPrewarm{};
 
-  Matrix MhG2EInv{}; //!< Homogenous matrix for conversion from grid
-                     //!< space to engineering space.
+  // ---
+  // NOTE: Pixel space is the root frame, engineering space is below it and grid space is
+  //       below engineering space. The frames are in double so that the mouse position
+  //       stays exact to the pixel at deep zoom.
+  // ---
+  es::transform_graph Frames{};
+  es::frame_id        FrameEng{};  //!< Local transform from engineering space to pixel space.
+  es::frame_id        FrameGrid{}; //!< Local transform from grid space to engineering space.
 
   Vector4 vEngOffset{}; //!< Position of figure in engineering space.
   Vector4 vPixelsPerUnit{100.f, 100.f, 100.f, 0.f};
 
-  Vector4 MousePosEng{};
-  Vector4 MousePosGrid{};
+  es::vector4_double MousePosEng{};
+  es::vector4_double MousePosGrid{};
   struct mouse_input {
     bool MouseButtonPressed{};
     bool MouseButtonDown{};
@@ -94,16 +140,115 @@ struct data {
 
   Camera3D Camera{};
   Vector3  CubePosition{0.0f, 0.0f, 0.0f};
+
+  bool                      ShowQuatJulia{}; //!< Ray-march a quaternion Julia set on the 3D page.
+  fluffy::quatjulia::params QuatJulia{};
+  Image                     QuatJuliaImage{};
+  Texture2D                 QuatJuliaTexture{};
+  double                    QuatJuliaTime{}; //!< Seconds used for the last render.
 };
+
+/**
+ * Conversion from engineering space to pixel space, for drawing.
+ */
+auto Eng2Pixel(data* pData) -> es::affine2 { return es::Affine2(es::World(pData->Frames, pData->FrameEng)); }
+
+/**
+ * The part of engineering space that is on the screen, the screen corners mapped back with
+ * the inverse of E2P. Primitives outside of it are culled before they are transformed.
+ */
+auto VisibleEng(fluffy::render::backend const& R, es::affine2 const& E2P) -> es::bounds2 {
+  return es::Transform(es::Invert(E2P), es::Bounds(0.f, 0.f, float(R.Width), float(R.Height)));
+}
+
+/**
+ * The same from the pixel to engineering transform of the frame graph.
+ */
+auto VisibleEng(data* pData) -> es::bounds2 {
+  auto const P2E = es::Affine2(es::WorldInv(pData->Frames, pData->FrameEng));
+  return es::Transform(P2E, es::Bounds(0.f, 0.f, float(pData->screenWidth), float(pData->screenHeight)));
+}
+
+/**
+ * Bounds of a circle, for culling.
+ */
+auto CircleBounds(Vector4 const& Centre, float Radius) -> es::bounds2 {
+  return es::Bounds(Centre.x - Radius, Centre.y - Radius, Centre.x + Radius, Centre.y + Radius);
+}
+
+/**
+ * Angle of the first term of the Fourier square wave at time t.
+ */
+auto FourierOmegat(double t) -> float {
+  constexpr double Frequency = 2.0;
+  return float(M_2_PI * Frequency * t);
+}
+
+constexpr float FourierRadius = float(4. / M_PI);
+
+/**
+ * Height of the Fourier square wave of NumTerms terms at time t, where the last circle ends.
+ */
+auto FourierWave(int NumTerms, double t) -> float {
+  auto const Omegat = FourierOmegat(t);
+  auto       Y      = 0.f;
+  for (int Idx = 0; Idx < std::max(NumTerms, 1); ++Idx) {
+    auto const nthTerm = 1.f + Idx * 2.f;
+    Y += FourierRadius / nthTerm * sinf(nthTerm * Omegat);
+  }
+  return Y;
+}
+
+/**
+ * The Asteroid of radius Radius at time t, from its centre.
+ */
+auto AsteroidOffset(float Radius, float t) -> Vector4 {
+  return es::Vector(
+      Radius / 4.f * (3.f * cosf(t) + cosf(3.f * t)), Radius / 4.f * (3.f * sinf(t) - sinf(3.f * t)), 0.f);
+}
+
+/**
+ * The grid value GridCenterValue is at the engineering origo, so grid space is engineering
+ * space moved by -GridCenterValue.
+ */
+auto Grid2Eng(currob::grid_cfg const& GridCfg) -> es::matrix4_double {
+  return es::SetTranslation(GridCfg.GridCenterValue * -1.);
+}
+
+/**
+ * Label for a tick value with one decimal, as glyph indices into the default font of R. The
+ * label is placed with its first glyph at X, Y.
+ */
+auto GridLabel(fluffy::render::backend const& R, float Value, float X, float Y) -> currob::grid_label {
+  currob::grid_label                        Label{X, Y};
+  std::array<char, currob::MaxLabelGlyphs> aText{};
+
+  auto const [pEnd, Ec] = std::to_chars(aText.data(), aText.data() + aText.size(), Value, std::chars_format::fixed, 1);
+  if (std::errc{} != Ec)
+    return Label;
+
+  for (auto const* pC = aText.data(); pC != pEnd; ++pC)
+    Label.aGlyph[Label.NumGlyphs++] = fluffy::render::GlyphIndex(R, *pC);
+  return Label;
+}
+
 /*
- * Create lines and ticks for a grid in engineering units.
+ * Create lines and ticks for a grid in engineering units. Returns GridCfg as it is when
+ * it was made with the same transform and grid setup.
  */
-auto GridCfgInPixels(Matrix const&           MhE2P, //!< Homogenous matrix from
-                     currob::grid_cfg const& GridCfg) -> currob::grid_cfg {
+auto GridCfgInPixels(fluffy::render::backend const& R,   //!< For the screen size and the glyphs.
+                     es::affine2 const&             E2P, //!< Engineering to pixel space.
+                     currob::grid_cfg const&        GridCfg) -> currob::grid_cfg {
+  auto const Key = currob::grid_key{
+      E2P, GridCfg.TickDistance, GridCfg.GridCenterValue, GridCfg.GridDimensions, GridCfg.GridScreenCentre};
+  if (!GridCfg.vLineVertices.empty() && Key == GridCfg.Key)
+    return GridCfg;
+
+  fluffy::perf::region PerfRegion{"curves.gridcfginpixels"};
 
   auto Result = GridCfg;
-  Result.vGridLines.clear();
-  Result.vGridSubDivider.clear();
+  Result.vLineVertices.clear();
+  Result.vLabels.clear();
 
   auto const GridLength        = GridCfg.GridDimensions.x;
   auto const GridHeight        = GridCfg.GridDimensions.y;
@@ -216,83 +361,89 @@ auto GridCfgInPixels(Matrix const&           MhE2P, //!< Homogenous matrix from
   Result.GridDimensions.x   = GridLength;
   Result.GridDimensions.y   = GridHeight;
 
-  auto const MhG2E = es::SetTranslation(es::Vector(GridOrigoX, GridOrigoY, 0.f));
+  auto const G2E = es::affine2{{1.f, 1.f}, {float(GridOrigoX), float(GridOrigoY)}};
 
   // ---
-  // NOTE: Create major dividers.
+  // NOTE: Leave out the lines that are not on the screen.
   // ---
-  for (auto const& Elem : vGridPoint) {
-    auto const ToPixel   = MhE2P * es::Point(Elem.toX, Elem.toY, 0.f);
-    auto const FromPixel = MhE2P * es::Point(Elem.fromX, Elem.fromY, 0.f);
-
-    // ---
-    // NOTE: Convert the floating point indicators.
-    // ---
-    auto ldaFloat2Str = [](float In) -> std::string {
-      std::string Result{};
-      struct converted_text {
-        char Conv[10]{};
-      };
-
-      converted_text C{};
-
-      auto const Status = std::snprintf(C.Conv, sizeof(converted_text), "%.1f", In);
-
-      if (Status) {
-        Result = std::string(C.Conv);
-      }
-      return Result;
-    };
-
-    // ---
-    // NOTE: Create the axis tag based on the setup from the grid.
-    // ---
-    auto const&       TagX     = Elem.TagX ? ldaFloat2Str((MhG2E * es::Point(Elem.fromX, 0.f, 0.f)).x) : "";
-    auto const&       TagY     = Elem.TagY ? ldaFloat2Str((MhG2E * es::Point(0.f, Elem.fromY, 0.f)).y) : "";
-    currob::pixel_pos PixelPos = {int(ToPixel.x), int(ToPixel.y), DARKGRAY, TagX, TagY};
+  auto const Visible      = VisibleEng(R, E2P);
+  auto       ldaOffScreen = [&Visible](grid_point const& P) {
+    return !es::Intersects(Visible, es::Bounds(P.fromX, P.fromY, P.toX, P.toY));
+  };
+  std::erase_if(vGridPoint, ldaOffScreen);
+  std::erase_if(vGridSubDivider, ldaOffScreen);
 
-    Result.vGridLines.push_back(PixelPos);
-    Result.vGridLines.push_back({int(FromPixel.x), int(FromPixel.y), DARKGRAY});
+  // ---
+  // NOTE: Transform the end points of all lines to pixels in one pass. The major dividers
+  //       come first, then the minor ones, with to and from after each other.
+  // ---
+  auto const         NumLines = vGridPoint.size() + vGridSubDivider.size();
+  std::vector<float> vX(2 * NumLines);
+  std::vector<float> vY(2 * NumLines);
+  size_t             Pos{};
+  for (auto const* pLines : {&vGridPoint, &vGridSubDivider}) {
+    for (auto const& Elem : *pLines) {
+      vX[Pos]     = Elem.toX;
+      vY[Pos]     = Elem.toY;
+      vX[Pos + 1] = Elem.fromX;
+      vY[Pos + 1] = Elem.fromY;
+      Pos += 2;
+    }
   }
+  es::TransformPoints(E2P, vX, vY, vX, vY);
 
   // ---
-  // NOTE: Create the minor dividers.
+  // NOTE: Pack the lines, whole pixels as before, and create the axis tags of the major
+  //       dividers based on the setup from the grid.
   // ---
-  for (auto const& Elem : vGridSubDivider) {
-    auto const ToPixel   = MhE2P * es::Point(Elem.toX, Elem.toY, 0.f);
-    auto const FromPixel = MhE2P * es::Point(Elem.fromX, Elem.fromY, 0.f);
-    Result.vGridLines.push_back({int(ToPixel.x), int(ToPixel.y)});
-    Result.vGridLines.push_back({int(FromPixel.x), int(FromPixel.y)});
+  Result.vLineVertices.resize(4 * NumLines);
+  for (size_t Idx = 0; Idx < 2 * NumLines; ++Idx) {
+    Result.vLineVertices[2 * Idx]     = std::trunc(vX[Idx]);
+    Result.vLineVertices[2 * Idx + 1] = std::trunc(vY[Idx]);
+  }
+  Result.NumMajorLines = vGridPoint.size();
+
+  Pos = 0;
+  for (auto const& Elem : vGridPoint) {
+    auto const X = std::trunc(vX[Pos]);
+    auto const Y = std::trunc(vY[Pos]);
+    if (Elem.TagX)
+      Result.vLabels.push_back(GridLabel(R, (G2E * es::Point(Elem.fromX, 0.f, 0.f)).x, X - 1.f, Y + 8.f));
+    if (Elem.TagY)
+      Result.vLabels.push_back(GridLabel(R, (G2E * es::Point(0.f, Elem.fromY, 0.f)).y, X - 20.f, Y - 10.f));
+    Pos += 2;
   }
 
+  Result.Key = currob::grid_key{
+      E2P, Result.TickDistance, Result.GridCenterValue, Result.GridDimensions, Result.GridScreenCentre};
   return Result;
 };
 
 /**
- * Initialize the matrix to convert from engineering basis to screen basis.
+ * Initialize the conversion from engineering basis to screen basis.
  * The screen center is used as the reference point.
  *
- * @OrigoScreen - the X, Y, Z values in engineering space at center of screen.
+ * @OrigoScreen - the X, Y values in engineering space at center of screen.
  * @vPixelsPerUnit - The number of pixels per unit, i.e 100 pixels equals 1m.
  * @ScreenCenterInPixels - The coordinates for the centre of the screen in
  * pixels.
  */
-auto InitEng2PixelMatrix(Vector4 const& OrigoScreen, Vector4 const& vPixelsPerUnit, Vector4 const& ScreenPosInPixels)
-    -> Matrix {
+auto InitEng2Pixel(Vector4 const& OrigoScreen, Vector4 const& vPixelsPerUnit, Vector4 const& ScreenPosInPixels)
+    -> es::matrix4_double {
 
   // ---
   // Flip because pixel coord increases when moving down.
   // ---
-  constexpr float Flip   = -1.f;
-  constexpr float NoFlip = 1.f;
+  constexpr double Flip   = -1.;
+  constexpr double NoFlip = 1.;
 
   // ---
   // Create a Homogenous matrix that converts from engineering unit to screen.
   // ---
-  auto Hes = es::I();
-  Hes.m12  = ScreenPosInPixels.x + OrigoScreen.x * vPixelsPerUnit.x;
-  Hes.m13  = ScreenPosInPixels.y + OrigoScreen.y * vPixelsPerUnit.y;
-  Hes.m14  = ScreenPosInPixels.z + OrigoScreen.z * vPixelsPerUnit.z;
+  auto Hes = es::IDouble();
+  Hes.m12  = ScreenPosInPixels.x + double(OrigoScreen.x) * vPixelsPerUnit.x;
+  Hes.m13  = ScreenPosInPixels.y + double(OrigoScreen.y) * vPixelsPerUnit.y;
+  Hes.m14  = ScreenPosInPixels.z + double(OrigoScreen.z) * vPixelsPerUnit.z;
 
   // Flip and scale to pixel value.
   Hes.m0  = NoFlip * vPixelsPerUnit.x;
@@ -304,75 +455,60 @@ auto InitEng2PixelMatrix(Vector4 const& OrigoScreen, Vector4 const& vPixelsPerUn
 
 // ---
 // NOTE: Lamda to draw a box in engineering units.
-// @MhE2P - Homogenous matrix to convert from engineering to pixelspace
+// @E2P - Conversion from engineering to pixelspace
 // @Pos - Lower Left X, Lower Left Y
 // @Dim - Length, Height
 // ---
-auto ldaDrawBox =
-    [](Matrix const& MhE2P, Vector4 const& Pos, Vector4 const& Dim, Color Col = BLUE, float Alpha = 1.f) -> void {
+auto ldaDrawBox = [](fluffy::render::backend& R,
+                     es::affine2 const&       E2P,
+                     Vector4 const&           Pos,
+                     Vector4 const&           Dim,
+                     Color                    Col   = BLUE,
+                     float                    Alpha = 1.f) -> void {
+  if (!es::Intersects(VisibleEng(R, E2P), es::Bounds(Pos.x, Pos.y, Pos.x + Dim.x, Pos.y + Dim.y)))
+    return;
+
   Color C = Col;
   C.a     = 0xFF & int(float(int(Col.a) * Alpha * 255.f / 255.f));
 
-  auto const PixPosStrt = MhE2P * Pos;
-  auto const PixPosEnd  = MhE2P * (Pos + Dim);
+  auto const PixPosStrt = E2P * Pos;
+  auto const PixPosEnd  = E2P * (es::xpr::Val(Pos) + Dim);
   // DrawLine(PixPosStrt.x, PixPosStrt.y, 0, 0, VIOLET); //!< Debug help line.
   // DrawLine(PixPosEnd.x, PixPosEnd.y, 0, 0, ORANGE);   //!< Debug help line.
-  DrawLine(PixPosStrt.x, PixPosStrt.y, PixPosEnd.x, PixPosStrt.y, C);
-  DrawLine(PixPosEnd.x, PixPosStrt.y, PixPosEnd.x, PixPosEnd.y, C);
-  DrawLine(PixPosStrt.x, PixPosStrt.y, PixPosStrt.x, PixPosEnd.y, C);
-  DrawLine(PixPosStrt.x, PixPosEnd.y, PixPosEnd.x, PixPosEnd.y, C);
+  fluffy::render::Line(R, PixPosStrt.x, PixPosStrt.y, PixPosEnd.x, PixPosStrt.y, C);
+  fluffy::render::Line(R, PixPosEnd.x, PixPosStrt.y, PixPosEnd.x, PixPosEnd.y, C);
+  fluffy::render::Line(R, PixPosStrt.x, PixPosStrt.y, PixPosStrt.x, PixPosEnd.y, C);
+  fluffy::render::Line(R, PixPosStrt.x, PixPosEnd.y, PixPosEnd.x, PixPosEnd.y, C);
 };
 
 // ---
 // NOTE: Lamda to write/draw text placed in engineering units.
 // ---
-auto ldaDrawText = [](Matrix const&      MhE2P,
-                      Vector4 const&     Pos,
-                      std::string const& Text,
-                      int                FontSize  = 20,
-                      Color              Col       = BLUE,
-                      float              AlphaText = 1.f,
-                      float              AlphaBox  = 1.f) -> void {
-  auto const PixelPos = MhE2P * Pos;
+auto ldaDrawText = [](fluffy::render::backend& R,
+                      es::affine2 const&       E2P,
+                      Vector4 const&           Pos,
+                      std::string const&       Text,
+                      int                      FontSize  = 20,
+                      Color                    Col       = BLUE,
+                      float                    AlphaText = 1.f,
+                      float                    AlphaBox  = 1.f) -> void {
+  auto const PixelPos = E2P * Pos;
 
   // DrawLine(PixelPos.x, PixelPos.y, 0, 0, BLUE); //!< Debug help line.
-  DrawText(Text.c_str(), PixelPos.x, PixelPos.y, FontSize, Col);
-};
-
-// ---
-// NOTE: Lamda to draw a point. Actually it draws a small circle.
-// ---
-auto ldaDrawPoint = [](Matrix const&  MhE2P,
-                       Vector4 const& Pos,
-                       Vector4 const& m2Pixel,
-                       bool           Print = false,
-                       Color          Col   = BLUE,
-                       float          Alpha = 1.f) -> void {
-  auto PixelPos = MhE2P * Pos;
-  DrawPixel(PixelPos.x, PixelPos.y, ColorAlpha(RED, Alpha));
-  constexpr float Radius = 0.01f;
-  DrawCircleLines(PixelPos.x, PixelPos.y, Radius * m2Pixel.x, ColorAlpha(Col, Alpha));
-  if (Print) {
-    DrawLine(PixelPos.x, PixelPos.y, 0, 0, BLUE);
-    DrawText(std::string("CurvePoint x/y: " + std::to_string(PixelPos.x) + " / " + std::to_string(PixelPos.y)).c_str(),
-             140,
-             70,
-             20,
-             BLUE);
-  }
+  fluffy::render::Text(R, Text.c_str(), int(PixelPos.x), int(PixelPos.y), FontSize, Col);
 };
 
 #if 0
 // ---
 // NOTE: Lamda to draw a point. Actually it draws a small circle.
 // ---
-auto ldaDrawPixel = [](Matrix const&  MhE2P,
-                       Vector4 const& Pos,
-                       Vector4 const& m2Pixel,
-                       bool           Print = false,
-                       Color          Col   = BLUE,
-                       float          Alpha = 1.f) -> void {
-  auto PixelPos = MhE2P * Pos;
+auto ldaDrawPixel = [](es::affine2 const& E2P,
+                       Vector4 const&     Pos,
+                       Vector4 const&     m2Pixel,
+                       bool               Print = false,
+                       Color              Col   = BLUE,
+                       float              Alpha = 1.f) -> void {
+  auto PixelPos = E2P * Pos;
   // DrawPixel(PixelPos.x, PixelPos.y, ColorAlpha(Col, Alpha));
   DrawPixel(PixelPos.x, PixelPos.y, Col);
 };
@@ -381,68 +517,280 @@ auto ldaDrawPixel = [](Matrix const&  MhE2P,
 /**
  * Draw a circle with Radius - go figure.
  */
-auto ldaDrawCircle = [](Matrix const& MhE2P, Vector4 const& Centre, float Radius, Color Col = BLUE) -> void {
-  auto CurvePoint = MhE2P * Centre;
-  // Use MhE2P.m5 for scaling/zoom factor.
-  DrawCircleLines(CurvePoint.x, CurvePoint.y, Radius * MhE2P.m5, Fade(Col, 0.9f));
+auto ldaDrawCircle = [](fluffy::render::backend& R,
+                        es::affine2 const&       E2P,
+                        Vector4 const&           Centre,
+                        float                    Radius,
+                        Color                    Col = BLUE) -> void {
+  if (!es::Intersects(VisibleEng(R, E2P), CircleBounds(Centre, Radius)))
+    return;
+
+  auto CurvePoint = E2P * Centre;
+  // Use the y scale for scaling/zoom factor.
+  fluffy::render::CircleLines(R, CurvePoint.x, CurvePoint.y, Radius * E2P.Scale.y, Fade(Col, 0.9f));
 };
 
 /**
  * Draw a circle with Radius - filled gradient version.
  */
-auto ldaDrawCircleG = [](Matrix const& MhE2P, Vector4 const& Centre, float Radius, Color Col = BLUE) -> void {
-  auto CurvePoint = MhE2P * Centre;
-  // Use MhE2P.m5 for scaling/zoom factor.
-  DrawCircleGradient(CurvePoint.x, CurvePoint.y, Radius * MhE2P.m5, Fade(Col, 0.3f), Col);
+auto ldaDrawCircleG = [](fluffy::render::backend& R,
+                         es::affine2 const&       E2P,
+                         Vector4 const&           Centre,
+                         float                    Radius,
+                         Color                    Col = BLUE) -> void {
+  if (!es::Intersects(VisibleEng(R, E2P), CircleBounds(Centre, Radius)))
+    return;
+
+  auto CurvePoint = E2P * Centre;
+  // Use the y scale for scaling/zoom factor.
+  fluffy::render::CircleGradient(R, CurvePoint.x, CurvePoint.y, Radius * E2P.Scale.y, Fade(Col, 0.3f), Col);
 };
 
 /**
  * Function to draw a line between two points.
  */
-auto ldaDrawLine = [](Matrix const& MhE2P, Vector4 const& From, Vector4 const& To, Color Col = BLUE) -> void {
-  auto F = MhE2P * From;
-  auto T = MhE2P * To;
-  DrawLine(F.x, F.y, T.x, T.y, BLUE);
+auto ldaDrawLine = [](fluffy::render::backend& R,
+                      es::affine2 const&       E2P,
+                      Vector4 const&           From,
+                      Vector4 const&           To,
+                      Color                    Col = BLUE) -> void {
+  if (!es::Intersects(VisibleEng(R, E2P), es::Bounds(From.x, From.y, To.x, To.y)))
+    return;
+
+  auto F = E2P * From;
+  auto T = E2P * To;
+  fluffy::render::Line(R, F.x, F.y, T.x, T.y, BLUE);
 };
 
 /**
- * Function to show the grid.
+ * Draw the points of a trail as small squares, all of them in one batch so that they go to
+ * the GPU together. The oldest NumOld points get ColOld and the rest Col. With Fade the alpha
+ * goes up from the oldest point to the newest.
  */
-auto ldaShowGrid = [](data* pData) -> void {
-  for (size_t Idx = 0; Idx < pData->GridCfg.vGridLines.size(); Idx += 2) {
-    auto const& Elem0 = pData->GridCfg.vGridLines[Idx];
-    auto const& Elem1 = pData->GridCfg.vGridLines[Idx + 1];
+auto DrawTrailPoints(fluffy::render::backend&    R,
+                     fluffy::trend::pixel_trail& Trail,
+                     float                       HalfSize,
+                     Color                       Col,
+                     Color                       ColOld = RED,
+                     size_t                      NumOld = 0,
+                     bool                        Fade   = false) -> void {
+  fluffy::perf::region PerfRegion{"curves.drawtrailpoints"};
+
+  auto const Alpha = Trail.AlphaRamp();
+  auto const H     = std::max(HalfSize, 1.f);
+
+  fluffy::render::BeginSquares(R);
+  Trail.ForEach([&](size_t Idx, float X, float Y) {
+    auto C = Idx < NumOld ? ColOld : Col;
+    if (Fade)
+      C.a = uint8_t(Alpha[Idx] * C.a / 255);
+    fluffy::render::AddSquare(R, X, Y, H, C);
+  });
+  fluffy::render::EndSquares(R);
+}
+
+/**
+ * Draw a trail as lines between the points in one batch. There is no line across the points
+ * that were culled, nor where x goes back, that is where a sweep starts again from the left.
+ */
+auto DrawTrailLines(fluffy::render::backend& R, fluffy::trend::pixel_trail const& Trail, Color Col) -> void {
+  fluffy::render::BeginLines(R);
+  Trail.ForEachLine([&](fluffy::trend::trail_point const& From, fluffy::trend::trail_point const& To) {
+    if (To.X >= From.X)
+      fluffy::render::AddLine(R, From.X, From.Y, To.X, To.Y, Col);
+  });
+  fluffy::render::EndLines(R);
+}
+
+/**
+ * Start one producer thread per live channel. The producers simulate signals sampled at
+ * LiveSampleRate and push them in batches of one millisecond, sweeping x over the grid
+ * as it is when they start.
+ */
+auto StartTrendProducers(data* pData) -> void {
+  constexpr size_t BatchSize  = size_t(LiveSampleRate / 1000.);
+  constexpr double SweepTime  = 1.;  //!< Seconds to sweep the grid from left to right.
+  constexpr double SignalFreq = 3.;  //!< Hz.
+  constexpr size_t QueueCap   = size_t(LiveSampleRate / 4.);
+  constexpr size_t TrendCap   = size_t(LiveSampleRate * SweepTime);
+
+  auto& LiveTrends = pData->LiveTrends;
+  if (LiveTrends.vChannels.empty()) {
+    fluffy::trend::AddChannel(LiveTrends, "sine", QueueCap, TrendCap);
+    fluffy::trend::AddChannel(LiveTrends, "square", QueueCap, TrendCap);
+  }
+
+  // ---
+  // NOTE: The producers are stopped, so whatever is left in the queues is from the last run.
+  // ---
+  for (auto& upChannel : LiveTrends.vChannels) {
+    upChannel->Queue.PopInto(upChannel->Trend);
+    upChannel->Trend.Clear();
+    upChannel->NumDropped = 0;
+  }
 
-    DrawLine(Elem0.X, Elem0.Y, Elem1.X, Elem1.Y, Fade(Elem0.color, 0.3f));
+  auto ldaProduce = [](fluffy::trend::channel* pChannel,
+                       std::atomic<bool>*      pRun,
+                       size_t                  ChannelIdx,
+                       float                   Width,
+                       float                   Height) -> void {
+    std::array<float, BatchSize> aX{};
+    std::array<float, BatchSize> aY{};
+    uint64_t                     Sample{};
+    auto const                   Offset = (0 == ChannelIdx ? 1.f : -1.f) * Height / 4.f;
+    auto                         Next   = std::chrono::steady_clock::now();
+
+    while (pRun->load(std::memory_order_relaxed)) {
+      for (size_t Idx = 0; Idx < BatchSize; ++Idx, ++Sample) {
+        auto const t     = double(Sample) / LiveSampleRate;
+        auto const Sweep = std::fmod(t, SweepTime) / SweepTime;
+        auto const Sine  = std::sin(2. * M_PI * SignalFreq * t);
+        auto const Value = 0 == ChannelIdx ? Sine : (Sine < 0. ? -1. : 1.);
+        aX[Idx]          = float((Sweep - 0.5) * Width);
+        aY[Idx]          = Offset + float(Value) * Height / 8.f;
+      }
+      auto const NumPushed = pChannel->Queue.Push(aX, aY);
+      pChannel->NumDropped.fetch_add(BatchSize - NumPushed, std::memory_order_relaxed);
 
-    if (!Elem0.TxtTagX.empty())
-      DrawText(Elem0.TxtTagX.c_str(), Elem0.X - 1, Elem0.Y + 8, 10, DARKGRAY);
+      Next += std::chrono::milliseconds(1);
+      std::this_thread::sleep_until(Next);
+    }
+  };
 
-    if (!Elem0.TxtTagY.empty())
-      DrawText(Elem0.TxtTagY.c_str(), Elem0.X - 20, Elem0.Y - 10, 10, DARKGRAY);
+  pData->RunTrendProducers = true;
+  for (size_t Idx = 0; Idx < LiveTrends.vChannels.size(); ++Idx) {
+    pData->vTrendProducers.push_back(std::thread(ldaProduce,
+                                                 LiveTrends.vChannels[Idx].get(),
+                                                 &pData->RunTrendProducers,
+                                                 Idx,
+                                                 pData->GridCfg.GridDimensions.x,
+                                                 pData->GridCfg.GridDimensions.y));
   }
+}
+
+auto StopTrendProducers(data* pData) -> void {
+  pData->RunTrendProducers = false;
+  for (auto& Producer : pData->vTrendProducers)
+    Producer.join();
+  pData->vTrendProducers.clear();
+}
+
+/**
+ * Move what the producers have pushed since the last frame into the trends, and draw each
+ * channel as a line.
+ */
+auto DrawLiveTrends(data* pData) -> void {
+  if (pData->vTrendProducers.empty())
+    return;
+
+  fluffy::perf::region PerfRegion{"curves.livetrends"};
+
+  fluffy::trend::DrainAll(pData->LiveTrends);
+
+  constexpr std::array<Color, 2> aColors{DARKGREEN, MAROON};
+  auto const                     E2P         = Eng2Pixel(pData);
+  auto const                     Visible     = VisibleEng(pData);
+  auto const                     NumChannels = pData->LiveTrends.vChannels.size();
+  pData->vLivePixels.resize(NumChannels, fluffy::trend::pixel_trail{.Tolerance = TrailTolerance});
+  for (size_t ChannelIdx = 0; ChannelIdx < NumChannels; ++ChannelIdx) {
+    auto const& Channel = *pData->LiveTrends.vChannels[ChannelIdx];
+    auto const  Col     = aColors[ChannelIdx % aColors.size()];
+    auto&       Trail   = pData->vLivePixels[ChannelIdx];
+
+    Trail.Update(Channel.Trend, E2P, Visible);
+    DrawTrailLines(pData->Render, Trail, Col);
+
+    auto const NumDropped = Channel.NumDropped.load(std::memory_order_relaxed);
+    fluffy::render::Text(pData->Render,
+                         std::string(Channel.Name + " dropped: " + std::to_string(NumDropped)).c_str(),
+                         pData->screenWidth - 260,
+                         40 + 20 * int(ChannelIdx),
+                         18,
+                         Col);
+  }
+}
+
+/**
+ * Function to show the grid. All the lines go in one batch, and the labels are glyphs from
+ * the font atlas, so that they batch too.
+ */
+auto ldaShowGrid = [](data* pData) -> void {
+  auto&       R       = pData->Render;
+  auto const& GridCfg = pData->GridCfg;
+  auto const& vLines  = GridCfg.vLineVertices;
+  auto const  Major   = Fade(DARKGRAY, 0.3f);
+  auto const  Minor   = Fade(LIGHTGRAY, 0.3f);
+
+  fluffy::render::BeginLines(R);
+  for (size_t Idx = 0; Idx < vLines.size() / 4; ++Idx) {
+    auto const* pV = &vLines[4 * Idx];
+    fluffy::render::AddLine(R, pV[0], pV[1], pV[2], pV[3], Idx < GridCfg.NumMajorLines ? Major : Minor);
+  }
+  fluffy::render::EndLines(R);
+
+  constexpr float FontSize = 10.f;
+  for (auto const& Label : GridCfg.vLabels)
+    fluffy::render::Glyphs(R, Label.X, Label.Y, std::span(Label.aGlyph.data(), Label.NumGlyphs), FontSize, DARKGRAY);
 };
 
 /**
- * Forward declarations.
+ * Pixels per unit of the fractal.
  */
-auto UpdateDrawFrameFourier(data* pData) -> void;
-auto UpdateDrawFrameFractal(data* pData) -> void;
-auto UpdateDrawFrameAsteroid(data* pData) -> void;
-auto UpdateDrawFrame3D(data* pData) -> void;
-auto UpdateDrawFrameHelp(data* pData) -> void;
+auto FractalResolution(data* pData) -> es::vector4_double {
+  auto const E2P = Eng2Pixel(pData);
+  return es::VectorDouble(E2P.Scale.x, E2P.Scale.y, 0.);
+}
+
+/**
+ * Render the fractal of FC with its mode into FC.iMage. Uses nothing but the arguments, so
+ * that it can run on a copy on another thread.
+ */
+auto RenderFractalImage(fluffy::fractal::config&  FC,
+                        currob::grid_cfg const&   GridCfg,
+                        es::vector4_double const& Resolution) -> void {
+  if (fluffy::fractal::render_mode::EscapeTime == FC.Mode) {
+    fluffy::fractal::CreateFractalPixelSpace(GridCfg, FC.PixelCanvas, Resolution, FC.Constant, FC.iMage);
+  } else if (fluffy::fractal::render_mode::InverseIteration == FC.Mode) {
+    fluffy::fractal::CreateInverseIterationPixelSpace(
+        GridCfg, FC.PixelCanvas, Resolution, FC.Constant, FC.Miim, FC.iMage);
+  } else {
+    fluffy::fractal::CreateDensityPixelSpace(GridCfg, FC.PixelCanvas, Resolution, FC.Mode, FC.Density, FC.iMage);
+  }
+}
+
+/**
+ * Upload the fractal image as the fractal texture.
+ */
+auto UploadFractalTexture(data* pData) -> void {
+  auto& FC = pData->FractalConfig;
+  if (FC.iMage.data) {
+    if (pData->FractalTexture.id)
+      UnloadTexture(pData->FractalTexture);
+    pData->FractalTexture = LoadTextureFromImage(FC.iMage);
+  }
+}
+
+/**
+ * Render the fractal with the current mode and upload it as the fractal texture.
+ */
+auto RenderFractalTexture(data* pData) -> void {
+  RenderFractalImage(pData->FractalConfig, pData->GridCfg, FractalResolution(pData));
+  UploadFractalTexture(pData);
+}
 
 /**
  * Keyboard input handling common to all the drawing routines.
  */
 auto HandleInput(data* pData) -> bool {
 
-  auto const MousePos = GetMousePosition();
-  pData->MousePosEng  = pData->MhE2PInv * es::Point(MousePos.x, MousePos.y, 0.f);
-  pData->MousePosGrid = pData->MhG2E * pData->MousePosEng;
+  auto const MousePos  = GetMousePosition();
+  auto const MousePix  = es::PointDouble(MousePos.x, MousePos.y, 0.);
+  pData->MousePosEng  = es::WorldInv(pData->Frames, pData->FrameEng) * MousePix;
+  pData->MousePosGrid = es::WorldInv(pData->Frames, pData->FrameGrid) * MousePix;
   ldaDrawText(
-      pData->MhE2P,
-      pData->MousePosGrid,
+      pData->Render,
+      Eng2Pixel(pData),
+      es::ToVector4(pData->MousePosGrid),
       std::string("   " + std::to_string(pData->MousePosGrid.x) + " " + std::to_string(pData->MousePosGrid.y)).c_str(),
       20,
       WHITE);
@@ -452,15 +800,16 @@ auto HandleInput(data* pData) -> bool {
   pData->MouseInput.MouseButtonPressed  = IsMouseButtonPressed(0);
   pData->MouseInput.MouseButtonReleased = IsMouseButtonReleased(0);
 
-  DrawText(std::string("Use arrow keys. Zoom: " + std::to_string(pData->vPixelsPerUnit.x) +
-                       ". n :" + std::to_string(pData->n) + ". Mouse: " + std::to_string(MousePos.x) + " " +
-                       std::to_string(MousePos.y) + ". Mouse Eng: " + std::to_string(pData->MousePosEng.x) + " " +
-                       std::to_string(pData->MousePosEng.y))
-               .c_str(),
-           140,
-           10,
-           20,
-           WHITE);
+  fluffy::render::Text(pData->Render,
+                       std::string("Use arrow keys. Zoom: " + std::to_string(pData->vPixelsPerUnit.x) +
+                                   ". n :" + std::to_string(pData->n) + ". Mouse: " + std::to_string(MousePos.x) +
+                                   " " + std::to_string(MousePos.y) + ". Mouse Eng: " +
+                                   std::to_string(pData->MousePosEng.x) + " " + std::to_string(pData->MousePosEng.y))
+                           .c_str(),
+                       140,
+                       10,
+                       20,
+                       WHITE);
 
   bool InputChanged{};
 
@@ -518,29 +867,32 @@ auto HandleInput(data* pData) -> bool {
       }
       InputChanged = true;
     } else if (KEY_A == pData->Key) {
-      pData->UpdateDrawFramePointer = &UpdateDrawFrameAsteroid;
-      pData->vPixelsPerUnit         = es::Vector(100.f, 100.f, 100.f);
-      InputChanged                  = true;
+      pData->Selected       = data::pages::PageAsteroid;
+      pData->vPixelsPerUnit = es::Vector(100.f, 100.f, 100.f);
+      InputChanged          = true;
     } else if (KEY_D == pData->Key) {
-      pData->UpdateDrawFramePointer = &UpdateDrawFrame3D;
-      pData->vPixelsPerUnit         = es::Vector(100.f, 100.f, 100.f);
-      InputChanged                  = true;
+      pData->Selected       = data::pages::Page3D;
+      pData->vPixelsPerUnit = es::Vector(100.f, 100.f, 100.f);
+      InputChanged          = true;
     } else if (KEY_F == pData->Key) {
-      pData->UpdateDrawFramePointer = &UpdateDrawFrameFourier;
-      pData->vPixelsPerUnit         = es::Vector(100.f, 100.f, 100.f);
-      InputChanged                  = true;
+      pData->Selected       = data::pages::PageFourier;
+      pData->vPixelsPerUnit = es::Vector(100.f, 100.f, 100.f);
+      InputChanged          = true;
     } else if (KEY_R == pData->Key) {
-      pData->UpdateDrawFramePointer = &UpdateDrawFrameFractal;
-      pData->NumTrendPoints         = 0;
-      pData->CurrentTrendPoint      = 0;
-      pData->vPixelsPerUnit         = es::Vector(100.f, 100.f, 100.f);
-      InputChanged                  = true;
+      pData->Selected       = data::pages::PageFractal;
+      pData->vPixelsPerUnit = es::Vector(100.f, 100.f, 100.f);
+      InputChanged          = true;
+    } else if (KEY_T == pData->Key) {
+      if (pData->vTrendProducers.empty())
+        StartTrendProducers(pData);
+      else
+        StopTrendProducers(pData);
     } else if (KEY_L == pData->Key) {
       if (!pData->WikipediaLink.empty())
         OpenURL(pData->WikipediaLink.c_str());
     } else if (KEY_F1 == pData->Key) {
-      pData->UpdateDrawFramePointer = &UpdateDrawFrameHelp;
-      InputChanged                  = true;
+      pData->Selected = data::pages::PageHelp;
+      InputChanged    = true;
     } else if (KEY_F2 == pData->Key) {
       pData->TakeScreenshot = true;
     } else if (data::pages::PageFractal == pData->PageNum) {
@@ -559,6 +911,15 @@ auto HandleInput(data* pData) -> bool {
       } else if (KEY_F10 == pData->Key) {
         pData->FractalConfig.Constant.y += 0.01f;
         InputChanged = true;
+      } else if (KEY_F4 == pData->Key) {
+        auto& Quality = pData->FractalConfig.PixelCanvas.Quality;
+        Quality       = fluffy::fractal::render_quality::Single == Quality ? fluffy::fractal::render_quality::Adaptive
+                                                                           : fluffy::fractal::render_quality::Single;
+        InputChanged  = true;
+      } else if (KEY_F5 == pData->Key) {
+        auto const NumModes       = int(fluffy::fractal::render_mode::NumModes);
+        pData->FractalConfig.Mode = fluffy::fractal::render_mode((int(pData->FractalConfig.Mode) + 1) % NumModes);
+        InputChanged              = true;
       }
     }
 
@@ -566,17 +927,18 @@ auto HandleInput(data* pData) -> bool {
   }
 
   if (InputChanged) {
-    pData->Xcalc             = 0.0;
-    pData->CurrentTrendPoint = 0;
+    pData->Xcalc         = 0.0;
+    pData->TrendLapStart = 0;
+    pData->Trend.Clear();
 
-    pData->MhE2P = InitEng2PixelMatrix(
+    auto const MhE2P = InitEng2Pixel(
         pData->vEngOffset, pData->vPixelsPerUnit, {pData->screenWidth / 2.f, pData->screenHeight / 2.f, 0.f, 0.f});
-    pData->MhE2PInv = MatrixInvert(pData->MhE2P);
+    es::SetLocal(pData->Frames, pData->FrameEng, MhE2P);
 
     pData->GridCfg.GridDimensions.x = pData->GridCfg.GridDimensions.x * PixelPerUnitPrv.x / pData->vPixelsPerUnit.x;
     pData->GridCfg.GridDimensions.y = pData->GridCfg.GridDimensions.y * PixelPerUnitPrv.y / pData->vPixelsPerUnit.y;
 
-    pData->GridCfg = GridCfgInPixels(pData->MhE2P, pData->GridCfg);
+    pData->GridCfg = GridCfgInPixels(pData->Render, Eng2Pixel(pData), pData->GridCfg);
   }
 
   if (data::pages::PageFractal == pData->PageNum && (InputChanged || pData->FractalConfig.AutoIncrement)) {
@@ -599,14 +961,7 @@ auto HandleInput(data* pData) -> bool {
       }
     }
 
-    fluffy::fractal::CreateFractalPixelSpace(pData->GridCfg,
-                                             pData->FractalConfig.PixelCanvas,
-                                             {pData->MhE2P.m0, pData->MhE2P.m5, 0.f, 0.f},
-                                             pData->FractalConfig.Constant,
-                                             pData->FractalConfig.iMage);
-    if (pData->FractalConfig.iMage.data) {
-      pData->FractalTexture = LoadTextureFromImage(pData->FractalConfig.iMage);
-    }
+    RenderFractalTexture(pData);
   }
 
   // ---
@@ -615,7 +970,7 @@ auto HandleInput(data* pData) -> bool {
   if (false && pData->MouseInput.MouseButtonReleased) {
     pData->GridCfg.GridCenterValue.x = pData->MousePosEng.x;
     pData->GridCfg.GridCenterValue.y = pData->MousePosEng.y;
-    pData->GridCfg                   = GridCfgInPixels(pData->MhE2P, pData->GridCfg);
+    pData->GridCfg                   = GridCfgInPixels(pData->Render, Eng2Pixel(pData), pData->GridCfg);
   }
 
   return InputChanged;
@@ -632,19 +987,21 @@ auto UpdateDrawFrameFourier(data* pData) -> void {
     pData->PageNum        = data::pages::PageFourier;
   }
 
-  BeginDrawing();
-  ClearBackground(RAYWHITE);
+  fluffy::render::BeginFrame(pData->Render);
+  fluffy::render::Clear(pData->Render, RAYWHITE);
 
-  DrawText(std::string("Num terms: " + std::to_string(pData->n) + ". Key:" + std::to_string(pData->KeyPrv) +
-                       ". Time:" + std::to_string(pData->Xcalc))
-               .c_str(),
-           140,
-           40,
-           20,
-           BLUE);
+  fluffy::render::Text(pData->Render,
+                       std::string("Num terms: " + std::to_string(pData->n) + ". Key:" +
+                                   std::to_string(pData->KeyPrv) + ". Time:" + std::to_string(pData->Xcalc))
+                           .c_str(),
+                       140,
+                       40,
+                       20,
+                       BLUE);
 
   {
-    ldaDrawText(pData->MhE2P,
+    ldaDrawText(pData->Render,
+                Eng2Pixel(pData),
                 es::Point(pData->GridCfg.GridScreenCentre.x - pData->GridCfg.GridDimensions.x / 2.f,
                           -(pData->GridCfg.GridDimensions.y / 2.f * 1.05f),
                           0.f),
@@ -660,7 +1017,7 @@ auto UpdateDrawFrameFourier(data* pData) -> void {
     if (pData->MousePosEng.x > BoxPosition.x && pData->MousePosEng.x < (BoxPosition.x + BoxDimension.x) &&
         pData->MousePosEng.y > BoxPosition.y && pData->MousePosEng.y < (BoxPosition.y + BoxDimension.y)) {
 
-      ldaDrawBox(pData->MhE2P, BoxPosition, BoxDimension);
+      ldaDrawBox(pData->Render, Eng2Pixel(pData), BoxPosition, BoxDimension);
 
       if (pData->MouseInput.MouseButtonReleased)
         if (!pData->WikipediaLink.empty())
@@ -677,17 +1034,16 @@ auto UpdateDrawFrameFourier(data* pData) -> void {
     ldaShowGrid(pData);
   }
 
-  auto const Frequency = 2.0;
-  auto const Omegat    = M_2_PI * Frequency * pData->t;
-  auto const Radius    = 4.f / M_PI;
+  auto const Omegat = FourierOmegat(pData->t);
+  auto const Radius = FourierRadius;
   auto Centre = es::Point(pData->GridCfg.GridScreenCentre.x - pData->GridCfg.GridDimensions.x / 2.f - Radius, 0.f, 0.f);
 
   auto Ft = Centre + es::Vector(Radius * cosf(Omegat), Radius * sinf(Omegat), 0.f);
 
-  ldaDrawCircle(pData->MhE2P, Centre, Radius);
+  ldaDrawCircle(pData->Render, Eng2Pixel(pData), Centre, Radius);
 
   // Draw the outer circle line
-  ldaDrawLine(pData->MhE2P, Centre, Ft);
+  ldaDrawLine(pData->Render, Eng2Pixel(pData), Centre, Ft);
 
   // ---
   // Create the Fourier series.
@@ -697,42 +1053,31 @@ auto UpdateDrawFrameFourier(data* pData) -> void {
     auto nthTerm = 1.f + Idx * 2.f;
     auto Ftn =
         Ftp + es::Vector(Radius / nthTerm * cosf(nthTerm * Omegat), Radius / nthTerm * sinf(nthTerm * Omegat), 0.f);
-    ldaDrawLine(pData->MhE2P, Ftp, Ftn);
-    ldaDrawCircle(pData->MhE2P, Ftn, Radius / nthTerm);
+    ldaDrawLine(pData->Render, Eng2Pixel(pData), Ftp, Ftn);
+    ldaDrawCircle(pData->Render, Eng2Pixel(pData), Ftn, Radius / nthTerm);
     Ftp = Ftn;
   }
 
-  auto GridStart = es::Point(0.f, 0.f, 0.f);
-  pData->Xcalc += pData->dt;
-
   // ---
-  // NOTE: Reset X value axis plots
+  // NOTE: The trend is pushed by StepFourier, the pen is drawn between the last two steps.
   // ---
+  auto const GridStart = es::Point(0.f, 0.f, 0.f);
   auto const GridRight = pData->GridCfg.GridScreenCentre.x + pData->GridCfg.GridDimensions.x / 2.f;
-
-  if (pData->Xcalc > GridRight) {
-    auto const GridLeft      = -GridRight;
-    pData->Xcalc             = GridLeft;
-    pData->CurrentTrendPoint = 0;
-  }
-
-  auto AnimationPoint = GridStart + es::Vector(pData->Xcalc, Ftp.y, 0.f);
+  auto const Behind    = float((1. - fluffy::sim::Alpha(pData->Clock)) * pData->Clock.Step);
+  auto AnimationPoint  = GridStart + es::Vector(std::max(pData->Xcalc - Behind, -GridRight), Ftp.y, 0.f);
 
   // Draw the actual trend
-  pData->vTrendPoints[pData->CurrentTrendPoint] = (AnimationPoint);
-
-  for (size_t Idx = 0; Idx < pData->CurrentTrendPoint; ++Idx) {
-    ldaDrawPoint(pData->MhE2P, pData->vTrendPoints[Idx], {pData->MhE2P.m0, pData->MhE2P.m5, 0.f, 0.f});
-  }
+  auto const E2P = Eng2Pixel(pData);
+  pData->TrendPixels.Update(pData->Trend, E2P, VisibleEng(pData));
+  DrawTrailPoints(pData->Render, pData->TrendPixels, TrendPointRadius * E2P.Scale.x, BLUE);
+  DrawLiveTrends(pData);
 
   // Draw the inner circle line
-  ldaDrawLine(pData->MhE2P, Ft, Ftp);
+  ldaDrawLine(pData->Render, Eng2Pixel(pData), Ft, Ftp);
   // Draw the connecting line
-  ldaDrawLine(pData->MhE2P, Ftp, AnimationPoint);
+  ldaDrawLine(pData->Render, Eng2Pixel(pData), Ftp, AnimationPoint);
 
-  ++pData->CurrentTrendPoint;
-
-  EndDrawing();
+  fluffy::render::EndFrame(pData->Render);
 
   if (pData->TakeScreenshot) {
     pData->TakeScreenshot = false;
@@ -751,21 +1096,26 @@ auto UpdateDrawFrameFractal(data* pData) -> void {
     pData->PageNum       = data::pages::PageFractal;
   }
 
-  BeginDrawing();
-  ClearBackground(BLACK);
+  fluffy::render::BeginFrame(pData->Render);
+  fluffy::render::Clear(pData->Render, BLACK);
 
   // ---
   // NOTE: Render the fractal.
   {
     // fluffy::fractal::Render(es::Vector(800.f, 600.f, 0.f), pData->FractalConfig.Constant);
-    auto const PixPosStrt =
-        pData->MhE2P * es::Point(-pData->GridCfg.GridDimensions.x / 2.f, pData->GridCfg.GridDimensions.y / 2.f, 0.f);
-    DrawTexture(pData->FractalTexture, PixPosStrt.x, PixPosStrt.y, WHITE);
+    auto const& GridD      = pData->GridCfg.GridDimensions;
+    auto const  PixPosStrt = Eng2Pixel(pData) * es::Point(-GridD.x / 2.f, GridD.y / 2.f, 0.f);
+    auto const& Canvas     = pData->FractalConfig.PixelCanvas;
+    DrawTextureRec(pData->FractalTexture,
+                   Rectangle{0.f, 0.f, Canvas.Dimension.x, Canvas.Dimension.y},
+                   Vector2{PixPosStrt.x, PixPosStrt.y},
+                   WHITE);
 
     // ---
     // NOTE: Draw the text describing the fractal constant.
     // ---
-    ldaDrawText(pData->MhE2P,
+    ldaDrawText(pData->Render,
+                Eng2Pixel(pData),
                 es::Point(pData->GridCfg.GridScreenCentre.x - pData->GridCfg.GridDimensions.x / 2.f,
                           -(pData->GridCfg.GridDimensions.y / 2.f * 0.85f),
                           0.f),
@@ -779,7 +1129,8 @@ auto UpdateDrawFrameFractal(data* pData) -> void {
     // ---
     // NOTE: Draw the text for the WikipediaLink.
     // ---
-    ldaDrawText(pData->MhE2P,
+    ldaDrawText(pData->Render,
+                Eng2Pixel(pData),
                 es::Point(pData->GridCfg.GridScreenCentre.x - pData->GridCfg.GridDimensions.x / 2.f,
                           -(pData->GridCfg.GridDimensions.y / 2.f * 1.05f),
                           0.f),
@@ -795,7 +1146,7 @@ auto UpdateDrawFrameFractal(data* pData) -> void {
     if (pData->MousePosEng.x > BoxPosition.x && pData->MousePosEng.x < (BoxPosition.x + BoxDimension.x) &&
         pData->MousePosEng.y > BoxPosition.y && pData->MousePosEng.y < (BoxPosition.y + BoxDimension.y)) {
 
-      ldaDrawBox(pData->MhE2P, BoxPosition, BoxDimension);
+      ldaDrawBox(pData->Render, Eng2Pixel(pData), BoxPosition, BoxDimension);
 
       if (pData->MouseInput.MouseButtonReleased)
         if (!pData->WikipediaLink.empty())
@@ -812,28 +1163,24 @@ auto UpdateDrawFrameFractal(data* pData) -> void {
     auto const& GridD = pData->GridCfg.GridDimensions;
     auto const  GridP = GridC - GridD * (1.f / 2.f);
 
-    // ldaDrawBox(pData->MhE2P, es::Point(pData->MousePosEng.x, pData->MousePosEng.y, 0.f), GridD, RED);
+    // ldaDrawBox(Eng2Pixel(pData), es::Point(pData->MousePosEng.x, pData->MousePosEng.y, 0.f), GridD, RED);
 
     if (pData->MousePosEng.x > (GridP.x) && pData->MousePosEng.x < (GridP.x + GridD.x) &&
         pData->MousePosEng.y > (GridP.y) && pData->MousePosEng.y < (GridP.y + GridD.y)) {
 
-      ldaDrawBox(pData->MhE2P, GridP, GridD, ORANGE);
+      ldaDrawBox(pData->Render, Eng2Pixel(pData), GridP, GridD, ORANGE);
 
       if (pData->MouseInput.MouseButtonReleased) {
-        pData->GridCfg.GridCenterValue = pData->MousePosEng;
-        pData->MhG2E                   = es::SetTranslation(pData->GridCfg.GridCenterValue);
-        pData->MhG2EInv                = MatrixInvert(pData->MhG2E);
-        pData->GridCfg                 = GridCfgInPixels(pData->MhE2P, pData->GridCfg);
-
-        fluffy::fractal::CreateFractalPixelSpace(pData->GridCfg,
-                                                 pData->FractalConfig.PixelCanvas,
-                                                 {pData->MhE2P.m0, pData->MhE2P.m5, 0.f, 0.f},
-                                                 pData->FractalConfig.Constant,
-                                                 pData->FractalConfig.iMage);
-
-        if (pData->FractalConfig.iMage.data) {
-          pData->FractalTexture = LoadTextureFromImage(pData->FractalConfig.iMage);
-        }
+        // ---
+        // NOTE: The new centre is the grid value under the mouse, all in double.
+        // ---
+        pData->GridCfg.GridCenterValue = es::PointDouble(pData->MousePosGrid.x - GridC.x,
+                                                         pData->MousePosGrid.y - GridC.y,
+                                                         pData->MousePosGrid.z - GridC.z);
+        pData->GridCfg                 = GridCfgInPixels(pData->Render, Eng2Pixel(pData), pData->GridCfg);
+        es::SetLocal(pData->Frames, pData->FrameGrid, Grid2Eng(pData->GridCfg));
+
+        RenderFractalTexture(pData);
       }
     }
   }
@@ -847,7 +1194,7 @@ auto UpdateDrawFrameFractal(data* pData) -> void {
     ldaShowGrid(pData);
   }
 
-  EndDrawing();
+  fluffy::render::EndFrame(pData->Render);
 
   if (pData->TakeScreenshot) {
     pData->TakeScreenshot = false;
@@ -867,10 +1214,11 @@ auto UpdateDrawFrameAsteroid(data* pData) -> void {
     pData->PageNum       = data::pages::PageAsteroid;
   }
 
-  BeginDrawing();
-  ClearBackground(WHITE);
+  fluffy::render::BeginFrame(pData->Render);
+  fluffy::render::Clear(pData->Render, WHITE);
 
-  DrawText(
+  fluffy::render::Text(
+      pData->Render,
       std::string("Asteriode. Key:" + std::to_string(pData->KeyPrv) + ". Time:" + std::to_string(pData->Xcalc)).c_str(),
       140,
       40,
@@ -882,7 +1230,7 @@ auto UpdateDrawFrameAsteroid(data* pData) -> void {
                                   -(pData->GridCfg.GridDimensions.y / 2.f * 1.05f),
                                   0.f);
 
-    ldaDrawText(pData->MhE2P, PosTxt, pData->WikipediaLink, 20, GREEN, 0.7f, 0.05f);
+    ldaDrawText(pData->Render, Eng2Pixel(pData), PosTxt, pData->WikipediaLink, 20, GREEN, 0.7f, 0.05f);
 
     {
       auto const BoxPosition =
@@ -895,7 +1243,7 @@ auto UpdateDrawFrameAsteroid(data* pData) -> void {
       if (pData->MousePosEng.x > BoxPosition.x && pData->MousePosEng.x < (BoxPosition.x + BoxDimension.x) &&
           pData->MousePosEng.y > BoxPosition.y && pData->MousePosEng.y < (BoxPosition.y + BoxDimension.y)) {
 
-        ldaDrawBox(pData->MhE2P, BoxPosition, BoxDimension);
+        ldaDrawBox(pData->Render, Eng2Pixel(pData), BoxPosition, BoxDimension);
 
         if (pData->MouseInput.MouseButtonReleased)
           if (!pData->WikipediaLink.empty())
@@ -916,12 +1264,6 @@ auto UpdateDrawFrameAsteroid(data* pData) -> void {
   auto constexpr Radius = 1.f;
   auto const t          = pData->t;
 
-  // ---
-  // NOTE: The formula to compute the Asteroide.
-  // ---
-  auto const x = Radius / 4.f * (3.f * cos(t) + cos(3.f * t));
-  auto const y = Radius / 4.f * (3.f * sin(t) - sin(3.f * t));
-
   // ---
   // NOTE: Follow along the fixed circle.
   // ---
@@ -935,64 +1277,30 @@ auto UpdateDrawFrameAsteroid(data* pData) -> void {
   auto constexpr DotSize = 0.025f;
 
   // Draw the small circle.
-  ldaDrawCircle(pData->MhE2P, AnimationSmallCircle, Radius / 4.f);
-  ldaDrawCircleG(pData->MhE2P, AnimationSmallCircle, DotSize);
+  ldaDrawCircle(pData->Render, Eng2Pixel(pData), AnimationSmallCircle, Radius / 4.f);
+  ldaDrawCircleG(pData->Render, Eng2Pixel(pData), AnimationSmallCircle, DotSize);
 
   // Draw the fixed circle.
-  ldaDrawCircle(pData->MhE2P, GridStart, Radius);
+  ldaDrawCircle(pData->Render, Eng2Pixel(pData), GridStart, Radius);
 
-  pData->Xcalc += pData->dt;
+  auto AnimationPoint = GridStart + AsteroidOffset(Radius, t);
 
   // ---
-  // NOTE: Reset X value axis plots
+  // NOTE: The points fade in from the oldest to the newest. The points of the current
+  //       lap are blue and the rest of the previous lap red.
   // ---
-  if (pData->Xcalc > 2.f * M_PI) {
-    pData->Xcalc             = 0.f;
-    pData->CurrentTrendPoint = 0;
-  }
+  auto const E2P      = Eng2Pixel(pData);
+  auto const FirstLap = pData->Trend.NumPushed() - pData->Trend.Size(); //!< Push number of the oldest point.
+  auto const NumOld   = pData->TrendLapStart > FirstLap ? size_t(pData->TrendLapStart - FirstLap) : size_t(0);
+  pData->TrendPixels.Update(pData->Trend, E2P, VisibleEng(pData));
+  DrawTrailPoints(pData->Render, pData->TrendPixels, TrendPointRadius * E2P.Scale.x, BLUE, RED, NumOld, true);
 
-  auto AnimationPoint = GridStart + es::Vector(x, y, 0.f);
+  DrawLiveTrends(pData);
 
-  // Draw the actual trend
-  pData->vTrendPoints[pData->CurrentTrendPoint] = AnimationPoint;
+  ldaDrawLine(pData->Render, Eng2Pixel(pData), AnimationPoint, AnimationSmallCircle);
+  ldaDrawCircleG(pData->Render, Eng2Pixel(pData), AnimationPoint, DotSize, ORANGE);
 
-  for (size_t Idx = 0; Idx < std::min(pData->vTrendPoints.size(), pData->NumTrendPoints); ++Idx) {
-
-    // ---
-    // NOTE: Compute the Alpha channel.
-    // Split into two sections.
-    // a: From CurrentTrendPoint+1 to NumTrendPoints.
-    // b: From 0 to CurrentTrendPoint.
-    //    90    180  270  360
-    // ----|----|----|----|----|
-    //       ^
-    //       CurrentTrendPoint
-    //       t0
-    auto Alpha = 0.f;
-    auto t0    = 0.f;
-    if (Idx < pData->CurrentTrendPoint) { //!< segment a
-      t0 = float(pData->NumTrendPoints - pData->CurrentTrendPoint) / float(pData->NumTrendPoints);
-    } else { //!< segment b -> do nothing
-    }
-    auto const t = float(Idx) / float(pData->NumTrendPoints) + t0;
-    Alpha        = es::Lerp(es::Vector(0.f, 0.f, 0.f), es::Vector(1.f, 0.f, 0.f), t).x;
-
-    ldaDrawPoint(pData->MhE2P,
-                 pData->vTrendPoints[Idx],
-                 {pData->MhE2P.m0, pData->MhE2P.m5, 0.f, 0.f},
-                 false,
-                 Idx < pData->CurrentTrendPoint ? BLUE : RED,
-                 Alpha);
-  }
-
-  ldaDrawLine(pData->MhE2P, AnimationPoint, AnimationSmallCircle);
-  ldaDrawCircleG(pData->MhE2P, AnimationPoint, DotSize, ORANGE);
-
-  ++pData->CurrentTrendPoint;
-
-  pData->NumTrendPoints = std::max(pData->CurrentTrendPoint, pData->NumTrendPoints);
-
-  EndDrawing();
+  fluffy::render::EndFrame(pData->Render);
 
   if (pData->TakeScreenshot) {
     pData->TakeScreenshot = false;
@@ -1035,6 +1343,28 @@ auto UpdateDrawFrame3D(data* pData) -> void {
   if (IsKeyDown('Z'))
     pData->Camera.target = (Vector3){0.0f, 0.0f, 0.0f};
 
+  if (IsKeyPressed(KEY_Q))
+    pData->ShowQuatJulia = !pData->ShowQuatJulia;
+
+  // ---
+  // NOTE: Ray-march the quaternion Julia set at reduced resolution with the same camera,
+  //       and scale it up to the screen.
+  // ---
+  constexpr int QuatJuliaWidth = 640;
+  if (pData->ShowQuatJulia) {
+    auto const Height = QuatJuliaWidth * pData->screenHeight / pData->screenWidth;
+    auto const Start  = GetTime();
+    if (!pData->QuatJuliaImage.data) {
+      pData->QuatJuliaImage   = fluffy::quatjulia::GenImageQuatJulia(pData->QuatJulia, camera, QuatJuliaWidth, Height);
+      pData->QuatJuliaTexture = LoadTextureFromImage(pData->QuatJuliaImage);
+    } else {
+      fluffy::quatjulia::RenderQuatJulia(
+          pData->QuatJulia, camera, QuatJuliaWidth, Height, static_cast<Color*>(pData->QuatJuliaImage.data));
+      UpdateTexture(pData->QuatJuliaTexture, pData->QuatJuliaImage.data);
+    }
+    pData->QuatJuliaTime = GetTime() - Start;
+  }
+
   BeginDrawing();
   ClearBackground(WHITE);
   BeginMode3D(camera);
@@ -1074,8 +1404,13 @@ auto UpdateDrawFrame3D(data* pData) -> void {
 
   EndMode3D();
 
-  DrawRectangle(10, 10, 320, 153, Fade(SKYBLUE, 0.5f));
-  DrawRectangleLines(10, 10, 320, 153, BLUE);
+  if (pData->ShowQuatJulia) {
+    DrawTextureEx(pData->QuatJuliaTexture, {0.f, 0.f}, 0.f, float(pData->screenWidth) / QuatJuliaWidth, WHITE);
+    DrawText(TextFormat("Quaternion Julia: %.1f ms", pData->QuatJuliaTime * 1000.), 20, 190, 10, DARKGRAY);
+  }
+
+  DrawRectangle(10, 10, 320, 173, Fade(SKYBLUE, 0.5f));
+  DrawRectangleLines(10, 10, 320, 173, BLUE);
 
   DrawText("Free camera default controls:", 20, 20, 10, BLACK);
   DrawText("- Mouse Wheel to Zoom in-out", 40, 40, 10, DARKGRAY);
@@ -1083,11 +1418,12 @@ auto UpdateDrawFrame3D(data* pData) -> void {
   DrawText("- Alt + Mouse Wheel Pressed to Rotate", 40, 80, 10, DARKGRAY);
   DrawText("- Alt + Ctrl + Mouse Wheel Pressed for Smooth Zoom", 40, 100, 10, DARKGRAY);
   DrawText("- Z to zoom to (0, 0, 0)", 40, 120, 10, DARKGRAY);
+  DrawText("- Q to toggle the ray-marched quaternion Julia set", 40, 140, 10, DARKGRAY);
   DrawText(
       TextFormat(
           "CubePosition: %f %f %f. Collission: %i.", cubePosition.x, cubePosition.y, cubePosition.z, Collission.hit),
       40,
-      140,
+      160,
       10,
       DARKGRAY);
 
@@ -1110,19 +1446,19 @@ auto UpdateDrawFrameHelp(data* pData) -> void {
     pData->PageNum       = data::pages::PageHelp;
   }
 
-  BeginDrawing();
-  ClearBackground(LIGHTGRAY);
+  fluffy::render::BeginFrame(pData->Render);
+  fluffy::render::Clear(pData->Render, LIGHTGRAY);
 
   constexpr auto TextOffsetY = 25u;
   constexpr auto TextPosY    = 40u;
   auto           TextIdx     = 0u;
 
-  DrawText("Available pages", 40, TextPosY + (TextIdx * TextOffsetY), 20, BLUE);
+  fluffy::render::Text(pData->Render, "Available pages", 40, TextPosY + (TextIdx * TextOffsetY), 20, BLUE);
 
   auto ldaDisplayHelpText = [&](std::string HelpText) -> unsigned int {
     ++TextIdx;
 
-    DrawText(HelpText.c_str(), 40, TextPosY + (TextIdx * TextOffsetY), 20, BLUE);
+    fluffy::render::Text(pData->Render, HelpText.c_str(), 40, TextPosY + (TextIdx * TextOffsetY), 20, BLUE);
     return TextIdx;
   };
 
@@ -1132,31 +1468,364 @@ auto UpdateDrawFrameHelp(data* pData) -> void {
 
   HandleInput(pData);
 
-  EndDrawing();
+  fluffy::render::EndFrame(pData->Render);
 }
-}; // namespace
 
 /**
- *
+ * One step of the Fourier page, the pen moves along the x axis and the trend gets the
+ * height of the wave.
  */
-auto main(int argc, char const* argv[]) -> int {
+auto StepFourier(data* pData) -> void {
+  pData->Xcalc += float(pData->Clock.Step);
 
-  SetTraceLogLevel(LOG_ALL);
+  // ---
+  // NOTE: Reset X value axis plots
+  // ---
+  auto const GridRight = pData->GridCfg.GridScreenCentre.x + pData->GridCfg.GridDimensions.x / 2.f;
 
-  data Data{};
-  Data.vTrendPoints.resize(size_t(Data.screenWidth * Data.screenHeight));
-  auto pData = &Data;
+  if (pData->Xcalc > GridRight) {
+    auto const GridLeft = -GridRight;
+    pData->Xcalc        = GridLeft;
+    pData->Trend.Clear();
+  }
+
+  if (pData->Trend.Capacity() != TrendCapacity)
+    pData->Trend.Reset(TrendCapacity);
+  pData->Trend.Push(pData->Xcalc, FourierWave(pData->n, pData->Clock.Time));
+}
+
+/**
+ * One step of the Asteroid page.
+ */
+auto StepAsteroid(data* pData) -> void {
+  pData->Xcalc += float(pData->Clock.Step);
+
+  // ---
+  // NOTE: Reset X value axis plots
+  // ---
+  if (pData->Xcalc > 2.f * M_PI) {
+    pData->Xcalc         = 0.f;
+    pData->TrendLapStart = pData->Trend.NumPushed();
+  }
+
+  // ---
+  // NOTE: The trail is one lap long, so the ring holds the points of one lap and the new
+  //       lap overwrites the previous one.
+  // ---
+  auto const LapPoints = size_t(2. * M_PI / pData->Clock.Step) + 1;
+  if (pData->Trend.Capacity() != LapPoints) {
+    pData->Trend.Reset(LapPoints);
+    pData->TrendLapStart = 0;
+  }
+  auto const Offset = AsteroidOffset(1.f, float(pData->Clock.Time));
+  pData->Trend.Push(Offset.x, Offset.y);
+}
+
+/**
+ * Size the fractal canvas to the grid as it is on the screen now.
+ */
+auto ConfigureFractalCanvas(data* pData) -> void {
+  constexpr int ResolutionX = 100;
+  constexpr int ResolutionY = 100;
+
+  auto const& GridD = pData->GridCfg.GridDimensions;
+  auto const  UL    = Eng2Pixel(pData) * es::Point(-GridD.x / 2.f, GridD.y / 2.f, 0.f);
+  auto const  LR    = Eng2Pixel(pData) * es::Point(GridD.x / 2.f, -GridD.y / 2.f, 0.f);
+
+  pData->FractalConfig.PixelCanvas = fluffy::fractal::ConfigurePixelCanvas(
+      pData->screenWidth >> 1, pData->screenHeight >> 1, LR.x - UL.x, LR.y - UL.y, ResolutionX, ResolutionY);
+}
+
+/**
+ * Start rendering the first fractal on a thread, from a copy of the grid and the config so
+ * that the keys can change them meanwhile.
+ */
+auto PrewarmFractal(data* pData) -> void {
+  ConfigureFractalCanvas(pData);
+
+  auto& P      = pData->FractalPrewarm;
+  P.Config     = pData->FractalConfig;
+  P.GridCfg    = pData->GridCfg;
+  P.Resolution = FractalResolution(pData);
+  P.Worker     = std::thread([&P] { RenderFractalImage(P.Config, P.GridCfg, P.Resolution); });
+}
+
+/**
+ * The fractal texture, from the prewarmed image when it shows what would be rendered now.
+ */
+auto InitFractal(data* pData) -> void {
+  auto& P = pData->FractalPrewarm;
+  if (P.Worker.joinable()) {
+    P.Worker.join();
+
+    auto const& FC         = pData->FractalConfig;
+    auto const& Grid       = pData->GridCfg;
+    auto const  Resolution = FractalResolution(pData);
+    auto const  Same = P.Config.iMage.data && P.Resolution.x == Resolution.x && P.Resolution.y == Resolution.y &&
+                      P.GridCfg.GridCenterValue.x == Grid.GridCenterValue.x &&
+                      P.GridCfg.GridCenterValue.y == Grid.GridCenterValue.y &&
+                      P.GridCfg.GridDimensions.x == Grid.GridDimensions.x &&
+                      P.GridCfg.GridDimensions.y == Grid.GridDimensions.y && P.Config.Constant.x == FC.Constant.x &&
+                      P.Config.Constant.y == FC.Constant.y && P.Config.Mode == FC.Mode &&
+                      P.Config.PixelCanvas.Quality == FC.PixelCanvas.Quality;
+    if (Same) {
+      pData->FractalConfig.PixelCanvas = P.Config.PixelCanvas;
+      pData->FractalConfig.iMage       = P.Config.iMage;
+      UploadFractalTexture(pData);
+    }
+    P = data::fractal_prewarm{};
+  }
+
+  if (!pData->FractalTexture.id) {
+    ConfigureFractalCanvas(pData);
+    RenderFractalTexture(pData);
+  }
+}
+
+auto TeardownFractal(data* pData) -> void {
+  if (pData->FractalPrewarm.Worker.joinable())
+    pData->FractalPrewarm.Worker.join();
+  if (pData->FractalTexture.id)
+    UnloadTexture(pData->FractalTexture);
+  pData->FractalTexture = Texture2D{};
+}
 
-  Camera3D& Camera  = Data.Camera;
+/**
+ */
+auto Init3D(data* pData) -> void {
+  Camera3D& Camera  = pData->Camera;
   Camera.position   = (Vector3){10.0f, 10.0f, 10.0f}; // Camera position
   Camera.target     = (Vector3){0.0f, 0.0f, 0.0f};    // Camera looking at point
   Camera.up         = (Vector3){0.0f, 1.0f, 0.0f};    // Camera up vector (rotation towards target)
   Camera.fovy       = 45.0f;                          // Camera field-of-view Y
   Camera.projection = CAMERA_ORTHOGRAPHIC;            // Camera projection type
+}
+
+auto Teardown3D(data* pData) -> void {
+  if (pData->QuatJuliaTexture.id)
+    UnloadTexture(pData->QuatJuliaTexture);
+  if (pData->QuatJuliaImage.data)
+    UnloadImage(pData->QuatJuliaImage);
+  pData->QuatJuliaTexture = Texture2D{};
+  pData->QuatJuliaImage   = Image{};
+}
+
+/**
+ * Hooks of a page, nullptr where the page has nothing to do.
+ *
+ * Prewarm starts making what Init needs on another thread, before the page is shown. Init
+ * is called on the first frame the page is shown, with the window and the GL context.
+ * Update takes one fixed step of the simulation of the page, see AdvanceSimulation, and
+ * Draw draws a frame and handles the keys. Teardown frees what Prewarm and Init made, it
+ * is called for all the pages when the program ends.
+ */
+struct page {
+  data::pages Id{};
+  char const* pName{};
+  auto (*Prewarm)(data*) -> void;
+  auto (*Init)(data*) -> void;
+  auto (*Update)(data*) -> void;
+  auto (*Draw)(data*) -> void;
+  auto (*Teardown)(data*) -> void;
+};
+
+/**
+ * All the pages, in the order of data::pages.
+ */
+constexpr std::array<page, size_t(data::pages::NumPages)> Pages{
+    page{data::pages::PageAsteroid, "Asteroid", nullptr, nullptr, &StepAsteroid, &UpdateDrawFrameAsteroid, nullptr},
+    page{data::pages::PageFourier, "Fourier", nullptr, nullptr, &StepFourier, &UpdateDrawFrameFourier, nullptr},
+    page{data::pages::PageFractal,
+         "Fractal",
+         &PrewarmFractal,
+         &InitFractal,
+         nullptr,
+         &UpdateDrawFrameFractal,
+         &TeardownFractal},
+    page{data::pages::Page3D, "3D", nullptr, &Init3D, nullptr, &UpdateDrawFrame3D, &Teardown3D},
+    page{data::pages::PageHelp, "Help", nullptr, nullptr, nullptr, &UpdateDrawFrameHelp, nullptr}};
+
+static_assert(std::ranges::all_of(Pages, [](page const& P) { return &P == &Pages[size_t(P.Id)]; }),
+              "Pages must be in the order of data::pages.");
+
+/**
+ * One step of the simulation of the selected page, at Clock.Time.
+ */
+auto StepSimulation(data* pData) -> void {
+  if (auto const pUpdate = Pages[size_t(pData->Selected)].Update)
+    (*pUpdate)(pData);
+}
+
+/**
+ * Draw a frame of the selected page, calling its Init first the first time.
+ */
+auto DrawPage(data* pData) -> void {
+  auto const  Idx  = size_t(pData->Selected);
+  auto const& Page = Pages[Idx];
+  if (!pData->aPageReady[Idx]) {
+    pData->aPageReady[Idx] = true;
+    if (Page.Init)
+      (*Page.Init)(pData);
+  }
+  (*Page.Draw)(pData);
+}
+
+/**
+ * Start the Prewarm of all the pages that have one.
+ */
+auto PrewarmPages(data* pData) -> void {
+  for (auto const& Page : Pages)
+    if (Page.Prewarm)
+      (*Page.Prewarm)(pData);
+}
+
+auto TeardownPages(data* pData) -> void {
+  for (auto const& Page : Pages) {
+    if (Page.Teardown)
+      (*Page.Teardown)(pData);
+    pData->aPageReady[size_t(Page.Id)] = false;
+  }
+}
+
+/**
+ * Take the steps for a frame of FrameSeconds and set the time to draw.
+ */
+auto AdvanceSimulation(data* pData, double FrameSeconds) -> void {
+  for (auto NumSteps = fluffy::sim::Advance(pData->Clock, FrameSeconds); NumSteps > 0; --NumSteps) {
+    fluffy::sim::Tick(pData->Clock);
+    StepSimulation(pData);
+  }
+  pData->t = float(fluffy::sim::DisplayTime(pData->Clock));
+}
+
+/**
+ * Run each of the 2D pages for NumFrames frames of 1/60 s and print the time per frame and
+ * what was drawn. Meant for a backend without a window. With FastForward the simulation of
+ * a page is first stepped that many seconds as fast as it goes, without drawing. With the
+ * software backend the last frame of each page is written to ExportPrefix + page name + ".png".
+ */
+auto RunBench(data* pData, int NumFrames, double FastForward, std::string const& ExportPrefix) -> void {
+  constexpr std::array<data::pages, 3> aBenchPages{
+      data::pages::PageFourier, data::pages::PageAsteroid, data::pages::PageHelp};
+
+  for (auto const Id : aBenchPages) {
+    auto const& Page = Pages[size_t(Id)];
+    fluffy::render::ResetCounters(pData->Render);
+    pData->Selected = Id;
+    pData->Clock    = fluffy::sim::Clock(1. / 60.);
+    pData->t        = 0.f;
+    pData->Key      = 0;
+
+    if (FastForward > 0.) {
+      auto const NumSteps = uint64_t(FastForward / pData->Clock.Step);
+      auto const Start    = std::chrono::steady_clock::now();
+      for (uint64_t Step = 0; Step < NumSteps; ++Step) {
+        fluffy::sim::Tick(pData->Clock);
+        StepSimulation(pData);
+      }
+      auto const Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+      pData->t           = float(pData->Clock.Time);
+
+      std::cout << Page.pName << ": " << NumSteps << " steps, " << std::fixed << std::setprecision(1)
+                << pData->Clock.Time << " s simulated in " << std::setprecision(4) << 1000. * Seconds << " ms"
+                << std::defaultfloat << std::endl;
+    }
+
+    auto const Start = std::chrono::steady_clock::now();
+    for (int Frame = 0; Frame < NumFrames; ++Frame) {
+      fluffy::perf::region PerfRegion{"curves.frame"};
+      AdvanceSimulation(pData, 1. / 60.);
+      DrawPage(pData);
+    }
+    auto const Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+    std::cout << Page.pName << ": " << std::fixed << std::setprecision(4) << 1000. * Seconds / std::max(NumFrames, 1)
+              << " ms/frame" << std::defaultfloat << std::endl;
+    fluffy::render::Report(pData->Render, std::cout);
+
+    if (fluffy::render::backend_kind::Software == pData->Render.Kind) {
+      auto       Img      = fluffy::softraster::GenImageCanvas(pData->Render.Canvas);
+      auto const FileName = ExportPrefix + Page.pName + ".png";
+      if (!ExportImage(Img, FileName.c_str()))
+        std::cerr << "Could not write " << FileName << std::endl;
+      UnloadImage(Img);
+    }
+  }
+}
+}; // namespace
+
+/**
+ *
+ */
+auto main(int argc, char const* argv[]) -> int {
+  auto const StartTime = std::chrono::steady_clock::now();
+
+  // ---
+  // NOTE: Command line options.
+  //       --perf <file.csv>  Measure regions with the hardware counters, print a report and
+  //                          write the totals to file.csv on exit.
+  //       --bench <frames>   Run the 2D pages headless with the null backend, printing the time
+  //                          per frame and the primitives drawn.
+  //       --record <file>    With --bench, record the commands and write them to file.
+  //       --export <prefix>  With --bench, draw on the CPU and write the last frame of each page
+  //                          to <prefix><page>.png.
+  //       --size <w>x<h>     Screen size in pixels, e.g. 3840x2160.
+  //       --speed <x>        Run the simulation x times faster than the wall clock.
+  //       --fast-forward <s> Headless, step the simulation of each 2D page s seconds as fast as
+  //                          it goes before the frames of --bench, or before one frame.
+  //       --prewarm          Render the first fractal on a thread while the help page is shown.
+  // ---
+  std::string PerfFile{};
+  std::string RecordFile{};
+  std::string ExportPrefix{};
+  int         BenchFrames{};
+  double      Speed{1.};
+  double      FastForward{};
+  bool        Prewarm{};
+  int         Width{};
+  int         Height{};
+  for (int Idx = 1; Idx < argc; ++Idx) {
+    auto const Arg = std::string(argv[Idx]);
+    if (Arg == "--perf" && Idx + 1 < argc)
+      PerfFile = argv[++Idx];
+    else if (Arg == "--bench" && Idx + 1 < argc)
+      BenchFrames = std::max(std::atoi(argv[++Idx]), 1);
+    else if (Arg == "--record" && Idx + 1 < argc)
+      RecordFile = argv[++Idx];
+    else if (Arg == "--export" && Idx + 1 < argc)
+      ExportPrefix = argv[++Idx];
+    else if (Arg == "--size" && Idx + 1 < argc)
+      std::sscanf(argv[++Idx], "%dx%d", &Width, &Height);
+    else if (Arg == "--speed" && Idx + 1 < argc)
+      Speed = std::max(std::atof(argv[++Idx]), 0.);
+    else if (Arg == "--fast-forward" && Idx + 1 < argc)
+      FastForward = std::max(std::atof(argv[++Idx]), 0.);
+    else if (Arg == "--prewarm")
+      Prewarm = true;
+  }
+  if (FastForward > 0.)
+    BenchFrames = std::max(BenchFrames, 1);
+  fluffy::perf::Enable(!PerfFile.empty());
+
+  SetTraceLogLevel(LOG_ALL);
+
+  data Data{};
+  auto pData = &Data;
 
   // Initialization
   // ---
-  InitWindow(Data.screenWidth, Data.screenHeight, "Fluffy's adventures with Raylib");
+  if (Width > 0 && Height > 0) {
+    Data.screenWidth  = Width;
+    Data.screenHeight = Height;
+  }
+
+  auto const Kind = !BenchFrames           ? fluffy::render::backend_kind::Raylib
+                    : !ExportPrefix.empty() ? fluffy::render::backend_kind::Software
+                    : RecordFile.empty()    ? fluffy::render::backend_kind::Null
+                                            : fluffy::render::backend_kind::Recording;
+  Data.Render     = fluffy::render::Backend(Kind, Data.screenWidth, Data.screenHeight);
+  if (!BenchFrames)
+    InitWindow(Data.screenWidth, Data.screenHeight, "Fluffy's adventures with Raylib");
 
   Data.vHelpTextPage.push_back("F1 - This help page");
   Data.vHelpTextPage.push_back("F2 - ScreenShot");
@@ -1166,9 +1835,12 @@ auto main(int argc, char const* argv[]) -> int {
   Data.vHelpTextPage.push_back("g -  toggle Grid");
   Data.vHelpTextPage.push_back("l -  open current page's web Link");
   Data.vHelpTextPage.push_back("r -  fRactal");
+  Data.vHelpTextPage.push_back("t -  toggle live Trend channels on the Asteriode and Fourier pages");
   Data.vHelpTextPage.push_back("On page fRactal - F6 Auto increment Constant");
   Data.vHelpTextPage.push_back("On page fRactal - F7/F8 changes Constant Real value");
   Data.vHelpTextPage.push_back("On page fRactal - F9/F10 changes Constant Imaginary value");
+  Data.vHelpTextPage.push_back("On page fRactal - F4 toggles adaptive anti-aliasing");
+  Data.vHelpTextPage.push_back("On page fRactal - F5 cycles mode Julia/Buddhabrot/Anti-Buddhabrot/MIIM");
 
   // ---
   SetTargetFPS(60); // Set our game to run at X frames-per-second
@@ -1186,20 +1858,17 @@ auto main(int argc, char const* argv[]) -> int {
   Data.vPixelsPerUnit = es::Point(100.f, 100.f, 100.f);
 
   // ---
-  // NOTE: Set up Homogenous matrix for conversion to pixel space.
+  // NOTE: Set up the conversion to pixel space.
   // ---
-  Data.MhE2P = InitEng2PixelMatrix(
+  auto const MhE2P = InitEng2Pixel(
       Data.vEngOffset, Data.vPixelsPerUnit, {Data.screenWidth / 2.f, Data.screenHeight / 2.f, 0.f, 0.f});
+  Data.FrameEng  = es::AddFrame(Data.Frames, MhE2P);
+  Data.FrameGrid = es::AddFrame(Data.Frames, Grid2Eng(Data.GridCfg), Data.FrameEng);
 
-  Data.MhG2E    = es::SetTranslation(es::Vector(0.f, 0.f, 0.f));
-  Data.MhG2EInv = MatrixInvert(Data.MhG2E);
-
-  if (es::IsMatrixInvertible(Data.MhE2P)) {
-    Data.MhE2PInv = MatrixInvert(Data.MhE2P);
+  if (es::IsMatrixInvertible(MhE2P)) {
+    auto const OrigoScreenInPixels = es::PointDouble(Data.screenWidth / 2., Data.screenHeight / 2., 0.);
 
-    auto const OrigoScreenInPixels = es::Point(Data.screenWidth / 2.f, Data.screenHeight / 2.f, 0.f);
-
-    auto const EngPos = Data.MhE2PInv * OrigoScreenInPixels;
+    auto const EngPos = es::WorldInv(Data.Frames, Data.FrameEng) * OrigoScreenInPixels;
 
     TraceLog(LOG_INFO,
              "Pixel Pos %i:%i is mapped from engineering Pos %f:%f",
@@ -1210,7 +1879,7 @@ auto main(int argc, char const* argv[]) -> int {
 
   } else {
     std::cerr << "The Homogenous matrix MhE2P is not invertible." << std::endl;
-    std::cout << Data.MhE2P << std::endl;
+    std::cout << MhE2P << std::endl;
     std::cerr << "Will not be able to convert to engineering pos from PixelPos." << std::endl;
     return 1;
   }
@@ -1218,55 +1887,65 @@ auto main(int argc, char const* argv[]) -> int {
   // ---
   // NOTE: Construct the grid pattern.
   // ---
-  Data.GridCfg = GridCfgInPixels(Data.MhE2P, Data.GridCfg);
+  Data.GridCfg = GridCfgInPixels(Data.Render, Eng2Pixel(&Data), Data.GridCfg);
 
   // ---
-  // NOTE: Create a simple fractal before startup.
+  // NOTE: Headless, no window and no textures.
   // ---
-  {
-    constexpr int ResolutionX = 100;
-    constexpr int ResolutionY = 100;
-
-    auto UL = Data.MhE2P * es::Point(-Data.GridCfg.GridDimensions.x / 2.f,
-                                     Data.GridCfg.GridDimensions.y / 2.f,
-                                     0.f); // Data.GridCfg.GridDimensions * 0.5f;
-    auto LR = Data.MhE2P * es::Point(Data.GridCfg.GridDimensions.x / 2.f,
-                                     -Data.GridCfg.GridDimensions.y / 2.f,
-                                     0.f); // Data.GridCfg.GridDimensions * 0.5f;
-    std::cout << " ---- XXXX UL " << UL << std::endl;
-    std::cout << " ---- XXXX LR " << LR << std::endl;
-
-    pData->FractalConfig.PixelCanvas = fluffy::fractal::ConfigurePixelCanvas(
-        pData->screenWidth >> 1, pData->screenHeight >> 1, LR.x - UL.x, LR.y - UL.y, ResolutionX, ResolutionY);
-
-    fluffy::fractal::CreateFractalPixelSpace(pData->GridCfg,
-                                             pData->FractalConfig.PixelCanvas,
-                                             {pData->MhE2P.m0, pData->MhE2P.m5, 0.f, 0.f},
-                                             pData->FractalConfig.Constant,
-                                             pData->FractalConfig.iMage);
-    if (pData->FractalConfig.iMage.data) {
-      pData->FractalTexture = LoadTextureFromImage(pData->FractalConfig.iMage);
+  if (BenchFrames) {
+    RunBench(pData, BenchFrames, FastForward, ExportPrefix);
+
+    if (!RecordFile.empty() && !fluffy::render::WriteStream(Data.Render, RecordFile))
+      std::cerr << "Could not write " << RecordFile << std::endl;
+    if (!PerfFile.empty()) {
+      fluffy::perf::Report(std::cout);
+      if (!fluffy::perf::WriteCsv(PerfFile))
+        std::cerr << "Could not write " << PerfFile << std::endl;
     }
+    return 0;
   }
 
-  Data.UpdateDrawFramePointer = UpdateDrawFrameHelp;
+  // ---
+  // NOTE: The pages make what they need the first time they are shown, only the prewarm
+  //       starts before the first frame.
+  // ---
+  if (Prewarm)
+    PrewarmPages(pData);
+
+  Data.Selected  = data::pages::PageHelp;
+  Data.Clock     = fluffy::sim::Clock(1. / 60., Speed);
+  auto NumFrames = 0;
 
   // ---
   // Main game loop
   // ---
   while (!WindowShouldClose()) // Detect window close button or ESC key
   {
+    fluffy::perf::region PerfRegion{"curves.frame"};
+
     DrawFPS(10, 10);
-    Data.dt = 1. / 60.f; // / GetFPS();
-    if (!Data.StopUpdate)
-      Data.t = GetTime();
+    Data.Clock.Paused = Data.StopUpdate;
+    AdvanceSimulation(pData, GetFrameTime());
     Data.Key = GetKeyPressed();
 
-    (*Data.UpdateDrawFramePointer)(pData);
+    DrawPage(pData);
+
+    if (1 == ++NumFrames)
+      TraceLog(LOG_INFO,
+               "First frame %.1f ms after start",
+               std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count());
   }
 
+  StopTrendProducers(pData);
+  TeardownPages(pData);
   CloseWindow(); // Close window and OpenGL context
 
+  if (!PerfFile.empty()) {
+    fluffy::perf::Report(std::cout);
+    if (!fluffy::perf::WriteCsv(PerfFile))
+      std::cerr << "Could not write " << PerfFile << std::endl;
+  }
+
   return 0;
 }
 
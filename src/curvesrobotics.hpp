@@ -9,43 +9,72 @@
  * MIT License - see bottom of file.
  */
 
+#include "engsupport.hpp"
 #include "raylib.h"
 
+#include <array>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <vector>
 
 namespace currob {
+
+constexpr size_t MaxLabelGlyphs = 12;
+
 /**
- * Hold pixel position as integers, X and Y.
+ * Label at a grid tick, as glyph indices into the font atlas. X and Y are the pixel
+ * position of the top left corner of the first glyph.
  */
-struct pixel_pos {
-  int         X{};
-  int         Y{};
-  Color       color{LIGHTGRAY};
-  std::string TxtTagX{}; //!< Text for x markers
-  std::string TxtTagY{}; //!< Text for y markers
+struct grid_label {
+  float                           X{};
+  float                           Y{};
+  uint8_t                         NumGlyphs{};
+  std::array<int, MaxLabelGlyphs> aGlyph{};
+};
+
+/**
+ * What the pixel geometry of a grid is made from. When it is the same, the geometry is too.
+ */
+struct grid_key {
+  es::affine2        E2P{};
+  float              TickDistance{};
+  es::vector4_double GridCenterValue{};
+  Vector4            GridDimensions{};
+  Vector4            GridScreenCentre{};
+
+  auto operator==(grid_key const& K) const -> bool {
+    return E2P.Scale.x == K.E2P.Scale.x && E2P.Scale.y == K.E2P.Scale.y && E2P.Offset.x == K.E2P.Offset.x &&
+           E2P.Offset.y == K.E2P.Offset.y && TickDistance == K.TickDistance &&
+           GridCenterValue.x == K.GridCenterValue.x && GridCenterValue.y == K.GridCenterValue.y &&
+           GridDimensions.x == K.GridDimensions.x && GridDimensions.y == K.GridDimensions.y &&
+           GridScreenCentre.x == K.GridScreenCentre.x && GridScreenCentre.y == K.GridScreenCentre.y;
+  }
 };
 
 /**
  * Grid configuration.
- * Store a vector of pixel_pos which is the screen X and Y pixel positions.
+ * Store the lines in pixels as a packed vertex buffer, and the tick labels as glyphs.
  * The GridCentre and GridDimensions are used to keep information about size
  * so that it can be passed around to the various routines that need it.
  */
 struct grid_cfg {
   float TickDistance{0.1f};
 
-  std::vector<pixel_pos> vGridLines{};
-  std::vector<pixel_pos> vGridSubDivider{};
+  std::vector<float>      vLineVertices{}; //!< x0, y0, x1, y1 in pixels for each line, the major lines first.
+  size_t                  NumMajorLines{};
+  std::vector<grid_label> vLabels{};
+  grid_key                Key{}; //!< What the lines and labels were made from.
 
   /**
    */
   Vector4 GridScreenCentre{0.f, 0.f, 0.f, 1.f}; //!< Make it a Point.
 
   /**
+   * Value at the centre of the grid. In double since it is the centre of the fractal
+   * window, which at deep zoom needs more digits than a float has.
    */
-  Vector4 GridCenterValue{0.f, 0.f, 0.f, 1.f}; //!< Make it a Point.
+  es::vector4_double GridCenterValue{0., 0., 0., 1.}; //!< Make it a Point.
 
   /**
    * @- x is GridLength
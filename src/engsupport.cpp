@@ -15,116 +15,171 @@
 #define RAYMATH_IMPLEMENTATION // Define external out-of-line implementation
 #include "raymath.h"           // Vector3, Quaternion and Matrix functionality
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ES_SSE 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ES_SSE2 1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+static_assert(sizeof(Matrix) == 16 * sizeof(float), "Matrix is used as an array of 16 floats");
+static_assert(sizeof(Vector4) == 4 * sizeof(float), "Vector4 is used as an array of 4 floats");
+static_assert(sizeof(es::matrix4_double) == 16 * sizeof(double), "matrix4_double is used as an array of 16 doubles");
+static_assert(sizeof(es::vector4_double) == 4 * sizeof(double), "vector4_double is used as an array of 4 doubles");
 
 /**
- * es - engineering support namespace
+ * Matrix as 16 floats, and matrix4_double as 16 doubles. The rows are contiguous: m0 m4
+ * m8 m12 is the first row, so element (Row, Col) is at index 4 * Row + Col.
  */
-namespace es // aka engineering support
-{
+auto Data(Matrix const& M) -> float const* { return reinterpret_cast<float const*>(&M); }
+auto Data(Matrix& M) -> float* { return reinterpret_cast<float*>(&M); }
+auto Data(es::matrix4_double const& M) -> double const* { return reinterpret_cast<double const*>(&M); }
+auto Data(es::matrix4_double& M) -> double* { return reinterpret_cast<double*>(&M); }
 
 /**
- * Cause a crash when condition is false.
+ * x' = A * x + B * y + C and y' = D * x + E * y + F for N points.
+ * With Axis set B and D are zero, and left out.
  */
-void Assert(bool Condition, char const* pCaller, int Line) {
-  if (!Condition) {
-    volatile char* pChar = nullptr;
-    *pChar               = 't';
+struct affine_2d {
+  float A{}, B{}, C{}, D{}, E{}, F{};
+  bool  Axis{};
+};
+
+auto TransformRange(affine_2d const& T, float const* pX, float const* pY, float* pOutX, float* pOutY, size_t N)
+    -> void {
+  size_t Idx = 0;
+
+#if defined(__AVX__)
+  constexpr size_t Lanes = 8;
+  auto const       A     = _mm256_set1_ps(T.A);
+  auto const       B     = _mm256_set1_ps(T.B);
+  auto const       C     = _mm256_set1_ps(T.C);
+  auto const       D     = _mm256_set1_ps(T.D);
+  auto const       E     = _mm256_set1_ps(T.E);
+  auto const       F     = _mm256_set1_ps(T.F);
+  for (; Idx + Lanes <= N; Idx += Lanes) {
+    auto const X  = _mm256_loadu_ps(pX + Idx);
+    auto const Y  = _mm256_loadu_ps(pY + Idx);
+    auto       Rx = _mm256_mul_ps(A, X);
+    auto       Ry = _mm256_mul_ps(E, Y);
+    if (!T.Axis) {
+      Rx = _mm256_add_ps(Rx, _mm256_mul_ps(B, Y));
+      Ry = _mm256_add_ps(Ry, _mm256_mul_ps(D, X));
+    }
+    _mm256_storeu_ps(pOutX + Idx, _mm256_add_ps(Rx, C));
+    _mm256_storeu_ps(pOutY + Idx, _mm256_add_ps(Ry, F));
   }
-}
+#elif defined(ES_SSE)
+  constexpr size_t Lanes = 4;
+  auto const       A     = _mm_set1_ps(T.A);
+  auto const       B     = _mm_set1_ps(T.B);
+  auto const       C     = _mm_set1_ps(T.C);
+  auto const       D     = _mm_set1_ps(T.D);
+  auto const       E     = _mm_set1_ps(T.E);
+  auto const       F     = _mm_set1_ps(T.F);
+  for (; Idx + Lanes <= N; Idx += Lanes) {
+    auto const X  = _mm_loadu_ps(pX + Idx);
+    auto const Y  = _mm_loadu_ps(pY + Idx);
+    auto       Rx = _mm_mul_ps(A, X);
+    auto       Ry = _mm_mul_ps(E, Y);
+    if (!T.Axis) {
+      Rx = _mm_add_ps(Rx, _mm_mul_ps(B, Y));
+      Ry = _mm_add_ps(Ry, _mm_mul_ps(D, X));
+    }
+    _mm_storeu_ps(pOutX + Idx, _mm_add_ps(Rx, C));
+    _mm_storeu_ps(pOutY + Idx, _mm_add_ps(Ry, F));
+  }
+#endif
 
-/**
- * Identity matrix 4x4
- */
-Matrix I() {
-  Matrix M{};
-  M.m0  = 1.f;
-  M.m5  = 1.f;
-  M.m10 = 1.f;
-  M.m15 = 1.f;
-  return M;
+  // ---
+  // NOTE: Same order of operations as the SIMD lanes and as Mul(Matrix, Vector4), so that
+  //       all paths round the same way.
+  // ---
+  for (; Idx < N; ++Idx) {
+    auto const X  = pX[Idx];
+    auto const Y  = pY[Idx];
+    auto       Rx = T.A * X;
+    auto       Ry = T.E * Y;
+    if (!T.Axis) {
+      Rx = Rx + T.B * Y;
+      Ry = Ry + T.D * X;
+    }
+    pOutX[Idx] = Rx + T.C;
+    pOutY[Idx] = Ry + T.F;
+  }
 }
 
 /**
- * Compute the Determinant of a 4x4 matrix.
+ * Transform the spans with T, and split the points in chunks of whole cache lines over
+ * threads when there are enough of them.
  */
-float Determinant(Matrix const& In) {
-  float const Det = In.m0 * (In.m5 * In.m10 - In.m9 * In.m6) - In.m4 * (In.m1 * In.m10 - In.m9 * In.m2) +
-                    In.m8 * (In.m1 * In.m6 - In.m5 * In.m2) -
-                    In.m12 * (In.m1 * In.m6 * In.m11 - In.m1 * In.m10 * In.m7 - In.m5 * In.m2 * In.m11 +
-                              In.m5 * In.m10 * In.m3 + In.m9 * In.m2 * In.m7 - In.m9 * In.m6 * In.m3);
+auto TransformSpans(affine_2d const&       T,
+                    std::span<float const> Xs,
+                    std::span<float const> Ys,
+                    std::span<float>       OutX,
+                    std::span<float>       OutY) -> void {
+  auto const N = std::min({Xs.size(), Ys.size(), OutX.size(), OutY.size()});
+  if (!N)
+    return;
+
+  auto const NThreads = N < es::TransformPointsParallelThreshold
+                            ? size_t(1)
+                            : std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), 16));
+  if (NThreads == 1) {
+    TransformRange(T, Xs.data(), Ys.data(), OutX.data(), OutY.data(), N);
+    return;
+  }
 
-  return Det;
+  constexpr size_t Chunk = 16; //!< Floats per cache line.
+  auto             vT    = std::vector<std::thread>{};
+  for (size_t Idx = 0; Idx < NThreads; ++Idx) {
+    auto const Begin = (N * Idx / NThreads) / Chunk * Chunk;
+    auto const End   = Idx + 1 == NThreads ? N : (N * (Idx + 1) / NThreads) / Chunk * Chunk;
+    vT.push_back(std::thread(TransformRange,
+                             std::cref(T),
+                             Xs.data() + Begin,
+                             Ys.data() + Begin,
+                             OutX.data() + Begin,
+                             OutY.data() + Begin,
+                             End - Begin));
+  }
+  for (auto& Th : vT) {
+    if (Th.joinable())
+      Th.join();
+  }
 }
 
-/**
- * Return true when matrix is invertible.
- */
-bool IsMatrixInvertible(Matrix const& In) { return Determinant(In) != 0.0f; }
-
-//------------------------------------------------------------------------------
-/**
- * Return matrix 4x4 for conversion from engineering space to screen space.
- * Screen space is a floating point representation with x,y,z = 0,0,0 beeing at
- * the middle of the window.
- */
-Matrix InitTranslationInv(Matrix const& M, Vector4 const& vTranslation) {
-  Matrix Mat = M;
-  // float m0, m4, m8, m12;  // Matrix first row (4 components)
-  // float m1, m5, m9, m13;  // Matrix second row (4 components)
-  // float m2, m6, m10, m14; // Matrix third row (4 components)
-  // float m3, m7, m11, m15; // Matrix fourth row (4 components)
-  Mat.m0  = 1.f * M.m0;
-  Mat.m5  = 1.f * M.m5;
-  Mat.m10 = 1.f * M.m10;
-  Mat.m12 = -vTranslation.x;
-  Mat.m13 = -vTranslation.y;
-  Mat.m14 = -vTranslation.z;
-  Mat.m15 = 1.f;
-
-  return Mat;
-}
+}; // end of anonymous namespace
 
 /**
+ * es - engineering support namespace
  */
-auto SetTranslation(Vector4 const& Translation) -> Matrix {
-  auto Result = es::I();
-  Result.m12  = Translation.x;
-  Result.m13  = Translation.y;
-  Result.m14  = Translation.z;
-  return Result;
-}
+namespace es // aka engineering support
+{
 
 /**
+ * Cause a crash when condition is false.
  */
-auto SetScaling(Vector4 const& Scale) -> Matrix {
-  auto Result = es::I();
-  Result.m0   = Scale.x;
-  Result.m5   = Scale.y;
-  Result.m10  = Scale.z;
-  return Result;
+void Assert(bool Condition, char const* pCaller, int Line) {
+  if (!Condition) {
+    volatile char* pChar = nullptr;
+    *pChar               = 't';
+  }
 }
 
-/**
- * Defintions: A point in 3D space has w set to 1.
- *             A vector in 3D space has w set to 0.
- *             This implies that adding Vectors gives a new Vector.
- *             And Adding a Vector to a Point gives a new Point.
- *             And there is no meaning in adding Points since w would not be 1.
- */
-Vector4 Point(float X, float Y, float Z) { return Vector4{X, Y, Z, 1.f}; }
-Vector4 Point(Vector3 const& V) { return Point(V.x, V.y, V.z); }
-
-/**
- * Defintions: A point in 3D space has w set to 1.
- *             A vector in 3D space has w set to 0.
- *             This implies that adding Vectors gives a new Vector.
- *             And Adding a Vector to a Point gives a new Point.
- *             And there is no meaning in adding Points since w would not be 1.
- */
-Vector4 Vector(float X, float Y, float Z) { return Vector4{X, Y, Z, 0.f}; }
-Vector4 Vector(Vector3 const& V) { return Vector(V.x, V.y, V.z); }
-
 Vector4 Normalize(Vector4 const& V) {
   auto const Len = std::sqrt(V.x * V.x + V.y * V.y + V.z * V.z);
   return Vector(V.x, V.y, V.z) * (1.f / Len);
@@ -133,195 +188,305 @@ Vector4 Normalize(Vector4 const& V) {
 vector4_double Vector4Double(double X, double Y, double Z) { return vector4_double{X, Y, Z, 0.f}; }
 
 /**
- * Return matrix 4x4 for conversion from engineering space to screen space.
- * Screen space is a floating point representation with x,y,z = 0,0,0 beeing at
- * the middle of the window.
+ * The run time path of Mul(Matrix, Vector4).
  */
-Matrix InitScaling(Matrix const& M, Vector4 const& Scale, bool Reflection) {
-  Matrix     Mat  = M;
-  auto const Sign = Reflection ? -1.f : 1.f;
-  Mat.m0          = Sign * Scale.x;
-  Mat.m5          = Sign * Scale.y;
-  Mat.m10         = Sign * Scale.z;
-  Mat.m15         = 1.f;
-
-  return Mat;
-}
-
-/**
- * Return the result of multiplication of a Matrix and a Vector, dimension 4.
- */
-Vector4 Mul(Matrix const& M, Vector4 const& V) {
+Vector4 detail::MulSimd(Matrix const& M, Vector4 const& V) {
   Vector4 Result{};
+#ifdef ES_SSE
+  // ---
+  // NOTE: Transpose the rows to get the columns, and sum the columns scaled by the
+  //       components of V.
+  // ---
+  auto const* pM = Data(M);
+  __m128      C0 = _mm_loadu_ps(pM);
+  __m128      C1 = _mm_loadu_ps(pM + 4);
+  __m128      C2 = _mm_loadu_ps(pM + 8);
+  __m128      C3 = _mm_loadu_ps(pM + 12);
+  _MM_TRANSPOSE4_PS(C0, C1, C2, C3);
+
+  __m128 Sum = _mm_mul_ps(C0, _mm_set1_ps(V.x));
+  Sum        = _mm_add_ps(Sum, _mm_mul_ps(C1, _mm_set1_ps(V.y)));
+  Sum        = _mm_add_ps(Sum, _mm_mul_ps(C2, _mm_set1_ps(V.z)));
+  Sum        = _mm_add_ps(Sum, _mm_mul_ps(C3, _mm_set1_ps(V.w)));
+  _mm_storeu_ps(&Result.x, Sum);
+#else
   Result.x = M.m0 * V.x + M.m4 * V.y + M.m8 * V.z + M.m12 * V.w;
   Result.y = M.m1 * V.x + M.m5 * V.y + M.m9 * V.z + M.m13 * V.w;
   Result.z = M.m2 * V.x + M.m6 * V.y + M.m10 * V.z + M.m14 * V.w;
   Result.w = M.m3 * V.x + M.m7 * V.y + M.m11 * V.z + M.m15 * V.w;
+#endif
   return Result;
 }
 
 /**
+ * Row i of the result is the rows of M2 scaled by the elements of row i of M1.
  */
-Vector4 Add(Vector4 const& V1, Vector4 const& V2) {
-  return Vector4{V1.x + V2.x, V1.y + V2.y, V1.z + V2.z, std::min(1.f, V1.w + V2.w)};
-}
+Matrix detail::MulSimd(Matrix const& M1, Matrix const& M2) {
+  Matrix      Result{};
+  auto const* pA = Data(M1);
+  auto const* pB = Data(M2);
+  float*      pR = Data(Result);
 
-vector4_double Add(vector4_double const& V1, vector4_double const& V2) {
-  return vector4_double{V1.x + V2.x, V1.y + V2.y, V1.z + V2.z, std::min(1., V1.w + V2.w)};
+#if defined(__AVX__)
+  // ---
+  // NOTE: Two rows of the result at a time. The in lane permute picks element k of
+  //       each of the two rows of M1.
+  // ---
+  __m256 const B0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pB));
+  __m256 const B1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pB + 4));
+  __m256 const B2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pB + 8));
+  __m256 const B3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(pB + 12));
+  for (int Row = 0; Row < 4; Row += 2) {
+    __m256 const A   = _mm256_loadu_ps(pA + 4 * Row);
+    __m256       Sum = _mm256_mul_ps(_mm256_permute_ps(A, 0x00), B0);
+    Sum              = _mm256_add_ps(Sum, _mm256_mul_ps(_mm256_permute_ps(A, 0x55), B1));
+    Sum              = _mm256_add_ps(Sum, _mm256_mul_ps(_mm256_permute_ps(A, 0xAA), B2));
+    Sum              = _mm256_add_ps(Sum, _mm256_mul_ps(_mm256_permute_ps(A, 0xFF), B3));
+    _mm256_storeu_ps(pR + 4 * Row, Sum);
+  }
+#elif defined(ES_SSE)
+  __m128 const B0 = _mm_loadu_ps(pB);
+  __m128 const B1 = _mm_loadu_ps(pB + 4);
+  __m128 const B2 = _mm_loadu_ps(pB + 8);
+  __m128 const B3 = _mm_loadu_ps(pB + 12);
+  for (int Row = 0; Row < 4; ++Row) {
+    __m128 const A   = _mm_loadu_ps(pA + 4 * Row);
+    __m128       Sum = _mm_mul_ps(_mm_shuffle_ps(A, A, 0x00), B0);
+    Sum              = _mm_add_ps(Sum, _mm_mul_ps(_mm_shuffle_ps(A, A, 0x55), B1));
+    Sum              = _mm_add_ps(Sum, _mm_mul_ps(_mm_shuffle_ps(A, A, 0xAA), B2));
+    Sum              = _mm_add_ps(Sum, _mm_mul_ps(_mm_shuffle_ps(A, A, 0xFF), B3));
+    _mm_storeu_ps(pR + 4 * Row, Sum);
+  }
+#else
+  for (int Row = 0; Row < 4; ++Row) {
+    for (int Col = 0; Col < 4; ++Col) {
+      pR[4 * Row + Col] = pA[4 * Row] * pB[Col] + pA[4 * Row + 1] * pB[4 + Col] + pA[4 * Row + 2] * pB[8 + Col] +
+                          pA[4 * Row + 3] * pB[12 + Col];
+    }
+  }
+#endif
+  return Result;
 }
 
 /**
- * Dot product.
+ * Only the x and y rows of M, and the x, y and translation columns, take part since z is 0
+ * and w is 1.
  */
-float Dot(Vector4 const& V1, Vector4 const& V2) { return V1.x * V2.x + V1.y * V2.y + V1.z * V2.z + V1.w * V2.w; }
+auto TransformPoints(Matrix const&          M,
+                     std::span<float const> Xs,
+                     std::span<float const> Ys,
+                     std::span<float>       OutX,
+                     std::span<float>       OutY) -> void {
+  affine_2d T{};
+  T.A    = M.m0;
+  T.B    = M.m4;
+  T.C    = M.m12;
+  T.D    = M.m1;
+  T.E    = M.m5;
+  T.F    = M.m13;
+  T.Axis = 0.f == T.B && 0.f == T.D;
+
+  TransformSpans(T, Xs, Ys, OutX, OutY);
+}
 
-/**
- * Multiplication will keep w unchanged.
- */
-Vector4 Mul(Vector4 const& V1, float c) {
-  Vector4 const Result{V1.x * c, V1.y * c, V1.z * c, V1.w};
-  return Result;
+auto TransformPoints(affine2 const&         A,
+                     std::span<float const> Xs,
+                     std::span<float const> Ys,
+                     std::span<float>       OutX,
+                     std::span<float>       OutY) -> void {
+  affine_2d T{};
+  T.A    = A.Scale.x;
+  T.C    = A.Offset.x;
+  T.E    = A.Scale.y;
+  T.F    = A.Offset.y;
+  T.Axis = true;
+
+  TransformSpans(T, Xs, Ys, OutX, OutY);
 }
 
-/**
- * Subtracting two vectors gives a new vector
- * Subtracting two points gives a vector
- * Subtracting vectors with point and vice versa has no meaning.
- */
-Vector4 Sub(Vector4 const& V1, Vector4 const& V2) {
-  return Vector4{V1.x - V2.x, V1.y - V2.y, V1.z - V2.z, V1.w - V2.w};
+auto MatrixDouble(Matrix const& M) -> matrix4_double {
+  matrix4_double Result{};
+  std::copy(Data(M), Data(M) + 16, Data(Result));
+  return Result;
 }
 
-/**
- */
-Matrix Add(Matrix const& M1, Matrix const& M2) {
+auto ToMatrix(matrix4_double const& M) -> Matrix {
   Matrix Result{};
-  Result.m0  = M1.m0 + M2.m0;
-  Result.m1  = M1.m1 + M1.m1;
-  Result.m2  = M1.m2 + M2.m2;
-  Result.m3  = M1.m3 + M2.m3;
-  Result.m4  = M1.m4 + M2.m4;
-  Result.m5  = M1.m5 + M2.m5;
-  Result.m6  = M1.m6 + M2.m6;
-  Result.m7  = M1.m7 + M2.m7;
-  Result.m8  = M1.m8 + M2.m8;
-  Result.m9  = M1.m9 + M2.m9;
-  Result.m10 = M1.m10 + M2.m10;
-  Result.m11 = M1.m11 + M2.m11;
-  Result.m12 = M1.m12 + M2.m12;
-  Result.m13 = M1.m13 + M2.m13;
-  Result.m14 = M1.m14 + M2.m14;
-  Result.m15 = M1.m15 + M2.m15;
+  std::transform(Data(M), Data(M) + 16, Data(Result), [](double D) { return float(D); });
   return Result;
 }
 
 /**
+ * Each element is (a0 * x + a1 * y) + (a2 * z + a3 * w) on all paths, which is the order
+ * the AVX horizontal adds give, so that the results do not depend on the instruction set.
  */
-bool Eq(Matrix const& M1, Matrix const& M2) {
-  auto const Result = M1.m0 == M2.m0 &&   //!<
-                      M1.m1 == M2.m1 &&   //!<
-                      M1.m2 == M2.m2 &&   //!<
-                      M1.m3 == M2.m3 &&   //!<
-                      M1.m4 == M2.m4 &&   //!<
-                      M1.m5 == M2.m5 &&   //!<
-                      M1.m6 == M2.m6 &&   //!<
-                      M1.m7 == M2.m7 &&   //!<
-                      M1.m8 == M2.m8 &&   //!<
-                      M1.m9 == M2.m9 &&   //!<
-                      M1.m10 == M2.m10 && //!<
-                      M1.m11 == M2.m11 && //!<
-                      M1.m12 == M2.m12 && //!<
-                      M1.m13 == M2.m13 && //!<
-                      M1.m14 == M2.m14 && //!<
-                      M1.m15 == M2.m15    //!<
-      ;
+vector4_double detail::MulSimd(matrix4_double const& M, vector4_double const& V) {
+  vector4_double Result{};
+  auto const*    pM = Data(M);
+#if defined(__AVX__)
+  auto const Vec = _mm256_loadu_pd(&V.x);
+  auto const P0  = _mm256_mul_pd(_mm256_loadu_pd(pM), Vec);
+  auto const P1  = _mm256_mul_pd(_mm256_loadu_pd(pM + 4), Vec);
+  auto const P2  = _mm256_mul_pd(_mm256_loadu_pd(pM + 8), Vec);
+  auto const P3  = _mm256_mul_pd(_mm256_loadu_pd(pM + 12), Vec);
+
+  // ---
+  // NOTE: H01 is (p0[0] + p0[1], p1[0] + p1[1], p0[2] + p0[3], p1[2] + p1[3]), and the same
+  //       for H23. The lower lanes of both plus the upper lanes of both is the result.
+  // ---
+  auto const H01 = _mm256_hadd_pd(P0, P1);
+  auto const H23 = _mm256_hadd_pd(P2, P3);
+  auto const Lo  = _mm256_permute2f128_pd(H01, H23, 0x20);
+  auto const Hi  = _mm256_permute2f128_pd(H01, H23, 0x31);
+  _mm256_storeu_pd(&Result.x, _mm256_add_pd(Lo, Hi));
+#elif defined(ES_SSE2)
+  auto const VLo = _mm_loadu_pd(&V.x);
+  auto const VHi = _mm_loadu_pd(&V.z);
+  auto*      pR  = &Result.x;
+  for (int Row = 0; Row < 4; Row += 2) {
+    auto const Lo0 = _mm_mul_pd(_mm_loadu_pd(pM + 4 * Row), VLo);
+    auto const Hi0 = _mm_mul_pd(_mm_loadu_pd(pM + 4 * Row + 2), VHi);
+    auto const Lo1 = _mm_mul_pd(_mm_loadu_pd(pM + 4 * Row + 4), VLo);
+    auto const Hi1 = _mm_mul_pd(_mm_loadu_pd(pM + 4 * Row + 6), VHi);
+    auto const Lo  = _mm_add_pd(_mm_unpacklo_pd(Lo0, Lo1), _mm_unpackhi_pd(Lo0, Lo1));
+    auto const Hi  = _mm_add_pd(_mm_unpacklo_pd(Hi0, Hi1), _mm_unpackhi_pd(Hi0, Hi1));
+    _mm_storeu_pd(pR + Row, _mm_add_pd(Lo, Hi));
+  }
+#else
+  Result.x = (M.m0 * V.x + M.m4 * V.y) + (M.m8 * V.z + M.m12 * V.w);
+  Result.y = (M.m1 * V.x + M.m5 * V.y) + (M.m9 * V.z + M.m13 * V.w);
+  Result.z = (M.m2 * V.x + M.m6 * V.y) + (M.m10 * V.z + M.m14 * V.w);
+  Result.w = (M.m3 * V.x + M.m7 * V.y) + (M.m11 * V.z + M.m15 * V.w);
+#endif
   return Result;
 }
 
 /**
+ * Row i of the result is the rows of M2 weighted by row i of M1, summed in order.
  */
-bool Eq(Vector4 const& V1, Vector4 const& V2) {
-  auto const Result = V1.x == V2.x && //!<
-                      V1.y == V2.y && //!<
-                      V1.z == V2.z && //!<
-                      V1.w == V2.w;   //!<
+matrix4_double detail::MulSimd(matrix4_double const& M1, matrix4_double const& M2) {
+  matrix4_double Result{};
+  auto const*    pA = Data(M1);
+  auto const*    pB = Data(M2);
+  auto*          pR = Data(Result);
+#if defined(__AVX__)
+  auto const B0 = _mm256_loadu_pd(pB);
+  auto const B1 = _mm256_loadu_pd(pB + 4);
+  auto const B2 = _mm256_loadu_pd(pB + 8);
+  auto const B3 = _mm256_loadu_pd(pB + 12);
+  for (int Row = 0; Row < 4; ++Row) {
+    auto const* pRow = pA + 4 * Row;
+    auto        R    = _mm256_mul_pd(_mm256_set1_pd(pRow[0]), B0);
+    R                = _mm256_add_pd(R, _mm256_mul_pd(_mm256_set1_pd(pRow[1]), B1));
+    R                = _mm256_add_pd(R, _mm256_mul_pd(_mm256_set1_pd(pRow[2]), B2));
+    R                = _mm256_add_pd(R, _mm256_mul_pd(_mm256_set1_pd(pRow[3]), B3));
+    _mm256_storeu_pd(pR + 4 * Row, R);
+  }
+#elif defined(ES_SSE2)
+  for (int Half = 0; Half < 4; Half += 2) {
+    auto const B0 = _mm_loadu_pd(pB + Half);
+    auto const B1 = _mm_loadu_pd(pB + 4 + Half);
+    auto const B2 = _mm_loadu_pd(pB + 8 + Half);
+    auto const B3 = _mm_loadu_pd(pB + 12 + Half);
+    for (int Row = 0; Row < 4; ++Row) {
+      auto const* pRow = pA + 4 * Row;
+      auto        R    = _mm_mul_pd(_mm_set1_pd(pRow[0]), B0);
+      R                = _mm_add_pd(R, _mm_mul_pd(_mm_set1_pd(pRow[1]), B1));
+      R                = _mm_add_pd(R, _mm_mul_pd(_mm_set1_pd(pRow[2]), B2));
+      R                = _mm_add_pd(R, _mm_mul_pd(_mm_set1_pd(pRow[3]), B3));
+      _mm_storeu_pd(pR + 4 * Row + Half, R);
+    }
+  }
+#else
+  for (int Row = 0; Row < 4; ++Row) {
+    for (int Col = 0; Col < 4; ++Col) {
+      pR[4 * Row + Col] = pA[4 * Row] * pB[Col] + pA[4 * Row + 1] * pB[4 + Col] + pA[4 * Row + 2] * pB[8 + Col] +
+                          pA[4 * Row + 3] * pB[12 + Col];
+    }
+  }
+#endif
   return Result;
 }
 
 /**
- * Computes the linear interpolation between A and B, if the parameter t is
- * inside [0, 1]
+ * Return vector containing the absolute value of the elements on the diagonal
+ * of a Matrix. Can be used for pulling out resolution.
  */
-Vector4 Lerp(Vector4 const& A, Vector4 const& B, float t) {
+auto DiagVectorAbs(Matrix const& MhE2P) -> Vector4 {
+  auto D = DiagVector(MhE2P);
+  return es::Vector(std::abs(D.x), std::abs(D.y), std::abs(D.z));
+}
 
-  if (t < 0.f || t > 1.f)
-    return {};
-  return A + (B - A) * t;
+//------------------------------------------------------------------------------
+// Transform graph
+//------------------------------------------------------------------------------
+auto AddFrame(transform_graph& Graph, matrix4_double const& Local, frame_id Parent) -> frame_id {
+  Assert(Parent < Graph.vFrames.size(), __func__, __LINE__);
+
+  auto const Frame  = Graph.vFrames.size();
+  auto&      New    = Graph.vFrames.emplace_back();
+  New.Parent        = Parent;
+  New.Local         = Local;
+  New.WorldDirty    = true;
+  New.WorldInvDirty = true;
+  Graph.vFrames[Parent].vChildren.push_back(Frame);
+  return Frame;
 }
 
 /**
+ * A frame with a clean World or WorldInv has a clean parent World or WorldInv, since they
+ * are composed from the parent. So the walk stops at frames where both are dirty already,
+ * everything below them is dirty too.
  */
-Matrix Mul(Matrix const& M1, Matrix const& M2) {
-  Matrix Result{};
-  Result.m0 = Dot(Vector4{M1.m0, M1.m4, M1.m8, M1.m12}, Vector4{M2.m0, M2.m1, M2.m2, M2.m3});
-  Result.m1 = Dot(Vector4{M1.m1, M1.m5, M1.m9, M1.m13}, Vector4{M2.m0, M2.m1, M2.m2, M2.m3});
-  Result.m2 = Dot(Vector4{M1.m2, M1.m6, M1.m10, M1.m14}, Vector4{M2.m0, M2.m1, M2.m2, M2.m3});
-  Result.m3 = Dot(Vector4{M1.m3, M1.m7, M1.m11, M1.m15}, Vector4{M2.m0, M2.m1, M2.m2, M2.m3});
-
-  Result.m4 = Dot(Vector4{M1.m0, M1.m4, M1.m8, M1.m12}, Vector4{M2.m4, M2.m5, M2.m6, M2.m7});
-  Result.m5 = Dot(Vector4{M1.m1, M1.m5, M1.m9, M1.m13}, Vector4{M2.m4, M2.m5, M2.m6, M2.m7});
-  Result.m6 = Dot(Vector4{M1.m2, M1.m6, M1.m10, M1.m14}, Vector4{M2.m4, M2.m5, M2.m6, M2.m7});
-  Result.m7 = Dot(Vector4{M1.m3, M1.m7, M1.m11, M1.m15}, Vector4{M2.m4, M2.m5, M2.m6, M2.m7});
-
-  Result.m8  = Dot(Vector4{M1.m0, M1.m4, M1.m8, M1.m12}, Vector4{M2.m8, M2.m9, M2.m10, M2.m11});
-  Result.m9  = Dot(Vector4{M1.m1, M1.m5, M1.m9, M1.m13}, Vector4{M2.m8, M2.m9, M2.m10, M2.m11});
-  Result.m10 = Dot(Vector4{M1.m2, M1.m6, M1.m10, M1.m14}, Vector4{M2.m8, M2.m9, M2.m10, M2.m11});
-  Result.m11 = Dot(Vector4{M1.m3, M1.m7, M1.m11, M1.m15}, Vector4{M2.m8, M2.m9, M2.m10, M2.m11});
-
-  Result.m12 = Dot(Vector4{M1.m0, M1.m4, M1.m8, M1.m12}, Vector4{M2.m12, M2.m13, M2.m14, M2.m15});
-  Result.m13 = Dot(Vector4{M1.m1, M1.m5, M1.m9, M1.m13}, Vector4{M2.m12, M2.m13, M2.m14, M2.m15});
-  Result.m14 = Dot(Vector4{M1.m2, M1.m6, M1.m10, M1.m14}, Vector4{M2.m12, M2.m13, M2.m14, M2.m15});
-  Result.m15 = Dot(Vector4{M1.m3, M1.m7, M1.m11, M1.m15}, Vector4{M2.m12, M2.m13, M2.m14, M2.m15});
-  return Result;
+auto SetLocal(transform_graph& Graph, frame_id Frame, matrix4_double const& Local) -> void {
+  Assert(Frame != transform_graph::Root && Frame < Graph.vFrames.size(), __func__, __LINE__);
+  Graph.vFrames[Frame].Local = Local;
+
+  std::vector<frame_id> vStack{Frame};
+  while (!vStack.empty()) {
+    auto& F = Graph.vFrames[vStack.back()];
+    vStack.pop_back();
+    if (F.WorldDirty && F.WorldInvDirty)
+      continue;
+    F.WorldDirty    = true;
+    F.WorldInvDirty = true;
+    vStack.insert(vStack.end(), F.vChildren.begin(), F.vChildren.end());
+  }
 }
 
-vector4_double VectorDouble(double X, double Y, double Z) { return vector4_double{X, Y, Z, 0.}; }
-vector4_double VectorDouble(Vector4 const& V) { return vector4_double{V.x, V.y, V.z, V.w}; }
-/**
- * Return vector containing the absolute value of the elements on the diagonal
- * of a Matrix. Can be used for pulling out resolution.
- */
-auto DiagVector(Matrix const& MhE2P) -> Vector4 { return es::Vector(MhE2P.m0, MhE2P.m5, MhE2P.m10); }
+auto Local(transform_graph const& Graph, frame_id Frame) -> matrix4_double const& {
+  return Graph.vFrames[Frame].Local;
+}
+
+auto World(transform_graph& Graph, frame_id Frame) -> matrix4_double const& {
+  auto& F = Graph.vFrames[Frame];
+  if (F.WorldDirty) {
+    F.World      = World(Graph, F.Parent) * F.Local;
+    F.WorldDirty = false;
+  }
+  return F.World;
+}
 
 /**
- * Return vector containing the absolute value of the elements on the diagonal
- * of a Matrix. Can be used for pulling out resolution.
+ * Composed from the inverses of the local transforms, which are mostly plain translations
+ * and scalings that invert exactly, instead of inverting the composed World.
  */
-auto DiagVectorAbs(Matrix const& MhE2P) -> Vector4 {
-  auto D = DiagVector(MhE2P);
-  return es::Vector(std::abs(D.x), std::abs(D.y), std::abs(D.z));
+auto WorldInv(transform_graph& Graph, frame_id Frame) -> matrix4_double const& {
+  auto& F = Graph.vFrames[Frame];
+  if (F.WorldInvDirty) {
+    F.WorldInv      = Invert(F.Local) * WorldInv(Graph, F.Parent);
+    F.WorldInvDirty = false;
+    ++Graph.NumInversions;
+  }
+  return F.WorldInv;
 }
 
-auto V4ToV3(Vector4 const& V) -> Vector3 { return (Vector3){V.x, V.y, V.z}; }
+auto Between(transform_graph& Graph, frame_id From, frame_id To) -> matrix4_double {
+  return WorldInv(Graph, To) * World(Graph, From);
+}
 
 }; // namespace es
 
-Matrix              operator*(Matrix const& M1, Matrix const& M2) { return es::Mul(M1, M2); }
-Matrix              operator+(Matrix const& M1, Matrix const& M2) { return es::Add(M1, M2); }
-bool                operator==(Matrix const& M1, Matrix const& M2) { return es::Eq(M1, M2); }
-bool                operator!=(Matrix const& M1, Matrix const& M2) { return !(M1 == M2); }
-Vector4             operator*(Matrix const& M, Vector4 const& V) { return es::Mul(M, V); }
-Vector4             operator*(Vector4 const& V1, float c) { return es::Mul(V1, c); }
-Vector4             operator+(Vector4 const& V1, Vector4 const& V2) { return es::Add(V1, V2); }
-es::vector4_double  operator+(es::vector4_double const& V1, es::vector4_double const& V2) { return es::Add(V1, V2); }
-es::vector4_double& operator+=(es::vector4_double& LHS, es::vector4_double const& RHS) {
-  LHS = es::Add(LHS, RHS);
-  return LHS;
-}
-float   operator*(Vector4 const& V1, Vector4 const& V2) { return es::Dot(V1, V2); }
-Vector4 operator-(Vector4 const& V1, Vector4 const& V2) { return es::Sub(V1, V2); }
-bool    operator==(Vector4 const& V1, Vector4 const& V2) { return es::Eq(V1, V2); }
-
 /**
  */
 std::ostream& operator<<(std::ostream& stream, const Vector4& T) {
@@ -375,3 +540,21 @@ std::ostream& operator<<(std::ostream& stream, const Matrix& M) {
          << M.m11 << " " << std::fixed << std::setprecision(P) << std::setw(W) << M.m15 << "\n";
   return stream;
 }
+
+/**
+ */
+std::ostream& operator<<(std::ostream& stream, const es::matrix4_double& M) {
+  // ---
+  // NOTE: The width need to be big enough to hold a negative sign.
+  // ---
+  size_t const P{5};
+  size_t const W{P + 5};
+  auto const*  pM = reinterpret_cast<double const*>(&M);
+  stream << "Matrix\n";
+  for (int Row = 0; Row < 4; ++Row) {
+    for (int Col = 0; Col < 4; ++Col)
+      stream << " " << std::fixed << std::setprecision(P) << std::setw(W) << pM[4 * Row + Col];
+    stream << "\n";
+  }
+  return stream;
+}
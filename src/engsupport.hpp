@@ -12,7 +12,22 @@
 
 #include "raylib.h"
 #include "raymath.h"
+#include <algorithm>
+#include <array>
+#include <concepts>
 #include <iostream>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// ---
+// NOTE: The core of es is constexpr and defined in this header, so that fixed transforms
+//       fold at compile time and chains of operators inline at the call site. Only the
+//       SIMD kernels, the batched transforms and the printing live in engsupport.cpp.
+//       Compile time evaluation takes the plain loops, which add in the same order as
+//       the SIMD kernels used at run time.
+// ---
 
 /**
  * es - engineering support namespace
@@ -22,15 +37,201 @@ namespace es // aka engineering support
 //------------------------------------------------------------------------------
 void Assert(bool Condition, char const* pCaller, int Line = 0);
 
+// Vector4Double, 4 components
+struct vector4_double {
+  double x{}; // Vector x component
+  double y{}; // Vector y component
+  double z{}; // Vector z component
+  double w{}; // Vector w component
+};
+
+//------------------------------------------------------------------------------
+/**
+ * Matrix in double precision, with the same layout and element names as Matrix.
+ * Used where float runs out, like the conversion from pixels to engineering values
+ * at deep zoom where a pixel is 1e-9 units.
+ */
+struct matrix4_double {
+  double m0{}, m4{}, m8{}, m12{};  // Matrix first row (4 components)
+  double m1{}, m5{}, m9{}, m13{};  // Matrix second row (4 components)
+  double m2{}, m6{}, m10{}, m14{}; // Matrix third row (4 components)
+  double m3{}, m7{}, m11{}, m15{}; // Matrix fourth row (4 components)
+};
+
+//------------------------------------------------------------------------------
+/**
+ * 2D scale and offset, x' = Scale.x * x + Offset.x and y' = Scale.y * y + Offset.y.
+ * All the mappings between grid, engineering and pixel space are of this form, and a
+ * point costs 4 flops instead of the 16 multiply-adds of a Matrix.
+ */
+struct affine2 {
+  Vector2 Scale{1.f, 1.f};
+  Vector2 Offset{};
+};
+
+/**
+ * Axis aligned rectangle in x and y, for culling. The default is empty and does not
+ * intersect anything.
+ */
+struct bounds2 {
+  float MinX{std::numeric_limits<float>::infinity()};
+  float MinY{std::numeric_limits<float>::infinity()};
+  float MaxX{-std::numeric_limits<float>::infinity()};
+  float MaxY{-std::numeric_limits<float>::infinity()};
+};
+
+namespace detail {
+
+/**
+ * The 16 elements of a matrix, row by row, so element (Row, Col) is at 4 * Row + Col.
+ * The aggregate initialization order of Matrix and matrix4_double is the same.
+ */
+template <typename M> constexpr auto Elements(M const& In) {
+  using scalar = std::remove_cvref_t<decltype(In.m0)>;
+  return std::array<scalar, 16>{In.m0,
+                                In.m4,
+                                In.m8,
+                                In.m12,
+                                In.m1,
+                                In.m5,
+                                In.m9,
+                                In.m13,
+                                In.m2,
+                                In.m6,
+                                In.m10,
+                                In.m14,
+                                In.m3,
+                                In.m7,
+                                In.m11,
+                                In.m15};
+}
+
+template <typename M, typename T> constexpr auto FromElements(std::array<T, 16> const& E) -> M {
+  return M{E[0], E[1], E[2], E[3], E[4], E[5], E[6], E[7], E[8], E[9], E[10], E[11], E[12], E[13], E[14], E[15]};
+}
+
+/**
+ * The 2x2 determinants of the upper two and lower two rows, shared by Determinant and Invert.
+ */
+template <typename T> struct sub_factors {
+  std::array<T, 16> A{};
+  T                 B[12]{};
+  T                 Det{};
+};
+
+template <typename T> constexpr auto SubFactors(std::array<T, 16> const& In) -> sub_factors<T> {
+  sub_factors<T> S{};
+  S.A = In;
+
+  // ---
+  // NOTE: a(r, c) in the usual notation is A[4 * r + c].
+  // ---
+  auto const& A = S.A;
+  S.B[0]        = A[0] * A[5] - A[1] * A[4];
+  S.B[1]        = A[0] * A[6] - A[2] * A[4];
+  S.B[2]        = A[0] * A[7] - A[3] * A[4];
+  S.B[3]        = A[1] * A[6] - A[2] * A[5];
+  S.B[4]        = A[1] * A[7] - A[3] * A[5];
+  S.B[5]        = A[2] * A[7] - A[3] * A[6];
+  S.B[6]        = A[8] * A[13] - A[9] * A[12];
+  S.B[7]        = A[8] * A[14] - A[10] * A[12];
+  S.B[8]        = A[8] * A[15] - A[11] * A[12];
+  S.B[9]        = A[9] * A[14] - A[10] * A[13];
+  S.B[10]       = A[9] * A[15] - A[11] * A[13];
+  S.B[11]       = A[10] * A[15] - A[11] * A[14];
+
+  auto const* B = S.B;
+  S.Det         = B[0] * B[11] - B[1] * B[10] + B[2] * B[9] + B[3] * B[8] - B[4] * B[7] + B[5] * B[6];
+  return S;
+}
+
+/**
+ * Adjugate divided by the determinant, which must not be zero.
+ */
+template <typename T> constexpr auto InvertSubFactors(sub_factors<T> const& S) -> std::array<T, 16> {
+  auto const& A      = S.A;
+  auto const* B      = S.B;
+  auto const  InvDet = T(1) / S.Det;
+
+  std::array<T, 16> R{};
+  R[0]  = (A[5] * B[11] - A[6] * B[10] + A[7] * B[9]) * InvDet;
+  R[1]  = (-A[1] * B[11] + A[2] * B[10] - A[3] * B[9]) * InvDet;
+  R[2]  = (A[13] * B[5] - A[14] * B[4] + A[15] * B[3]) * InvDet;
+  R[3]  = (-A[9] * B[5] + A[10] * B[4] - A[11] * B[3]) * InvDet;
+  R[4]  = (-A[4] * B[11] + A[6] * B[8] - A[7] * B[7]) * InvDet;
+  R[5]  = (A[0] * B[11] - A[2] * B[8] + A[3] * B[7]) * InvDet;
+  R[6]  = (-A[12] * B[5] + A[14] * B[2] - A[15] * B[1]) * InvDet;
+  R[7]  = (A[8] * B[5] - A[10] * B[2] + A[11] * B[1]) * InvDet;
+  R[8]  = (A[4] * B[10] - A[5] * B[8] + A[7] * B[6]) * InvDet;
+  R[9]  = (-A[0] * B[10] + A[1] * B[8] - A[3] * B[6]) * InvDet;
+  R[10] = (A[12] * B[4] - A[13] * B[2] + A[15] * B[0]) * InvDet;
+  R[11] = (-A[8] * B[4] + A[9] * B[2] - A[11] * B[0]) * InvDet;
+  R[12] = (-A[4] * B[9] + A[5] * B[7] - A[6] * B[6]) * InvDet;
+  R[13] = (A[0] * B[9] - A[1] * B[7] + A[2] * B[6]) * InvDet;
+  R[14] = (-A[12] * B[3] + A[13] * B[1] - A[14] * B[0]) * InvDet;
+  R[15] = (A[8] * B[3] - A[9] * B[1] + A[10] * B[0]) * InvDet;
+  return R;
+}
+
+/**
+ * Row i of the result is the rows of M2 weighted by row i of M1, summed in order.
+ */
+template <typename M> constexpr auto MulScalar(M const& M1, M const& M2) -> M {
+  auto const A = Elements(M1);
+  auto const B = Elements(M2);
+  auto       R = A;
+  for (int Row = 0; Row < 4; ++Row) {
+    for (int Col = 0; Col < 4; ++Col) {
+      R[4 * Row + Col] = A[4 * Row] * B[Col] + A[4 * Row + 1] * B[4 + Col] + A[4 * Row + 2] * B[8 + Col] +
+                         A[4 * Row + 3] * B[12 + Col];
+    }
+  }
+  return FromElements<M>(R);
+}
+
+/**
+ * The SIMD kernels used at run time, in engsupport.cpp. SSE for float Matrix times Vector4,
+ * AVX or SSE for the other products, and SSE2 for the double ones without AVX.
+ */
+Vector4        MulSimd(Matrix const& M, Vector4 const& V);
+Matrix         MulSimd(Matrix const& M1, Matrix const& M2);
+vector4_double MulSimd(matrix4_double const& M, vector4_double const& V);
+matrix4_double MulSimd(matrix4_double const& M1, matrix4_double const& M2);
+
+}; // namespace detail
+
 /**
  * Identity matrix 4x4
  */
-Matrix I();
+constexpr Matrix I() {
+  Matrix M{};
+  M.m0  = 1.f;
+  M.m5  = 1.f;
+  M.m10 = 1.f;
+  M.m15 = 1.f;
+  return M;
+}
+
+/**
+ * Determinant of a 4x4 matrix, by Laplace expansion along the upper two rows.
+ */
+constexpr float Determinant(Matrix const& In) { return detail::SubFactors(detail::Elements(In)).Det; }
 
 /**
  * Compute the determinant and check it to find out if matrix is invertible.
  */
-bool IsMatrixInvertible(Matrix const& In);
+constexpr bool IsMatrixInvertible(Matrix const& In) { return Determinant(In) != 0.0f; }
+
+/**
+ * General inverse of a 4x4 matrix. Use instead of MatrixInvert from raymath.
+ * A singular matrix gives the zero matrix.
+ */
+constexpr Matrix Invert(Matrix const& In) {
+  auto const S = detail::SubFactors(detail::Elements(In));
+  if (S.Det == 0.f)
+    return Matrix{};
+  return detail::FromElements<Matrix>(detail::InvertSubFactors(S));
+}
 
 //------------------------------------------------------------------------------
 /**
@@ -38,17 +239,40 @@ bool IsMatrixInvertible(Matrix const& In);
  * Screen space is a floating point representation with x,y,z = 0,0,0 beeing at
  * the middle of the window.
  */
-Matrix InitTranslationInv(Matrix const& M, Vector4 const& vTranslation);
+constexpr Matrix InitTranslationInv(Matrix const& M, Vector4 const& vTranslation) {
+  Matrix Mat = M;
+  Mat.m0     = 1.f * M.m0;
+  Mat.m5     = 1.f * M.m5;
+  Mat.m10    = 1.f * M.m10;
+  Mat.m12    = -vTranslation.x;
+  Mat.m13    = -vTranslation.y;
+  Mat.m14    = -vTranslation.z;
+  Mat.m15    = 1.f;
+
+  return Mat;
+}
 
 /**
  * Use a Homogenous matrix to store a translation.
  */
-auto SetTranslation(Vector4 const& Translation) -> Matrix;
+constexpr auto SetTranslation(Vector4 const& Translation) -> Matrix {
+  auto Result = I();
+  Result.m12  = Translation.x;
+  Result.m13  = Translation.y;
+  Result.m14  = Translation.z;
+  return Result;
+}
 
 /**
  * Set scaling for x,y,z. Use negative numbers to flip the direction.
  */
-auto SetScaling(Vector4 const& Scale) -> Matrix;
+constexpr auto SetScaling(Vector4 const& Scale) -> Matrix {
+  auto Result = I();
+  Result.m0   = Scale.x;
+  Result.m5   = Scale.y;
+  Result.m10  = Scale.z;
+  return Result;
+}
 
 /**
  * Defintions: A point in 3D space has w set to 1.
@@ -57,8 +281,8 @@ auto SetScaling(Vector4 const& Scale) -> Matrix;
  *             And Adding a Vector to a Point gives a new Point.
  *             And there is no meaning in adding Points since w would not be 1.
  */
-Vector4 Point(float X, float Y, float Z);
-Vector4 Point(Vector3 const& V);
+constexpr Vector4 Point(float X, float Y, float Z) { return Vector4{X, Y, Z, 1.f}; }
+constexpr Vector4 Point(Vector3 const& V) { return Point(V.x, V.y, V.z); }
 
 /**
  * Defintions: A point in 3D space has w set to 1.
@@ -67,20 +291,92 @@ Vector4 Point(Vector3 const& V);
  *             And Adding a Vector to a Point gives a new Point.
  *             And there is no meaning in adding Points since w would not be 1.
  */
-Vector4 Vector(float X, float Y, float Z);
-Vector4 Vector(Vector3 const& V);
-Vector4 Normalize(Vector4 const &V);
+constexpr Vector4 Vector(float X, float Y, float Z) { return Vector4{X, Y, Z, 0.f}; }
+constexpr Vector4 Vector(Vector3 const& V) { return Vector(V.x, V.y, V.z); }
+Vector4           Normalize(Vector4 const& V);
 
-// Vector4Double, 4 components
-struct vector4_double {
-  double x{}; // Vector x component
-  double y{}; // Vector y component
-  double z{}; // Vector z component
-  double w{}; // Vector w component
-};
+constexpr vector4_double VectorDouble(double X, double Y, double Z) { return vector4_double{X, Y, Z, 0.}; }
+constexpr vector4_double VectorDouble(Vector4 const& V) { return vector4_double{V.x, V.y, V.z, V.w}; }
+constexpr vector4_double PointDouble(double X, double Y, double Z) { return vector4_double{X, Y, Z, 1.}; }
+constexpr auto           ToVector4(vector4_double const& V) -> Vector4 {
+  return Vector4{float(V.x), float(V.y), float(V.z), float(V.w)};
+}
+
+//------------------------------------------------------------------------------
+constexpr auto IDouble() -> matrix4_double {
+  matrix4_double M{};
+  M.m0  = 1.;
+  M.m5  = 1.;
+  M.m10 = 1.;
+  M.m15 = 1.;
+  return M;
+}
+
+auto MatrixDouble(Matrix const& M) -> matrix4_double;
+auto ToMatrix(matrix4_double const& M) -> Matrix;
+
+constexpr auto Determinant(matrix4_double const& In) -> double {
+  return detail::SubFactors(detail::Elements(In)).Det;
+}
+
+constexpr auto IsMatrixInvertible(matrix4_double const& In) -> bool { return Determinant(In) != 0.; }
+
+/**
+ * Closed form inverse as for Matrix. A singular matrix gives the zero matrix.
+ */
+constexpr auto Invert(matrix4_double const& In) -> matrix4_double {
+  auto const S = detail::SubFactors(detail::Elements(In));
+  if (S.Det == 0.)
+    return matrix4_double{};
+  return detail::FromElements<matrix4_double>(detail::InvertSubFactors(S));
+}
+
+constexpr auto SetTranslation(vector4_double const& Translation) -> matrix4_double {
+  auto Result = IDouble();
+  Result.m12  = Translation.x;
+  Result.m13  = Translation.y;
+  Result.m14  = Translation.z;
+  return Result;
+}
 
-vector4_double VectorDouble(double X, double Y, double Z);
-vector4_double VectorDouble(Vector4 const& V);
+constexpr auto SetScaling(vector4_double const& Scale) -> matrix4_double {
+  auto Result = IDouble();
+  Result.m0   = Scale.x;
+  Result.m5   = Scale.y;
+  Result.m10  = Scale.z;
+  return Result;
+}
+
+/**
+ * Each element is (a0 * x + a1 * y) + (a2 * z + a3 * w) on all paths, which is the order
+ * the AVX horizontal adds give.
+ */
+constexpr auto Mul(matrix4_double const& M, vector4_double const& V) -> vector4_double {
+  if (!std::is_constant_evaluated())
+    return detail::MulSimd(M, V);
+  return vector4_double{(M.m0 * V.x + M.m4 * V.y) + (M.m8 * V.z + M.m12 * V.w),
+                        (M.m1 * V.x + M.m5 * V.y) + (M.m9 * V.z + M.m13 * V.w),
+                        (M.m2 * V.x + M.m6 * V.y) + (M.m10 * V.z + M.m14 * V.w),
+                        (M.m3 * V.x + M.m7 * V.y) + (M.m11 * V.z + M.m15 * V.w)};
+}
+
+constexpr auto Mul(matrix4_double const& M1, matrix4_double const& M2) -> matrix4_double {
+  if (!std::is_constant_evaluated())
+    return detail::MulSimd(M1, M2);
+  return detail::MulScalar(M1, M2);
+}
+
+constexpr auto Add(matrix4_double const& M1, matrix4_double const& M2) -> matrix4_double {
+  auto R       = detail::Elements(M1);
+  auto const B = detail::Elements(M2);
+  for (size_t Idx = 0; Idx < R.size(); ++Idx)
+    R[Idx] += B[Idx];
+  return detail::FromElements<matrix4_double>(R);
+}
+
+constexpr auto Eq(matrix4_double const& M1, matrix4_double const& M2) -> bool {
+  return detail::Elements(M1) == detail::Elements(M2);
+}
 
 //------------------------------------------------------------------------------
 /**
@@ -88,53 +384,419 @@ vector4_double VectorDouble(Vector4 const& V);
  * Screen space is a floating point representation with x,y,z = 0,0,0 beeing at
  * the middle of the window.
  */
-Matrix InitScaling(Matrix const& M, Vector4 const& Scale, bool Reflection = false);
+constexpr Matrix InitScaling(Matrix const& M, Vector4 const& Scale, bool Reflection = false) {
+  Matrix     Mat  = M;
+  auto const Sign = Reflection ? -1.f : 1.f;
+  Mat.m0          = Sign * Scale.x;
+  Mat.m5          = Sign * Scale.y;
+  Mat.m10         = Sign * Scale.z;
+  Mat.m15         = 1.f;
+
+  return Mat;
+}
 
 /**
  * Return the result of multiplication of a Matrix and a Vector, dimension 4.
+ * Uses SSE when available, as does Mul for two matrices, which uses AVX when built with it.
+ */
+constexpr Vector4 Mul(Matrix const& M, Vector4 const& V) {
+  if (!std::is_constant_evaluated())
+    return detail::MulSimd(M, V);
+  return Vector4{M.m0 * V.x + M.m4 * V.y + M.m8 * V.z + M.m12 * V.w,
+                 M.m1 * V.x + M.m5 * V.y + M.m9 * V.z + M.m13 * V.w,
+                 M.m2 * V.x + M.m6 * V.y + M.m10 * V.z + M.m14 * V.w,
+                 M.m3 * V.x + M.m7 * V.y + M.m11 * V.z + M.m15 * V.w};
+}
+
+//------------------------------------------------------------------------------
+/**
+ * Adding keeps w at most 1, so a point plus a vector stays a point.
  */
-Vector4 Mul(Matrix const& M, Vector4 const& V);
+constexpr Vector4 Add(Vector4 const& V1, Vector4 const& V2) {
+  return Vector4{V1.x + V2.x, V1.y + V2.y, V1.z + V2.z, std::min(1.f, V1.w + V2.w)};
+}
+
+constexpr vector4_double Add(vector4_double const& V1, vector4_double const& V2) {
+  return vector4_double{V1.x + V2.x, V1.y + V2.y, V1.z + V2.z, std::min(1., V1.w + V2.w)};
+}
+
+/**
+ * Dot product.
+ */
+constexpr float Dot(Vector4 const& V1, Vector4 const& V2) {
+  return V1.x * V2.x + V1.y * V2.y + V1.z * V2.z + V1.w * V2.w;
+}
+
+//------------------------------------------------------------------------------
+/**
+ * Multiplication will keep w unchanged.
+ */
+constexpr Vector4 Mul(Vector4 const& V1, float t) { return Vector4{V1.x * t, V1.y * t, V1.z * t, V1.w}; }
+
+/**
+ * Subtracting two vectors gives a new vector
+ * Subtracting two points gives a vector
+ * Subtracting vectors with point and vice versa has no meaning.
+ */
+constexpr Vector4 Sub(Vector4 const& V1, Vector4 const& V2) {
+  return Vector4{V1.x - V2.x, V1.y - V2.y, V1.z - V2.z, V1.w - V2.w};
+}
+
+//------------------------------------------------------------------------------
+constexpr Matrix Add(Matrix const& M1, Matrix const& M2) {
+  auto R       = detail::Elements(M1);
+  auto const B = detail::Elements(M2);
+  for (size_t Idx = 0; Idx < R.size(); ++Idx)
+    R[Idx] += B[Idx];
+  return detail::FromElements<Matrix>(R);
+}
+
+//------------------------------------------------------------------------------
+constexpr bool Eq(Matrix const& M1, Matrix const& M2) { return detail::Elements(M1) == detail::Elements(M2); }
+constexpr bool Eq(Vector4 const& V1, Vector4 const& V2) {
+  return V1.x == V2.x && V1.y == V2.y && V1.z == V2.z && V1.w == V2.w;
+}
 
 //------------------------------------------------------------------------------
-float Dot(Vector4 const& V1, Vector4 const& V2);
+Vector4 constexpr Lerp(Vector4 const& A, Vector4 const& B, float t);
 
 //------------------------------------------------------------------------------
-Vector4 Mul(Vector4 const& V1, float t);
+constexpr Matrix Mul(Matrix const& M1, Matrix const& M2) {
+  if (!std::is_constant_evaluated())
+    return detail::MulSimd(M1, M2);
+  return detail::MulScalar(M1, M2);
+}
 
 //------------------------------------------------------------------------------
-Matrix Add(Matrix const& M1, Matrix const& M2);
+/**
+ * The scale and translation in x and y of M, which must not rotate or shear.
+ */
+constexpr auto Affine2(Matrix const& M) -> affine2 {
+  if (0.f != M.m1 || 0.f != M.m4)
+    Assert(false, __func__, __LINE__);
+  return affine2{{M.m0, M.m5}, {M.m12, M.m13}};
+}
+
+constexpr auto Affine2(matrix4_double const& M) -> affine2 {
+  if (0. != M.m1 || 0. != M.m4)
+    Assert(false, __func__, __LINE__);
+  return affine2{{float(M.m0), float(M.m5)}, {float(M.m12), float(M.m13)}};
+}
+
+/**
+ * The same mapping as a homogenous matrix. z is left as is.
+ */
+constexpr auto ToMatrix(affine2 const& A) -> Matrix {
+  auto M = I();
+  M.m0   = A.Scale.x;
+  M.m5   = A.Scale.y;
+  M.m12  = A.Offset.x;
+  M.m13  = A.Offset.y;
+  return M;
+}
+
+constexpr auto IsInvertible(affine2 const& A) -> bool { return 0.f != A.Scale.x && 0.f != A.Scale.y; }
+
+/**
+ * Closed form inverse, x = (x' - Offset) / Scale. A zero scale gives the zero transform,
+ * like Invert(Matrix).
+ */
+constexpr auto Invert(affine2 const& A) -> affine2 {
+  if (!IsInvertible(A))
+    return affine2{{0.f, 0.f}, {0.f, 0.f}};
+
+  auto const Sx = 1.f / A.Scale.x;
+  auto const Sy = 1.f / A.Scale.y;
+  return affine2{{Sx, Sy}, {-A.Offset.x * Sx, -A.Offset.y * Sy}};
+}
+
+//------------------------------------------------------------------------------
+/**
+ * The rectangle with corners (X0, Y0) and (X1, Y1), in any order.
+ */
+constexpr auto Bounds(float X0, float Y0, float X1, float Y1) -> bounds2 {
+  return bounds2{std::min(X0, X1), std::min(Y0, Y1), std::max(X0, X1), std::max(Y0, Y1)};
+}
+
+constexpr auto IsEmpty(bounds2 const& B) -> bool { return B.MinX > B.MaxX || B.MinY > B.MaxY; }
+
+constexpr auto Expand(bounds2& B, float X, float Y) -> void {
+  B.MinX = std::min(B.MinX, X);
+  B.MinY = std::min(B.MinY, Y);
+  B.MaxX = std::max(B.MaxX, X);
+  B.MaxY = std::max(B.MaxY, Y);
+}
+
+constexpr auto Intersects(bounds2 const& A, bounds2 const& B) -> bool {
+  return !IsEmpty(A) && !IsEmpty(B) && A.MinX <= B.MaxX && B.MinX <= A.MaxX && A.MinY <= B.MaxY && B.MinY <= A.MaxY;
+}
+
+constexpr auto Contains(bounds2 const& Outer, bounds2 const& Inner) -> bool {
+  return Outer.MinX <= Inner.MinX && Inner.MaxX <= Outer.MaxX && Outer.MinY <= Inner.MinY && Inner.MaxY <= Outer.MaxY;
+}
+
+/**
+ * B made larger by Fraction of its width and height on each side.
+ */
+constexpr auto Grow(bounds2 const& B, float Fraction) -> bounds2 {
+  auto const DX = (B.MaxX - B.MinX) * Fraction;
+  auto const DY = (B.MaxY - B.MinY) * Fraction;
+  return bounds2{B.MinX - DX, B.MinY - DY, B.MaxX + DX, B.MaxY + DY};
+}
+
+/**
+ * B mapped with A. A negative scale swaps min and max.
+ */
+constexpr auto Transform(affine2 const& A, bounds2 const& B) -> bounds2 {
+  return Bounds(A.Scale.x * B.MinX + A.Offset.x,
+                A.Scale.y * B.MinY + A.Offset.y,
+                A.Scale.x * B.MaxX + A.Offset.x,
+                A.Scale.y * B.MaxY + A.Offset.y);
+}
 
 //------------------------------------------------------------------------------
-bool Eq(Matrix const& M1, Matrix const& M2);
-bool Eq(Vector4 const& V1, Vector4 const& V2);
+/**
+ * Number of points from which TransformPoints splits the work over threads.
+ */
+constexpr size_t TransformPointsParallelThreshold = size_t(1) << 19;
+
+/**
+ * Transform the points (Xs[i], Ys[i], 0, 1) with M and store x and y of the results,
+ * the same as (M * Point(Xs[i], Ys[i], 0)).x and .y, for all points in one SIMD pass.
+ * Matrices without rotation or shear take the same scale and offset path as affine2.
+ * The outputs must be at least as long as Xs, and may be the inputs (in place), but
+ * must not overlap them otherwise.
+ */
+auto TransformPoints(Matrix const&          M,
+                     std::span<float const> Xs,
+                     std::span<float const> Ys,
+                     std::span<float>       OutX,
+                     std::span<float>       OutY) -> void;
+auto TransformPoints(affine2 const&         A,
+                     std::span<float const> Xs,
+                     std::span<float const> Ys,
+                     std::span<float>       OutX,
+                     std::span<float>       OutY) -> void;
 
 //------------------------------------------------------------------------------
-Vector4 Lerp(Vector4 const& A, Vector4 const& B, float t);
+/**
+ * Return vector containing the elements on the diagonal of a Matrix.
+ * Can be used for pulling out resolution.
+ */
+constexpr auto DiagVector(Matrix const& MhE2P) -> Vector4 { return Vector(MhE2P.m0, MhE2P.m5, MhE2P.m10); }
+auto           DiagVectorAbs(Matrix const& MhE2P) -> Vector4;
+constexpr auto V4ToV3(Vector4 const& V) -> Vector3 { return Vector3{V.x, V.y, V.z}; }
 
 //------------------------------------------------------------------------------
-Matrix Mul(Matrix const& M1, Matrix const& M2);
+/**
+ * Coordinate frames in a tree, like pixel, engineering and grid space, or the links of a
+ * robot. Each frame has a local transform into its parent, and caches the transform into
+ * the root (World) and back (WorldInv). Changing a frame marks it and all frames below it
+ * dirty, and the cached values are recomputed when they are read, so a frame changed many
+ * times between two reads is composed and inverted once.
+ */
+using frame_id = size_t;
+
+struct transform_frame {
+  frame_id              Parent{};
+  matrix4_double        Local{IDouble()};    //!< From this frame into the parent frame.
+  matrix4_double        World{IDouble()};    //!< From this frame into the root frame.
+  matrix4_double        WorldInv{IDouble()}; //!< From the root frame into this frame.
+  bool                  WorldDirty{};
+  bool                  WorldInvDirty{};
+  std::vector<frame_id> vChildren{};
+};
+
+struct transform_graph {
+  static constexpr frame_id Root = 0;
+
+  std::vector<transform_frame> vFrames{transform_frame{}}; //!< The root frame is the identity.
+  size_t                       NumInversions{};            //!< Number of WorldInv recomputations.
+};
+
+/**
+ * Add a frame below Parent, return its id.
+ */
+auto AddFrame(transform_graph& Graph, matrix4_double const& Local, frame_id Parent = transform_graph::Root)
+    -> frame_id;
+auto SetLocal(transform_graph& Graph, frame_id Frame, matrix4_double const& Local) -> void;
+auto Local(transform_graph const& Graph, frame_id Frame) -> matrix4_double const&;
+auto World(transform_graph& Graph, frame_id Frame) -> matrix4_double const&;
+auto WorldInv(transform_graph& Graph, frame_id Frame) -> matrix4_double const&;
+
+/**
+ * From frame From into frame To, WorldInv(To) * World(From).
+ */
+auto Between(transform_graph& Graph, frame_id From, frame_id To) -> matrix4_double;
 
 //------------------------------------------------------------------------------
-auto DiagVector(Matrix const& MhE2P) -> Vector4;
-auto DiagVectorAbs(Matrix const& MhE2P) -> Vector4;
-auto V4ToV3(Vector4 const& V) -> Vector3;
+/**
+ * Expression templates for Vector4. An expression is built from xpr::Val(V) and the
+ * operators +, - and * float, and is evaluated by Eval, or by a Matrix or affine2 product,
+ * one component at a time in a single pass without the temporaries of the eager operators.
+ * The rules for w are the same as for Add, Sub and Mul, so the results are identical.
+ *
+ *   auto const PixPosEnd = E2P * (es::xpr::Val(Pos) + Dim);
+ *
+ * The nodes hold their operands by value, so an expression can be kept in a variable.
+ */
+namespace xpr {
+
+template <typename T>
+concept expression = requires(T const& E, int Idx) {
+  { E.Get(Idx) } -> std::convertible_to<float>;
+};
+
+/**
+ * Leaf of an expression.
+ */
+struct val {
+  Vector4 V{};
+
+  constexpr auto Get(int Idx) const -> float { return 0 == Idx ? V.x : 1 == Idx ? V.y : 2 == Idx ? V.z : V.w; }
+};
+
+template <expression L, expression R> struct sum {
+  L Lhs{};
+  R Rhs{};
+
+  constexpr auto Get(int Idx) const -> float {
+    return Idx < 3 ? Lhs.Get(Idx) + Rhs.Get(Idx) : std::min(1.f, Lhs.Get(3) + Rhs.Get(3));
+  }
+};
+
+template <expression L, expression R> struct difference {
+  L Lhs{};
+  R Rhs{};
+
+  constexpr auto Get(int Idx) const -> float { return Lhs.Get(Idx) - Rhs.Get(Idx); }
+};
+
+template <expression E> struct scaled {
+  E     Expr{};
+  float t{};
+
+  constexpr auto Get(int Idx) const -> float { return Idx < 3 ? Expr.Get(Idx) * t : Expr.Get(3); }
+};
+
+constexpr auto Val(Vector4 const& V) -> val { return val{V}; }
+constexpr auto Wrap(Vector4 const& V) -> val { return val{V}; }
+template <expression E> constexpr auto Wrap(E const& Expr) -> E { return Expr; }
+
+template <typename T>
+concept operand = expression<T> || std::same_as<T, Vector4>;
+
+template <typename T> using node = decltype(Wrap(std::declval<T const&>()));
+
+template <operand L, operand R>
+  requires(expression<L> || expression<R>)
+constexpr auto operator+(L const& Lhs, R const& Rhs) -> sum<node<L>, node<R>> {
+  return {Wrap(Lhs), Wrap(Rhs)};
+}
+
+template <operand L, operand R>
+  requires(expression<L> || expression<R>)
+constexpr auto operator-(L const& Lhs, R const& Rhs) -> difference<node<L>, node<R>> {
+  return {Wrap(Lhs), Wrap(Rhs)};
+}
+
+template <expression E> constexpr auto operator*(E const& Expr, float t) -> scaled<E> { return {Expr, t}; }
+
+/**
+ * All four components in one pass.
+ */
+template <operand E> constexpr auto Eval(E const& Expr) -> Vector4 {
+  auto const N = Wrap(Expr);
+  return Vector4{N.Get(0), N.Get(1), N.Get(2), N.Get(3)};
+}
+
+template <expression E> constexpr auto operator*(Matrix const& M, E const& Expr) -> Vector4 {
+  return Mul(M, Eval(Expr));
+}
+
+template <expression E> constexpr auto operator*(affine2 const& A, E const& Expr) -> Vector4 {
+  auto const W = Expr.Get(3);
+  return Vector4{A.Scale.x * Expr.Get(0) + A.Offset.x * W, A.Scale.y * Expr.Get(1) + A.Offset.y * W, Expr.Get(2), W};
+}
+
+}; // namespace xpr
+
+/**
+ * Defined after xpr since it is one fused expression.
+ */
+constexpr Vector4 Lerp(Vector4 const& A, Vector4 const& B, float t) {
+  if (t < 0.f || t > 1.f)
+    return {};
+  return xpr::Eval(xpr::Val(A) + (xpr::Val(B) - A) * t);
+}
+
 }; // namespace es
 
-Matrix              operator*(Matrix const& M1, Matrix const& M2);
-Matrix              operator+(Matrix const& M1, Matrix const& M2);
-bool                operator==(Matrix const& M1, Matrix const& M2);
-bool                operator!=(Matrix const& M1, Matrix const& M2);
-Vector4             operator*(Matrix const& M, Vector4 const& V);
-float               operator*(Vector4 const& V1, Vector4 const& V2);
-Vector4             operator*(Vector4 const& V1, float t);
-Vector4             operator+(Vector4 const& V1, Vector4 const& V2);
-Vector4             operator-(Vector4 const& V1, Vector4 const& V2);
-bool                operator==(Vector4 const& V1, Vector4 const& V2);
-es::vector4_double  operator+(es::vector4_double const& V1, es::vector4_double const& V2);
-es::vector4_double& operator+=(es::vector4_double& LHS, es::vector4_double const& RHS);
+constexpr Matrix  operator*(Matrix const& M1, Matrix const& M2) { return es::Mul(M1, M2); }
+constexpr Matrix  operator+(Matrix const& M1, Matrix const& M2) { return es::Add(M1, M2); }
+constexpr bool    operator==(Matrix const& M1, Matrix const& M2) { return es::Eq(M1, M2); }
+constexpr bool    operator!=(Matrix const& M1, Matrix const& M2) { return !(M1 == M2); }
+constexpr Vector4 operator*(Matrix const& M, Vector4 const& V) { return es::Mul(M, V); }
+constexpr float   operator*(Vector4 const& V1, Vector4 const& V2) { return es::Dot(V1, V2); }
+constexpr Vector4 operator*(Vector4 const& V1, float t) { return es::Mul(V1, t); }
+constexpr Vector4 operator+(Vector4 const& V1, Vector4 const& V2) { return es::Add(V1, V2); }
+constexpr Vector4 operator-(Vector4 const& V1, Vector4 const& V2) { return es::Sub(V1, V2); }
+constexpr bool    operator==(Vector4 const& V1, Vector4 const& V2) { return es::Eq(V1, V2); }
+
+constexpr es::vector4_double operator+(es::vector4_double const& V1, es::vector4_double const& V2) {
+  return es::Add(V1, V2);
+}
+constexpr es::vector4_double& operator+=(es::vector4_double& LHS, es::vector4_double const& RHS) {
+  LHS = es::Add(LHS, RHS);
+  return LHS;
+}
+constexpr es::vector4_double operator-(es::vector4_double const& V1, es::vector4_double const& V2) {
+  return es::vector4_double{V1.x - V2.x, V1.y - V2.y, V1.z - V2.z, V1.w - V2.w};
+}
+constexpr es::vector4_double operator*(es::vector4_double const& V1, double t) {
+  return es::vector4_double{V1.x * t, V1.y * t, V1.z * t, V1.w};
+}
+constexpr double operator*(es::vector4_double const& V1, es::vector4_double const& V2) {
+  return V1.x * V2.x + V1.y * V2.y + V1.z * V2.z + V1.w * V2.w;
+}
+constexpr bool operator==(es::vector4_double const& V1, es::vector4_double const& V2) {
+  return V1.x == V2.x && V1.y == V2.y && V1.z == V2.z && V1.w == V2.w;
+}
+constexpr es::matrix4_double operator*(es::matrix4_double const& M1, es::matrix4_double const& M2) {
+  return es::Mul(M1, M2);
+}
+constexpr es::matrix4_double operator+(es::matrix4_double const& M1, es::matrix4_double const& M2) {
+  return es::Add(M1, M2);
+}
+constexpr bool operator==(es::matrix4_double const& M1, es::matrix4_double const& M2) { return es::Eq(M1, M2); }
+constexpr bool operator!=(es::matrix4_double const& M1, es::matrix4_double const& M2) { return !(M1 == M2); }
+constexpr es::vector4_double operator*(es::matrix4_double const& M, es::vector4_double const& V) {
+  return es::Mul(M, V);
+}
+
+/**
+ * Apply B first and then A, the same order as for Matrix.
+ */
+constexpr es::affine2 operator*(es::affine2 const& A, es::affine2 const& B) {
+  return es::affine2{{A.Scale.x * B.Scale.x, A.Scale.y * B.Scale.y},
+                     {A.Scale.x * B.Offset.x + A.Offset.x, A.Scale.y * B.Offset.y + A.Offset.y}};
+}
+
+constexpr Vector2 operator*(es::affine2 const& A, Vector2 const& P) {
+  return Vector2{A.Scale.x * P.x + A.Offset.x, A.Scale.y * P.y + A.Offset.y};
+}
+
+/**
+ * Same as ToMatrix(A) * V. The offset is weighted by w, so that points are moved and
+ * vectors only scaled.
+ */
+constexpr Vector4 operator*(es::affine2 const& A, Vector4 const& V) {
+  return Vector4{A.Scale.x * V.x + A.Offset.x * V.w, A.Scale.y * V.y + A.Offset.y * V.w, V.z, V.w};
+}
 
 std::ostream& operator<<(std::ostream& stream, const Vector4& T);
 std::ostream& operator<<(std::ostream& stream, const es::vector4_double& T);
 std::ostream& operator<<(std::ostream& stream, const Matrix& M);
+std::ostream& operator<<(std::ostream& stream, const es::matrix4_double& M);
 
 #endif
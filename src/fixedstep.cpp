@@ -0,0 +1,82 @@
+/**
+ * Fixed time step for the simulations of the pages.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "fixedstep.hpp"
+
+#include <algorithm>
+
+namespace fluffy {
+namespace sim {
+
+/**
+ */
+auto Clock(double Step, double Speed) -> clock { return clock{.Step = Step, .Speed = Speed}; }
+
+/**
+ */
+auto Advance(clock& C, double FrameSeconds) -> int {
+  if (C.Paused || C.Step <= 0.) {
+    C.Accumulator = 0.;
+    return 0;
+  }
+
+  C.Accumulator += std::clamp(FrameSeconds, 0., C.MaxFrame) * C.Speed;
+
+  // ---
+  // NOTE: A little slack, so that frames of exactly a number of steps take all of them and
+  //       not one less now and one more later because of rounding.
+  // ---
+  constexpr double Slack = 1e-9;
+
+  auto NumSteps = 0;
+  while (C.Accumulator >= C.Step * (1. - Slack)) {
+    C.Accumulator = std::max(C.Accumulator - C.Step, 0.);
+    ++NumSteps;
+  }
+  return NumSteps;
+}
+
+/**
+ */
+auto Tick(clock& C) -> void {
+  ++C.NumSteps;
+  C.Time = double(C.NumSteps) * C.Step; //!< Not summed, so that long runs do not drift.
+}
+
+/**
+ */
+auto Alpha(clock const& C) -> double { return C.Step > 0. ? std::clamp(C.Accumulator / C.Step, 0., 1.) : 1.; }
+
+/**
+ */
+auto DisplayTime(clock const& C) -> double { return std::max(C.Time - (1. - Alpha(C)) * C.Step, 0.); }
+
+}; // namespace sim
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
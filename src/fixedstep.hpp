@@ -0,0 +1,88 @@
+#ifndef SRC_FIXEDSTEP_HPP
+#define SRC_FIXEDSTEP_HPP
+
+/**
+ * Fixed time step for the simulations of the pages, apart from the drawing.
+ *
+ * Each frame adds the wall time it took, times the speed, to an accumulator and the
+ * simulation takes as many whole steps of Step seconds as there are in it. What is left
+ * says how far the display is between the last two steps, so that the drawing can
+ * interpolate and move smoothly whatever the frame rate. A simulation stepped this way
+ * comes out the same at 30 and at 144 frames per second.
+ *
+ * Without a display the steps can be taken one after the other as fast as the CPU goes,
+ * see Tick.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include <cstdint>
+
+namespace fluffy {
+namespace sim {
+
+struct clock {
+  double   Step{1. / 60.}; //!< Simulated seconds per step.
+  double   Speed{1.};      //!< Simulated seconds per wall second.
+  double   MaxFrame{0.25}; //!< Longer frames are cut to this, so that a stall does not pile up steps.
+  double   Accumulator{};  //!< Simulated seconds not stepped yet, less than Step after Advance.
+  double   Time{};         //!< Simulated seconds of the steps taken.
+  uint64_t NumSteps{};
+  bool     Paused{};
+};
+
+/**
+ * A clock at time 0 taking steps of Step seconds, Speed times faster than the wall clock.
+ */
+auto Clock(double Step, double Speed = 1.) -> clock;
+
+/**
+ * Add a frame of FrameSeconds wall time and return the number of steps to take for it.
+ * Call Tick before each of them. A paused clock takes no steps and drops the time.
+ */
+auto Advance(clock& C, double FrameSeconds) -> int;
+
+/**
+ * Count one step, Time moves to the end of it.
+ */
+auto Tick(clock& C) -> void;
+
+/**
+ * How far the display is from the step before the last one to the last one, 0 to 1.
+ */
+auto Alpha(clock const& C) -> double;
+
+/**
+ * The simulated time to draw, from the step before the last one to Time by Alpha.
+ */
+auto DisplayTime(clock const& C) -> double;
+
+}; // namespace sim
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -56,8 +56,7 @@ struct data {
   std::vector<Vector4> vTrendPoints{};
   std::vector<pixel_pos> vGridLines{};
 
-  Matrix Hep{}; //!< Homogenous matrix for conversion from engineering space to
-                //!< pixelspace.
+  es::affine2 E2P{}; //!< Conversion from engineering space to pixelspace.
 
   Vector4 vEngOffset{}; //!< Position of figure in engineering space.
   Vector4 vPixelsPerUnit{100.f, 100.f, 100.f, 0.f};
@@ -108,17 +107,16 @@ void InitFourierSquareWave(data &Data, int n) {
 //------------------------------------------------------------------------------
 
 /**
- * Initialize the matrix to convert from engineering basis to screen basis.
+ * Initialize the conversion from engineering basis to screen basis.
  * The screen center is used as the reference point.
  *
- * @OrigoScreen - the X, Y, Z values in engineering space at center of screen.
+ * @OrigoScreen - the X, Y values in engineering space at center of screen.
  * @vPixelsPerUnit - The number of pixels per unit, i.e 100 pixels equals 1m.
  * @ScreenCenterInPixels - The coordinates for the centre of the screen in
  * pixels.
  */
-auto InitEng2PixelMatrix(Vector4 const &OrigoScreen,
-                         Vector4 const &vPixelsPerUnit,
-                         Vector4 const &ScreenPosInPixels) -> Matrix {
+auto InitEng2Pixel(Vector4 const &OrigoScreen, Vector4 const &vPixelsPerUnit,
+                   Vector4 const &ScreenPosInPixels) -> es::affine2 {
 
   // ---
   // Flip because pixel coord increases when moving down.
@@ -127,17 +125,13 @@ auto InitEng2PixelMatrix(Vector4 const &OrigoScreen,
   constexpr float NoFlip = 1.f;
 
   // ---
-  // Create a Homogenous matrix that converts from engineering unit to screen.
+  // Flip and scale to pixel value, and offset to the screen reference point.
   // ---
-  auto Hes = es::I();
-  Hes.m12 = ScreenPosInPixels.x + OrigoScreen.x * vPixelsPerUnit.x;
-  Hes.m13 = ScreenPosInPixels.y + OrigoScreen.y * vPixelsPerUnit.y;
-  Hes.m14 = ScreenPosInPixels.z + OrigoScreen.z * vPixelsPerUnit.z;
-
-  // Flip and scale to pixel value.
-  Hes.m0 = NoFlip * vPixelsPerUnit.x;
-  Hes.m5 = Flip * vPixelsPerUnit.y;
-  Hes.m10 = NoFlip * vPixelsPerUnit.z;
+  es::affine2 Hes{};
+  Hes.Scale.x = NoFlip * vPixelsPerUnit.x;
+  Hes.Scale.y = Flip * vPixelsPerUnit.y;
+  Hes.Offset.x = ScreenPosInPixels.x + OrigoScreen.x * vPixelsPerUnit.x;
+  Hes.Offset.y = ScreenPosInPixels.y + OrigoScreen.y * vPixelsPerUnit.y;
 
   return Hes;
 }
@@ -145,8 +139,7 @@ auto InitEng2PixelMatrix(Vector4 const &OrigoScreen,
 /*
  * Create lines and ticks for a grid in engineering units.
  */
-auto vGridInPixels(Matrix const &Hep, //!< Homogenous matrix from engineering to
-                                      //!< pixel position.
+auto vGridInPixels(es::affine2 const &E2P, //!< Engineering to pixel position.
                    float GridXLowerLeft = -4.f, //!<
                    float GridYLowerLeft = -3.f, //!<
                    float GridLength = 8.f,      //!<
@@ -220,8 +213,8 @@ auto vGridInPixels(Matrix const &Hep, //!< Homogenous matrix from engineering to
 
   std::vector<pixel_pos> Result{};
   for (auto Elem : vGridPoint) {
-    auto const ToPixel = Hep * es::Point(Elem.toX, Elem.toY, 0.f);
-    auto const FromPixel = Hep * es::Point(Elem.fromX, Elem.fromY, 0.f);
+    auto const ToPixel = E2P * es::Point(Elem.toX, Elem.toY, 0.f);
+    auto const FromPixel = E2P * es::Point(Elem.fromX, Elem.fromY, 0.f);
     Result.push_back({int(ToPixel.x), int(ToPixel.y)});
     Result.push_back({int(FromPixel.x), int(FromPixel.y)});
   }
@@ -256,11 +249,11 @@ int main(int argc, char *argv[]) {
   Data.vEngOffset = es::Point(0.f, 0.f, 0.f);
   Data.vPixelsPerUnit = es::Point(100.f, 100.f, 0.f);
 
-  Data.Hep = InitEng2PixelMatrix(
+  Data.E2P = InitEng2Pixel(
       Data.vEngOffset, Data.vPixelsPerUnit,
       {Data.screenWidth / 2.f, Data.screenHeight / 2.f, 0.f, 0.f});
 
-  Data.vGridLines = vGridInPixels(Data.Hep);
+  Data.vGridLines = vGridInPixels(Data.E2P);
 
   // Main game loop
   while (!WindowShouldClose()) // Detect window close button or ESC key
@@ -327,10 +320,10 @@ auto HandleKeyboardInput(data *pData) -> bool {
 
   if (InputChanged) {
     pData->Xcalc = 0.0;
-    pData->vGridLines = vGridInPixels(pData->Hep);
+    pData->vGridLines = vGridInPixels(pData->E2P);
     InitFourierSquareWave(*pData, pData->n);
 
-    pData->Hep = InitEng2PixelMatrix(
+    pData->E2P = InitEng2Pixel(
         pData->vEngOffset, pData->vPixelsPerUnit,
         {pData->screenWidth / 2.f, pData->screenHeight / 2.f, 0.f, 0.f});
   }
@@ -369,9 +362,9 @@ void UpdateDrawFrameFourier(data *pData) {
   // ---
   // NOTE: Lamda to draw a point.
   // ---
-  auto ldaDrawPoint = [](Matrix const &Hep, Vector4 const &P,
+  auto ldaDrawPoint = [](es::affine2 const &E2P, Vector4 const &P,
                          Vector4 const &m2Pixel, bool Print = false) -> void {
-    auto CurvePoint = Hep * P;
+    auto CurvePoint = E2P * P;
     DrawPixel(CurvePoint.x, CurvePoint.y, RED);
     constexpr float Radius = 0.01f;
     DrawCircleLines(CurvePoint.x, CurvePoint.y, Radius * m2Pixel.x,
@@ -385,17 +378,17 @@ void UpdateDrawFrameFourier(data *pData) {
     }
   };
 
-  auto ldaDrawCircle = [](Matrix const &Hep, Vector4 const &Centre,
+  auto ldaDrawCircle = [](es::affine2 const &E2P, Vector4 const &Centre,
                           float Radius, Color Col = BLUE) -> void {
-    auto CurvePoint = Hep * Centre;
-    DrawCircleLines(CurvePoint.x, CurvePoint.y, Radius * Hep.m5,
+    auto CurvePoint = E2P * Centre;
+    DrawCircleLines(CurvePoint.x, CurvePoint.y, Radius * E2P.Scale.y,
                     Fade(Col, 0.3f));
   };
 
-  auto ldaDrawLine = [](Matrix const &Hep, Vector4 const &From,
+  auto ldaDrawLine = [](es::affine2 const &E2P, Vector4 const &From,
                         Vector4 const &To, Color Col = BLUE) -> void {
-    auto F = Hep * From;
-    auto T = Hep * To;
+    auto F = E2P * From;
+    auto T = E2P * To;
     DrawLine(F.x, F.y, T.x, T.y, BLUE);
   };
 
@@ -407,10 +400,10 @@ void UpdateDrawFrameFourier(data *pData) {
   auto Ft =
       Centre + es::Vector(Radius * cosf(Omegat), Radius * sinf(Omegat), 0.f);
 
-  ldaDrawCircle(pData->Hep, Centre, Radius);
+  ldaDrawCircle(pData->E2P, Centre, Radius);
 
   // Draw the outer circle line
-  ldaDrawLine(pData->Hep, Centre, Ft);
+  ldaDrawLine(pData->E2P, Centre, Ft);
 
   // ---
   // Create the Fourier series.
@@ -420,8 +413,8 @@ void UpdateDrawFrameFourier(data *pData) {
     auto nthTerm = 1.f + Idx * 2.f;
     auto Ftn = Ftp + es::Vector(Radius / nthTerm * cosf(nthTerm * Omegat),
                                 Radius / nthTerm * sinf(nthTerm * Omegat), 0.f);
-    ldaDrawLine(pData->Hep, Ftp, Ftn);
-    ldaDrawCircle(pData->Hep, Ftn, Radius / nthTerm);
+    ldaDrawLine(pData->E2P, Ftp, Ftn);
+    ldaDrawCircle(pData->E2P, Ftn, Radius / nthTerm);
     Ftp = Ftn;
   }
 
@@ -439,14 +432,16 @@ void UpdateDrawFrameFourier(data *pData) {
 
   // Draw the actual trend
   pData->vTrendPoints.push_back(AnimationPoint);
+  auto const m2Pixel =
+      es::Vector(pData->E2P.Scale.x, pData->E2P.Scale.y, 0.f);
   for (auto E : pData->vTrendPoints) {
-    ldaDrawPoint(pData->Hep, E, {pData->Hep.m0, pData->Hep.m5, 0.f, 0.f});
+    ldaDrawPoint(pData->E2P, E, m2Pixel);
   }
 
   // Draw the inner circle line
-  ldaDrawLine(pData->Hep, Ft, Ftp);
+  ldaDrawLine(pData->E2P, Ft, Ftp);
   // Draw the connecting line
-  ldaDrawLine(pData->Hep, Ftp, AnimationPoint);
+  ldaDrawLine(pData->E2P, Ftp, AnimationPoint);
 
   EndDrawing();
 }
@@ -1,11 +1,19 @@
 #include "fractal.hpp"
+#include "canvasmemory.hpp"
 #include "curvesrobotics.hpp"
 #include "engsupport.hpp"
+#include "perfcounters.hpp"
 #include "raylib.h"
 #include "raymath.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace {
 /**
@@ -46,6 +54,243 @@ auto ComputeIterations(es::vector4_double const& Z0, es::vector4_double const& C
   return SmoothIteration;
 }
 
+/**
+ * Iterations used by the escape time render.
+ */
+constexpr int EscapeTimeMaxIterations = 500;
+
+/**
+ * Same as ComputeIterations, and also the distance from Z0 to the boundary of the set, estimated
+ * from the derivative dz/dz0. The distance is infinite for points that do not escape.
+ */
+auto ComputeIterationsDE(es::vector4_double const& Z0,
+                         es::vector4_double const& Constant,
+                         int                       MaxIterations,
+                         double&                   Distance) -> float {
+  double Zx  = Z0.x;
+  double Zy  = Z0.y;
+  double DZx = 1.;
+  double DZy = 0.;
+  int    Iteration{0};
+
+  auto ldaStep = [&]() -> void {
+    auto const DZr = 2. * (Zx * DZx - Zy * DZy);
+    DZy            = 2. * (Zx * DZy + Zy * DZx);
+    DZx            = DZr;
+    auto const Zr  = Zx * Zx - Zy * Zy + Constant.x;
+    Zy             = 2. * Zx * Zy + Constant.y;
+    Zx             = Zr;
+  };
+
+  while (Zx * Zx + Zy * Zy < 4. && Iteration < MaxIterations) {
+    ldaStep();
+    ++Iteration;
+  }
+
+  Distance = std::numeric_limits<double>::infinity();
+  if (Iteration < MaxIterations) {
+    // ---
+    // NOTE: A few more iterations makes the estimate more accurate, since it assumes |z| is large.
+    // ---
+    for (int Extra = 0; Extra < 4 && Zx * Zx + Zy * Zy < 1e6; ++Extra)
+      ldaStep();
+
+    auto const Mod   = std::sqrt(Zx * Zx + Zy * Zy);
+    auto const ModDZ = std::sqrt(DZx * DZx + DZy * DZy);
+    Distance         = ModDZ > 0. ? 0.5 * Mod * std::log(Mod) / ModDZ : 0.;
+  }
+
+  return Iteration;
+}
+
+/**
+ * Color of one sample of the escape time render.
+ * @pDistance - When not null, also compute the distance estimate.
+ */
+auto SampleColor(es::vector4_double const& Z0, es::vector4_double const& Constant, double* pDistance) -> Color {
+  auto const Iterations = pDistance ? ComputeIterationsDE(Z0, Constant, EscapeTimeMaxIterations, *pDistance)
+                                    : ComputeIterations(Z0, Constant, EscapeTimeMaxIterations);
+
+  return fluffy::fractal::GetFractalColor(double(Iterations) / double(EscapeTimeMaxIterations));
+}
+
+/**
+ * Average color of SamplesPerAxis^2 samples spread evenly over the pixel at Z0.
+ * @EarlyOut - Take the four corner samples first, and stop there when they are
+ *             within ColorThreshold of Center. Used by adaptive quality.
+ */
+auto SupersampleColor(es::vector4_double const& Z0,
+                      es::vector4_double const& Constant,
+                      double                    Zoom,
+                      int                       SamplesPerAxis,
+                      bool                      EarlyOut,
+                      Color                     Center,
+                      int                       ColorThreshold) -> Color {
+  auto ldaSample = [&](int I, int J) -> Color {
+    auto const Dx = ((I + 0.5) / SamplesPerAxis - 0.5) / Zoom;
+    auto const Dy = ((J + 0.5) / SamplesPerAxis - 0.5) / Zoom;
+    return SampleColor(es::VectorDouble(Z0.x + Dx, Z0.y - Dy, 0.), Constant, nullptr);
+  };
+
+  auto ldaAverage = [](int const* pSum, int N) -> Color {
+    return Color{static_cast<unsigned char>((pSum[0] + N / 2) / N),
+                 static_cast<unsigned char>((pSum[1] + N / 2) / N),
+                 static_cast<unsigned char>((pSum[2] + N / 2) / N),
+                 0xFF};
+  };
+
+  int  Sum[3]{};
+  auto Last = SamplesPerAxis - 1;
+  if (EarlyOut && Last > 0) {
+    bool Flat = true;
+    for (auto [I, J] : {std::pair{0, 0}, std::pair{Last, 0}, std::pair{0, Last}, std::pair{Last, Last}}) {
+      auto const C = ldaSample(I, J);
+      Sum[0] += C.r;
+      Sum[1] += C.g;
+      Sum[2] += C.b;
+      Flat = Flat && std::abs(C.r - Center.r) <= ColorThreshold && std::abs(C.g - Center.g) <= ColorThreshold &&
+             std::abs(C.b - Center.b) <= ColorThreshold;
+    }
+    if (Flat)
+      return ldaAverage(Sum, 4);
+  }
+
+  for (int J = 0; J < SamplesPerAxis; ++J) {
+    for (int I = 0; I < SamplesPerAxis; ++I) {
+      if (EarlyOut && Last > 0 && (I == 0 || I == Last) && (J == 0 || J == Last))
+        continue; // Corners already in Sum.
+      auto const C = ldaSample(I, J);
+      Sum[0] += C.r;
+      Sum[1] += C.g;
+      Sum[2] += C.b;
+    }
+  }
+  return ldaAverage(Sum, SamplesPerAxis * SamplesPerAxis);
+}
+
+/**
+ * Second pass of the escape time render, replaces the color of pixels by the average of
+ * SupersamplesPerAxis^2 samples. With adaptive quality only pixels that are closer to the
+ * boundary than a pixel, or differ from one of their neighbours, are supersampled, so that
+ * flat regions cost close to nothing. Return the number of pixels supersampled.
+ * @vDistance - Distance estimate per pixel, only used for adaptive quality.
+ */
+auto SupersamplePass(fluffy::fractal::render_request const& Request,
+                     Color*                                 pPixels,
+                     int                                    Stride,
+                     std::vector<double> const&             vDistance) -> size_t {
+  constexpr double DistanceThreshold = 1.; //!< In pixels.
+  constexpr int    ColorThreshold    = 16; //!< Max channel difference to a neighbour.
+
+  auto const Width     = Request.Width;
+  auto const Height    = Request.Height;
+  auto const Zoom      = Request.Zoom;
+  auto const NThreads  = std::max(std::min(Request.NThreads, Height), 1);
+  auto const Adaptive  = fluffy::fractal::render_quality::Adaptive == Request.Quality;
+  auto const PosUpperL = fluffy::fractal::UpperLeft(Request);
+
+  auto ldaRunRowBlocks = [&](auto ldaRows) -> void {
+    auto vT = std::vector<std::thread>{};
+    for (int Idx = 0; Idx < NThreads; ++Idx)
+      vT.push_back(std::thread(ldaRows, Height * Idx / NThreads, Height * (Idx + 1) / NThreads, Idx));
+    for (auto& T : vT) {
+      if (T.joinable())
+        T.join();
+    }
+  };
+
+  // ---
+  // NOTE: Find the pixels to supersample. Done before any pixel is changed, since the
+  //       neighbour test reads the first pass colors.
+  // ---
+  auto vSupersample = std::vector<uint8_t>(size_t(Width) * Height, Adaptive ? 0 : 1);
+  if (Adaptive) {
+    ldaRunRowBlocks([&](int YStart, int YEnd, int) -> void {
+      auto ldaDiffers = [&](Color A, int X, int Y) -> bool {
+        if (X < 0 || X >= Width || Y < 0 || Y >= Height)
+          return false;
+        auto const B = pPixels[size_t(Y) * Stride + X];
+        return std::abs(A.r - B.r) > ColorThreshold || std::abs(A.g - B.g) > ColorThreshold ||
+               std::abs(A.b - B.b) > ColorThreshold;
+      };
+
+      for (int Y = YStart; Y < YEnd; ++Y) {
+        for (int X = 0; X < Width; ++X) {
+          auto const P = size_t(Y) * Width + X;
+          auto const C = pPixels[size_t(Y) * Stride + X];
+          vSupersample[P] = vDistance[P] * Zoom < DistanceThreshold || ldaDiffers(C, X - 1, Y) ||
+                            ldaDiffers(C, X + 1, Y) || ldaDiffers(C, X, Y - 1) || ldaDiffers(C, X, Y + 1);
+        }
+      }
+    });
+  }
+
+  auto vNumSupersampled = std::vector<size_t>(NThreads);
+  ldaRunRowBlocks([&](int YStart, int YEnd, int Idx) -> void {
+    for (int Y = YStart; Y < YEnd; ++Y) {
+      for (int X = 0; X < Width; ++X) {
+        if (!vSupersample[size_t(Y) * Width + X])
+          continue;
+        auto const Z0 = es::VectorDouble(PosUpperL.x + X / Zoom, PosUpperL.y - Y / Zoom, 0.);
+        auto&      C  = pPixels[size_t(Y) * Stride + X];
+        C = SupersampleColor(Z0, Request.Constant, Zoom, Request.SupersamplesPerAxis, Adaptive, C, ColorThreshold);
+        ++vNumSupersampled[Idx];
+      }
+    }
+  });
+
+  size_t Result{};
+  for (auto N : vNumSupersampled)
+    Result += N;
+  return Result;
+}
+
+/**
+ * Request for the canvas API. The image is rendered all of its width, Stride pixels,
+ * with the upper left corner of the grid in the upper left corner of the image.
+ */
+auto RequestFromCanvas(currob::grid_cfg const&              GridCfg,
+                       fluffy::fractal::pixel_canvas const& PixelCanvas,
+                       es::vector4_double const&            Resolution,
+                       Image const&                         outputImage) -> fluffy::fractal::render_request {
+  fluffy::fractal::render_request Result{};
+
+  Result.Zoom   = double(Resolution.x);
+  Result.Width  = outputImage.width;
+  Result.Height = outputImage.height;
+
+  auto const PosUpperLeft = es::VectorDouble(GridCfg.GridCenterValue.x - GridCfg.GridDimensions.x * 0.5f,
+                                             GridCfg.GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
+                                             0.f);
+  Result.Center =
+      PosUpperLeft + es::VectorDouble(Result.Width * 0.5 / Result.Zoom, -Result.Height * 0.5 / Result.Zoom, 0.);
+
+  Result.Quality             = PixelCanvas.Quality;
+  Result.SupersamplesPerAxis = PixelCanvas.SupersamplesPerAxis;
+  Result.NThreads            = PixelCanvas.NThreads;
+  Result.HugePages           = PixelCanvas.HugePages;
+  Result.NumaAware           = PixelCanvas.NumaAware;
+  Result.pOutput             = static_cast<Color*>(outputImage.data);
+  Result.OutputStride        = outputImage.width;
+  return Result;
+}
+
+/**
+ * Render a canvas request, the canvas image is already allocated.
+ */
+auto RenderCanvas(fluffy::fractal::render_request const& Request, fluffy::fractal::pixel_canvas& PixelCanvas)
+    -> void {
+  auto const Result           = fluffy::fractal::RenderFractal(Request);
+  PixelCanvas.NumSupersampled = Result.NumSupersampled;
+
+  if (PixelCanvas.PrintMe) {
+    std::cout << "Center:" << Request.Center << std::endl;
+    std::cout << "Zoom:" << Request.Zoom << ". Width: " << Request.Width << ". Height: " << Request.Height
+              << ". NThreads: " << Request.NThreads << std::endl;
+  }
+  PixelCanvas.PrintMe = false;
+}
+
 }; // end of anonymous namespace
 
 namespace fluffy {
@@ -74,6 +319,8 @@ auto ConfigurePixelCanvas(int CenterX, int CenterY, int Width, int Height, int R
   Result.PosLL       = es::Point(UpperLeftX, UpperLeftY + Height, 0.f);
   Result.PosLR       = es::Point(UpperLeftX + Width, UpperLeftY + Height, 0.f);
 
+  Result.Stride = fluffy::memory::RowStride(Width);
+
   Result.MhS2P = es::SetTranslation(es::Vector(UpperLeftX + Width / 2.f, UpperLeftY + Height / 2.f, 0.f));
   Result.MhS2P = Result.MhS2P * es::SetScaling(es::Vector(ResolutionX, -ResolutionY, 0.f));
 
@@ -145,168 +392,235 @@ auto Render(es::vector4_double const& RenderSize, es::vector4_double const& Cons
 #endif
 
 /**
- * Render in pixel space.
+ * Allocate the pixel data for outputImage, unless it is already there.
+ * The image is Stride pixels wide. The padding columns to the right of
+ * Dimension.x are rendered as well, but are not meant to be displayed.
  */
-auto CreateFractalPixelSpace(currob::grid_cfg const&   GridCfg,
-                             pixel_canvas&             PixelCanvas,
-                             es::vector4_double const& Resolution,
-                             es::vector4_double const& Constant,
-                             Image&                    outputImage) -> void {
+auto AllocateCanvasImage(pixel_canvas& PixelCanvas, Image& outputImage) -> bool {
+  if (outputImage.data)
+    return true;
 
-  auto const Zoom    = double(Resolution.x);
-  bool&      PrintMe = PixelCanvas.PrintMe;
+  auto const Stride            = std::max(PixelCanvas.Stride, int(PixelCanvas.Dimension.x));
+  auto const ExpectedNumPixels = static_cast<size_t>(Stride * PixelCanvas.Dimension.y);
 
   // ---
-  // Test Grid config
+  // NOTE: Allocate memory for the pixel data. The memory is not touched until the
+  //       render threads write to it, so that the pages are placed on their NUMA node.
   // ---
-  auto const PosUpperLeft  = es::VectorDouble(GridCfg.GridCenterValue.x - GridCfg.GridDimensions.x * 0.5f,
-                                             GridCfg.GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
-                                             0.f);
-  auto const PosUpperRight = es::VectorDouble(GridCfg.GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f,
-                                              GridCfg.GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
-                                              0.f);
-  auto const PosLowerRight = es::VectorDouble(GridCfg.GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f,
-                                              GridCfg.GridCenterValue.y - GridCfg.GridDimensions.y * 0.5,
-                                              0.f);
-
-  auto const ExpectedNumPixels = static_cast<size_t>(PixelCanvas.Dimension.x * PixelCanvas.Dimension.y);
-
-  if (outputImage.data == nullptr) {
-
-    // Allocate memory for the pixel data
-    std::shared_ptr<Color> spColorArray(new Color[ExpectedNumPixels], std::default_delete<Color[]>());
-
-    if (spColorArray) {
-      PixelCanvas.spColorArray = spColorArray;
-      outputImage.data         = spColorArray.get();
-      outputImage.width        = PixelCanvas.Dimension.x;
-      outputImage.height       = PixelCanvas.Dimension.y;
-      outputImage.format       = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
-      outputImage.mipmaps      = 1;
-      if (PrintMe) {
-        std::cout << "outputImage.poutputImage.data:" << outputImage.data << std::endl;
-        std::cout << "outputImage.width            :" << outputImage.width << std::endl;
-        std::cout << "outputImage.height           :" << outputImage.height << std::endl;
-      }
-    }
+  auto spColorArray = fluffy::memory::AllocateColors(ExpectedNumPixels, PixelCanvas.HugePages);
+
+  if (!spColorArray)
+    return false;
+
+  PixelCanvas.spColorArray = spColorArray;
+  outputImage.data         = spColorArray.get();
+  outputImage.width        = Stride;
+  outputImage.height       = PixelCanvas.Dimension.y;
+  outputImage.format       = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  outputImage.mipmaps      = 1;
+  if (PixelCanvas.PrintMe) {
+    std::cout << "outputImage.poutputImage.data:" << outputImage.data << std::endl;
+    std::cout << "outputImage.width            :" << outputImage.width << std::endl;
+    std::cout << "outputImage.height           :" << outputImage.height << std::endl;
   }
+  return true;
+}
 
-  if (PrintMe) {
-    std::cout << "ExpectedNumPixels:" << ExpectedNumPixels << std::endl;
-    std::cout << "PosUpperLeft:" << PosUpperLeft << std::endl;
-    std::cout << "PosUpperRight:" << PosUpperRight << std::endl;
-    std::cout << "PosLowerRight:" << PosLowerRight << std::endl;
-  }
-
-  auto const NumBlocksY = static_cast<size_t>(PixelCanvas.NThreads);
-  auto const YIncrement = static_cast<double>(GridCfg.GridDimensions.y / NumBlocksY);
-
-  struct data_fractal_gen {
+/**
+ * Upper left corner of the requested image.
+ */
+auto UpperLeft(render_request const& Request) -> es::vector4_double {
+  return es::VectorDouble(Request.Center.x - Request.Width * 0.5 / Request.Zoom,
+                          Request.Center.y + Request.Height * 0.5 / Request.Zoom,
+                          0.);
+}
 
-    int XStart{};
-    int XEnd{};
-    int YStart{};
-    int YEnd{};
+/**
+ * Escape time render of the Julia set into pPixels. Return the number of pixels supersampled.
+ */
+auto RenderEscapeTime(render_request const& Request, Color* pPixels, int Stride) -> size_t {
+  auto const NThreads  = std::max(std::min(Request.NThreads, Request.Height), 1);
+  auto const PosUpperL = UpperLeft(Request);
+  auto const Adaptive  = render_quality::Adaptive == Request.Quality;
+  auto const UseNuma   = Request.NumaAware && fluffy::memory::NumNumaNodes() > 1;
 
-    double             Zoom{};          //
-    es::vector4_double PosUpperLeft{};  //
-    es::vector4_double PosUpperRight{}; //
-    es::vector4_double PosLowerRight{}; //
-    es::vector4_double Constant{};      // Fractal constant
-    int                PixelIdx{};      //
-    size_t             Idx{};           //
-    Color*             pColorArray{};   //
-  };
+  // ---
+  // NOTE: The distance estimate is only needed for adaptive quality.
+  // ---
+  auto vDistance = std::vector<double>(Adaptive ? size_t(Request.Width) * Request.Height : 0);
 
   // ---
-  // NOTE: Lambda for computing part of the fractal. Side effect is writing back to [&].
+  // NOTE: Lambda for computing a block of rows. Each thread writes its own rows only.
   // ---
-  auto ldaJuliaSet = [](data_fractal_gen Data) -> void {
-    auto PosXY = Data.PosUpperLeft;
+  auto ldaJuliaSet = [&](int YStart, int YEnd, int NumaNode) -> void {
+    fluffy::perf::region PerfRegion{"fractal.escapetime.rows"};
+    if (NumaNode >= 0)
+      fluffy::memory::PinThreadToNumaNode(NumaNode);
+
+    for (int Y = YStart; Y < YEnd; ++Y) {
+      auto const Zy   = PosUpperL.y - Y / Request.Zoom;
+      Color*     pRow = pPixels + size_t(Y) * Stride;
+      for (int X = 0; X < Request.Width; ++X) {
+        auto const Z0 = es::VectorDouble(PosUpperL.x + X / Request.Zoom, Zy, 0.);
+        pRow[X] = SampleColor(Z0, Request.Constant, Adaptive ? &vDistance[size_t(Y) * Request.Width + X] : nullptr);
+      }
+    }
+  };
 
-    size_t Idx{};
-    for (int Y = Data.YStart; Y < Data.YEnd; ++Y) {
-      for (int X = Data.XStart; X < Data.XEnd; ++X) {
+  auto vT = std::vector<std::thread>{};
+  for (int Idx = 0; Idx < NThreads; ++Idx) {
+    auto const YStart   = Request.Height * Idx / NThreads;
+    auto const YEnd     = Request.Height * (Idx + 1) / NThreads;
+    auto const NumaNode = UseNuma ? fluffy::memory::NumaNodeForBlock(Idx, NThreads) : -1;
+    vT.push_back(std::thread(ldaJuliaSet, YStart, YEnd, NumaNode));
+  }
 
-        // Compute the pixel color.
-        auto constexpr MaxIterations = 500;
-        auto const Iterations        = ComputeIterations(PosXY, Data.Constant, MaxIterations);
+  for (auto& T : vT) {
+    if (T.joinable())
+      T.join();
+  }
 
-        auto const t = double(Iterations) / double(MaxIterations);
+  if (render_quality::Single == Request.Quality)
+    return 0;
 
-        fluffy::fractal::pixel Pixel{};
-        Pixel.Pos = {double(X), double(Y), 0, 0};
-        Pixel.Col = GetFractalColor(t);
-        // Color& C  = Pixel.Col;
-        // C.r       = Y % 255;
-        // C.g       = X % 255;
-        // C.b       = Y % 100;
-        // C.a       = 255;
+  return SupersamplePass(Request, pPixels, Stride, vDistance);
+}
 
-        *(Data.pColorArray + Idx) = Pixel.Col;
-        ++Idx;
+/**
+ * Render a request. Reentrant, all state is in the request and the result.
+ * @pPool - Where to take the output buffer from when the request has none. Null to allocate.
+ */
+auto RenderFractal(render_request const& RequestIn, memory::buffer_pool* pPool) -> render_result {
+  fluffy::perf::region PerfRegion{"fractal.render"};
 
-        PosXY.x = std::min(PosXY.x + 1. / Data.Zoom, Data.PosUpperRight.x);
-      }
-      PosXY.x = Data.PosUpperLeft.x;
-      PosXY.y = std::max(PosXY.y - 1. / Data.Zoom, Data.PosLowerRight.y);
-    }
-  };
+  render_result Result{};
+  if (RequestIn.Width <= 0 || RequestIn.Height <= 0 || !(RequestIn.Zoom > 0.))
+    return Result;
+
+  auto Request = RequestIn;
+  if (Request.NThreads <= 0)
+    Request.NThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+  Request.NThreads = std::min(Request.NThreads, Request.Height);
+
+  Result.Width  = Request.Width;
+  Result.Height = Request.Height;
 
   // ---
-  // NOTE: Create threads for each of the blocks that need to be computed.
-  // Compute a start position for each block that can be used by each of the threads for computing part of the fractal.
-  //       Since we start at the upper left Y will actually decrement, hence the minus sign.
+  // NOTE: Output goes to the caller's buffer, or one from the pool, or a new one.
   // ---
-  auto vT       = std::vector<std::thread>{};
-  auto PixelIdx = 0;
-
-  for (size_t Idx = 0;   //!<
-       Idx < NumBlocksY; //!<
-       ++Idx             //!<
-  ) {
-    data_fractal_gen Data{};
-
-    Data.XStart        = PixelCanvas.PosUL.x;
-    Data.XEnd          = PixelCanvas.PosUL.x + PixelCanvas.Dimension.x;
-    Data.YStart        = PixelCanvas.PosUL.y + PixelCanvas.YIncrement * Idx;
-    Data.YEnd          = Data.YStart + PixelCanvas.YIncrement;
-    Data.Zoom          = Zoom;
-    Data.PosUpperLeft  = PosUpperLeft + es::VectorDouble(0., -double(YIncrement * Idx), 0.);
-    Data.PosUpperRight = PosUpperRight + es::VectorDouble(0., -double(YIncrement * Idx), 0.);
-    Data.PosLowerRight = es::VectorDouble(PosUpperRight.x, Data.PosUpperRight.y - YIncrement, 0.);
-    Data.Constant      = Constant;
-    Data.PixelIdx      = PixelIdx;
-    Data.Idx           = Idx;
-    if (outputImage.data)
-      Data.pColorArray = (Color*)(outputImage.data) + PixelIdx;
-    else
-      Data.pColorArray = nullptr;
-
-    if (PrintMe) {
-      std::cout << __FUNCTION__ << "-> pData.pColorArray: " << Data.pColorArray << std::endl;
-      std::cout << "Idx: " << Idx << ". XStart: " << Data.XStart << ". XEnd: " << Data.XEnd << ". Zoom:" << Data.Zoom
-                << std::endl;
-      std::cout << "Idx: " << Idx << ". YStart: " << Data.YStart << ". YEnd: " << Data.YEnd << std::endl;
-      std::cout << "Idx: " << Idx << ". PixelIdx: " << PixelIdx << std::endl;
-      std::cout << "Idx: " << Idx << " -> PosUpperLeft(" << Idx << ")=" << Data.PosUpperLeft << std::endl;
-      std::cout << "Idx: " << Idx << " -> PosUpperRight(" << Idx << ")=" << Data.PosUpperRight << std::endl;
-      std::cout << "Idx: " << Idx << " -> PosLowerRight(" << Idx << ")=" << Data.PosLowerRight << std::endl;
-      std::cout << " ---- " << std::endl;
-    }
+  if (Request.pOutput) {
+    Result.Stride  = Request.OutputStride ? Request.OutputStride : Request.Width;
+    Result.pPixels = Request.pOutput;
+    if (Result.Stride < Request.Width)
+      return Result;
+  } else {
+    Result.Stride        = fluffy::memory::RowStride(Request.Width);
+    auto const NumPixels = size_t(Result.Stride) * size_t(Request.Height);
+    Result.spPixels      = pPool ? pPool->Acquire(NumPixels, Request.HugePages)
+                                 : fluffy::memory::AllocateColors(NumPixels, Request.HugePages);
+    Result.pPixels       = Result.spPixels.get();
+    if (!Result.pPixels)
+      return Result;
+  }
 
-    PixelIdx += (PixelCanvas.YIncrement * (PixelCanvas.PosUR.x - PixelCanvas.PosLL.x));
-    vT.push_back(std::thread(ldaJuliaSet, Data));
+  switch (Request.Mode) {
+  case render_mode::EscapeTime:
+    Result.NumSupersampled = RenderEscapeTime(Request, Result.pPixels, Result.Stride);
+    break;
+  case render_mode::Buddhabrot:
+  case render_mode::AntiBuddhabrot:
+    RenderDensity(Request, Result.pPixels, Result.Stride);
+    break;
+  case render_mode::InverseIteration:
+    RenderInverseIteration(Request, Result.pPixels, Result.Stride);
+    break;
+  default:
+    return Result;
   }
 
-  for (auto& T : vT) {
-    if (T.joinable())
-      T.join();
+  // ---
+  // NOTE: Padding to the right of Width is part of the image rows, keep it black. Not in the
+  //       caller's buffer, there it is the rest of the caller's image, i.e. the next tile.
+  // ---
+  if (Result.spPixels) {
+    for (int Y = 0; Y < Result.Height; ++Y)
+      std::fill(Result.pPixels + size_t(Y) * Result.Stride + Result.Width,
+                Result.pPixels + size_t(Y + 1) * Result.Stride,
+                BLACK);
   }
 
-  PrintMe = false;
+  Result.Ok = true;
+  return Result;
+}
+
+/**
+ * Image view of a result, Stride pixels wide. The image does not own the pixels, do not unload it.
+ */
+auto ToImage(render_result const& Result) -> Image {
+  Image Img{};
+  Img.data    = Result.pPixels;
+  Img.width   = Result.Stride;
+  Img.height  = Result.Height;
+  Img.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  Img.mipmaps = 1;
+  return Img;
+}
+
+/**
+ * Render in pixel space.
+ */
+auto CreateFractalPixelSpace(currob::grid_cfg const&   GridCfg,
+                             pixel_canvas&             PixelCanvas,
+                             es::vector4_double const& Resolution,
+                             es::vector4_double const& Constant,
+                             Image&                    outputImage) -> void {
+  if (!AllocateCanvasImage(PixelCanvas, outputImage))
+    return;
+
+  auto Request     = RequestFromCanvas(GridCfg, PixelCanvas, Resolution, outputImage);
+  Request.Mode     = render_mode::EscapeTime;
+  Request.Constant = Constant;
+  RenderCanvas(Request, PixelCanvas);
+}
 
-  return;
+/**
+ * Render the orbit density into outputImage, using the same view as CreateFractalPixelSpace.
+ */
+auto CreateDensityPixelSpace(currob::grid_cfg const&   GridCfg,
+                             pixel_canvas&             PixelCanvas,
+                             es::vector4_double const& Resolution,
+                             render_mode               Mode,
+                             density_cfg const&        Cfg,
+                             Image&                    outputImage) -> void {
+  if (render_mode::Buddhabrot != Mode && render_mode::AntiBuddhabrot != Mode)
+    return;
+
+  if (!AllocateCanvasImage(PixelCanvas, outputImage))
+    return;
+
+  auto Request    = RequestFromCanvas(GridCfg, PixelCanvas, Resolution, outputImage);
+  Request.Mode    = Mode;
+  Request.Density = Cfg;
+  RenderCanvas(Request, PixelCanvas);
+}
+
+/**
+ * Draw the boundary of the Julia set by inverse iteration, with the same view as CreateFractalPixelSpace.
+ */
+auto CreateInverseIterationPixelSpace(currob::grid_cfg const&   GridCfg,
+                                      pixel_canvas&             PixelCanvas,
+                                      es::vector4_double const& Resolution,
+                                      es::vector4_double const& Constant,
+                                      miim_cfg const&           Cfg,
+                                      Image&                    outputImage) -> void {
+  if (!AllocateCanvasImage(PixelCanvas, outputImage))
+    return;
+
+  auto Request     = RequestFromCanvas(GridCfg, PixelCanvas, Resolution, outputImage);
+  Request.Mode     = render_mode::InverseIteration;
+  Request.Constant = Constant;
+  Request.Miim     = Cfg;
+  RenderCanvas(Request, PixelCanvas);
 }
 
 }; // namespace fractal
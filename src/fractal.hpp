@@ -1,6 +1,7 @@
 #ifndef SRC_FRACTAL_HPP
 #define SRC_FRACTAL_HPP
 
+#include "canvasmemory.hpp"
 #include "curvesrobotics.hpp"
 #include "engsupport.hpp"
 #include "raylib.h"
@@ -17,6 +18,15 @@ struct pixel {
   Color              Col{BLACK};
 };
 
+/**
+ * Samples per pixel for the escape time render.
+ */
+enum class render_quality {
+  Single,      //!< One sample per pixel.
+  Adaptive,    //!< Supersample only pixels on edges, found by distance estimate and neighbour difference.
+  Supersample, //!< Supersample every pixel. Mostly as reference for Adaptive.
+};
+
 struct pixel_canvas {
   std::shared_ptr<Color> spColorArray{};
   Vector4                Dimension{};
@@ -28,11 +38,85 @@ struct pixel_canvas {
   int                    ResolutionY{100}; //!< Pixel per unit Y direction.
   int                    NThreads{1};      //!< Number of threads to use for rendering.
   int    YIncrement{}; //!< When we have x threads, each thread will deal with a sub block of height YIncrement.
+  int    Stride{};     //!< Pixels per row in spColorArray. Rows are padded to start on a cache line.
   Matrix MhS2P{};      //!< Homogenous matrix to go from Screen to pixel, screen center is at 0,0,0.
   bool   PrintMe{};
+  bool   HugePages{true}; //!< Back large canvases with huge pages.
+  bool   NumaAware{true}; //!< Pin each render thread to the NUMA node of its block of rows.
+  render_quality Quality{render_quality::Single};
+  int            SupersamplesPerAxis{4}; //!< Supersampling uses SupersamplesPerAxis^2 samples per pixel.
+  size_t         NumSupersampled{};      //!< Number of pixels supersampled by the last render.
+};
+
+/**
+ * The ways the fractal page can render.
+ */
+enum class render_mode {
+  EscapeTime,       //!< Julia set, color by escape iterations.
+  Buddhabrot,       //!< Density of the orbits that escape.
+  AntiBuddhabrot,   //!< Density of the orbits that do not escape.
+  InverseIteration, //!< Julia set boundary by inverse iteration (MIIM).
+  NumModes
+};
+
+/**
+ * Settings for the orbit density (Buddhabrot) modes.
+ */
+struct density_cfg {
+  int      MaxIterations[3]{2000, 200, 20}; //!< Iteration band for the red, green and blue channel.
+  size_t   NumSamples{500000};              //!< Number of orbits to trace.
+  bool     ImportanceSampling{true};        //!< Bias the samples towards the set boundary.
+  unsigned Seed{1};                         //!< Seed for the sampler, same seed gives same image.
+};
+
+/**
+ * Settings for the inverse iteration mode.
+ */
+struct miim_cfg {
+  int MaxHitsPerPixel{4}; //!< A branch is not followed further when its pixel has this many visits.
+  int SeedDepth{10};      //!< Tree levels expanded up front to get work for all the threads.
+};
+
+/**
+ * Everything needed for one render, as plain values. Nothing in it is changed by the
+ * render, so any number of renders can be in flight from different threads.
+ */
+struct render_request {
+  render_mode        Mode{render_mode::EscapeTime};
+  es::vector4_double Center{0., 0., 0., 1.};      //!< Value at the center of the image.
+  double             Zoom{100.};                  //!< Pixels per unit.
+  int                Width{};                     //!< In pixels.
+  int                Height{};                    //!< In pixels.
+  es::vector4_double Constant{-0.4, 0.6, 0., 0.}; //!< Julia constant, not used by the density modes.
+  render_quality     Quality{render_quality::Single};
+  int                SupersamplesPerAxis{4};
+  density_cfg        Density{};
+  miim_cfg           Miim{};
+  int                NThreads{1};     //!< Threads for this render. 0 means use all available.
+  bool               HugePages{true}; //!< For buffers allocated by the render.
+  bool               NumaAware{true}; //!< Pin each render thread to the NUMA node of its block of rows.
+  Color*             pOutput{};       //!< Caller owned buffer of OutputStride * Height pixels. Null to allocate.
+  int                OutputStride{};  //!< Pixels per row of pOutput. 0 means Width. Past Width is not touched.
+};
+
+/**
+ * Output of RenderFractal. When the render allocated the pixels, or took them from a
+ * pool, spPixels keeps them alive until the last copy of the result is gone.
+ */
+struct render_result {
+  bool                   Ok{};
+  std::shared_ptr<Color> spPixels{}; //!< Owner of the pixels, empty when the caller gave pOutput.
+  Color*                 pPixels{};
+  int                    Width{};
+  int                    Height{};
+  int                    Stride{};          //!< Pixels per row.
+  size_t                 NumSupersampled{}; //!< Pixels supersampled, escape time only.
 };
 
 struct config {
+  render_mode        Mode{render_mode::EscapeTime};
+  density_cfg        Density{};
+  miim_cfg           Miim{};
   es::vector4_double Constant{-0.4f, 0.6f, 0.f, 0.f};
   es::vector4_double ConstantLim1{-0.4f, -0.6f, 0.f, 0.f};
   es::vector4_double ConstantLim2{1.4f, 1.6f, 0.f, 0.f};
@@ -46,12 +130,32 @@ struct config {
 auto ConfigurePixelCanvas(int CenterX, int CenterY, int Width, int Height, int ResolutionX, int ResolutionY)
     -> pixel_canvas;
 auto GetFractalColor(double t) -> Color;
+auto AllocateCanvasImage(pixel_canvas& PixelCanvas, Image& outputImage) -> bool;
 auto Render(es::vector4_double const& RenderSize, es::vector4_double const& Constant) -> void;
 auto CreateFractalPixelSpace(currob::grid_cfg const&   GridCfgInput,
                              pixel_canvas&             PixelCanvas,
                              es::vector4_double const& Resolution,
                              es::vector4_double const& Constant,
                              Image&                    outputImage) -> void;
+auto CreateDensityPixelSpace(currob::grid_cfg const&   GridCfg,
+                             pixel_canvas&             PixelCanvas,
+                             es::vector4_double const& Resolution,
+                             render_mode               Mode,
+                             density_cfg const&        Cfg,
+                             Image&                    outputImage) -> void;
+auto RepellingFixedPoint(es::vector4_double const& Constant) -> es::vector4_double;
+auto UpperLeft(render_request const& Request) -> es::vector4_double;
+auto RenderFractal(render_request const& Request, memory::buffer_pool* pPool = nullptr) -> render_result;
+auto RenderEscapeTime(render_request const& Request, Color* pPixels, int Stride) -> size_t;
+auto RenderDensity(render_request const& Request, Color* pPixels, int Stride) -> void;
+auto RenderInverseIteration(render_request const& Request, Color* pPixels, int Stride) -> void;
+auto ToImage(render_result const& Result) -> Image;
+auto CreateInverseIterationPixelSpace(currob::grid_cfg const&   GridCfg,
+                                      pixel_canvas&             PixelCanvas,
+                                      es::vector4_double const& Resolution,
+                                      es::vector4_double const& Constant,
+                                      miim_cfg const&           Cfg,
+                                      Image&                    outputImage) -> void;
 }; // namespace fractal
 }; // namespace fluffy
 #endif
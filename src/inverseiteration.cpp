@@ -0,0 +1,229 @@
+/**
+ * Julia set boundary by the Modified Inverse Iteration Method (MIIM).
+ *
+ * The Julia set is invariant under the inverse map z -> +-sqrt(z - c), so the
+ * boundary can be drawn by walking the tree of preimages, starting from the
+ * repelling fixed point which is on the set. Each pixel counts how many times it
+ * has been visited, and branches landing on a pixel that is already visited
+ * often enough are not followed any further. Only the pixels on the boundary are
+ * computed, as opposed to escape time which iterates every pixel of the canvas.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "fractal.hpp"
+#include "curvesrobotics.hpp"
+#include "engsupport.hpp"
+#include "raylib.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using complex = std::complex<double>;
+
+/**
+ * Resolution of the grid used for counting visits to the part of the set outside the canvas.
+ */
+constexpr int OutsideCells = 512;
+
+/**
+ * A node in the preimage tree.
+ */
+struct node {
+  complex Z{};
+};
+
+/**
+ * Hit counters for the canvas, and for a coarse grid covering the whole Julia set so
+ * that branches outside the canvas are pruned as well.
+ */
+struct hit_counters {
+  std::unique_ptr<std::atomic<int>[]> pCanvas{};
+  std::unique_ptr<std::atomic<int>[]> pOutside{};
+  double                              PosUpperLeftX{};
+  double                              PosUpperLeftY{};
+  double                              Zoom{}; //!< Pixels per unit.
+  int                                 Width{};
+  int                                 Height{};
+  double                              Radius{}; //!< The Julia set is inside |z| <= Radius.
+  int                                 MaxHits{};
+
+  /**
+   * Count a visit to Z. Return false when the branch should be pruned.
+   */
+  auto Visit(complex Z) -> bool {
+    auto const X = std::floor((Z.real() - PosUpperLeftX) * Zoom);
+    auto const Y = std::floor((PosUpperLeftY - Z.imag()) * Zoom);
+
+    std::atomic<int>* pCounter{};
+    if (X >= 0. && X < Width && Y >= 0. && Y < Height) {
+      pCounter = &pCanvas[size_t(Y) * size_t(Width) + size_t(X)];
+    } else {
+      auto const Scale = OutsideCells / (2. * Radius);
+      auto const Ox    = std::floor((Z.real() + Radius) * Scale);
+      auto const Oy    = std::floor((Z.imag() + Radius) * Scale);
+      if (Ox < 0. || Ox >= OutsideCells || Oy < 0. || Oy >= OutsideCells)
+        return false;
+      pCounter = &pOutside[size_t(Oy) * OutsideCells + size_t(Ox)];
+    }
+
+    return pCounter->fetch_add(1, std::memory_order_relaxed) < MaxHits;
+  }
+};
+
+/**
+ * Walk the preimage tree below Seed depth first, until all branches are pruned.
+ */
+auto WalkPreimages(complex Constant, node Seed, hit_counters& Hits) -> void {
+  std::vector<node> vStack{};
+  vStack.push_back(Seed);
+
+  while (!vStack.empty()) {
+    auto const Node = vStack.back();
+    vStack.pop_back();
+
+    if (!Hits.Visit(Node.Z))
+      continue;
+
+    auto const Root = std::sqrt(Node.Z - Constant);
+    vStack.push_back({Root});
+    vStack.push_back({-Root});
+  }
+}
+
+}; // end of anonymous namespace
+
+namespace fluffy {
+namespace fractal {
+
+/**
+ * Return the repelling fixed point of z^2 + c. It is on the Julia set.
+ */
+auto RepellingFixedPoint(es::vector4_double const& Constant) -> es::vector4_double {
+  // ---
+  // NOTE: The fixed points are z = 1/2 +- sqrt(1/4 - c), the product of the two multipliers
+  //       2z is 4c, and the one with the largest |z| is the repelling one.
+  // ---
+  auto const Root = std::sqrt(complex(0.25 - Constant.x, -Constant.y));
+  auto const Z1   = 0.5 + Root;
+  auto const Z2   = 0.5 - Root;
+  auto const Z    = std::abs(Z1) >= std::abs(Z2) ? Z1 : Z2;
+  return es::VectorDouble(Z.real(), Z.imag(), 0.);
+}
+
+/**
+ * Draw the boundary of the Julia set by inverse iteration into pPixels.
+ */
+auto RenderInverseIteration(render_request const& Request, Color* pPixels, int Stride) -> void {
+  auto const& Cfg       = Request.Miim;
+  auto const& Constant  = Request.Constant;
+  auto const  PosUpperL = UpperLeft(Request);
+  auto const  C         = complex(Constant.x, Constant.y);
+  auto const  NumPixels = size_t(Request.Width) * size_t(Request.Height);
+  auto const  NThreads  = std::max(Request.NThreads, 1);
+
+  hit_counters Hits{};
+  Hits.pCanvas       = std::make_unique<std::atomic<int>[]>(NumPixels);
+  Hits.pOutside      = std::make_unique<std::atomic<int>[]>(OutsideCells * OutsideCells);
+  Hits.PosUpperLeftX = PosUpperL.x;
+  Hits.PosUpperLeftY = PosUpperL.y;
+  Hits.Zoom          = Request.Zoom;
+  Hits.Width         = Request.Width;
+  Hits.Height        = Request.Height;
+  Hits.Radius        = std::max(2., std::abs(C));
+  Hits.MaxHits       = std::max(Cfg.MaxHitsPerPixel, 1);
+
+  // ---
+  // NOTE: Expand the top of the tree breadth first to get enough seeds to spread over
+  //       the threads. The seeds are handed out from an atomic index so that threads
+  //       getting small subtrees pick up more work.
+  // ---
+  auto const FixedPoint = RepellingFixedPoint(Constant);
+
+  std::vector<node> vSeeds{{complex(FixedPoint.x, FixedPoint.y)}};
+  for (int Depth = 0; Depth < Cfg.SeedDepth; ++Depth) {
+    std::vector<node> vNext{};
+    vNext.reserve(vSeeds.size() * 2);
+    for (auto const& Node : vSeeds) {
+      auto const Root = std::sqrt(Node.Z - C);
+      vNext.push_back({Root});
+      vNext.push_back({-Root});
+    }
+    vSeeds.swap(vNext);
+  }
+
+  std::atomic<size_t> NextSeed{};
+  auto                ldaWalk = [&]() -> void {
+    for (auto Idx = NextSeed.fetch_add(1); Idx < vSeeds.size(); Idx = NextSeed.fetch_add(1))
+      WalkPreimages(C, vSeeds[Idx], Hits);
+  };
+
+  auto vT = std::vector<std::thread>{};
+  for (int Idx = 0; Idx < NThreads; ++Idx)
+    vT.push_back(std::thread(ldaWalk));
+  for (auto& T : vT) {
+    if (T.joinable())
+      T.join();
+  }
+  vT.clear();
+
+  // ---
+  // NOTE: Visited pixels are on the boundary, shaded by the number of visits.
+  // ---
+  auto ldaShade = [&](int YStart, int YEnd) -> void {
+    for (int Y = YStart; Y < YEnd; ++Y) {
+      for (int X = 0; X < Request.Width; ++X) {
+        auto const P       = size_t(Y) * size_t(Request.Width) + size_t(X);
+        auto const NumHits = std::min(Hits.pCanvas[P].load(std::memory_order_relaxed), Hits.MaxHits);
+        auto&      Pixel   = pPixels[size_t(Y) * Stride + X];
+        if (NumHits) {
+          auto const V = static_cast<unsigned char>(128 + 127 * NumHits / Hits.MaxHits);
+          Pixel        = Color{V, V, V, 0xFF};
+        } else {
+          Pixel = BLACK;
+        }
+      }
+    }
+  };
+
+  for (int Idx = 0; Idx < NThreads; ++Idx)
+    vT.push_back(std::thread(ldaShade, Request.Height * Idx / NThreads, Request.Height * (Idx + 1) / NThreads));
+  for (auto& T : vT) {
+    if (T.joinable())
+      T.join();
+  }
+}
+
+}; // namespace fractal
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
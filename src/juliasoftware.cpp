@@ -0,0 +1,280 @@
+/**
+ * Software (CPU) implementation of shaders/glsl330/julia_set.fs.
+ *
+ * The math follows the shader line by line, in single precision, so that the
+ * output can be used both when there is no OpenGL context available and for
+ * cross-validating the shader output pixel by pixel.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "juliasoftware.hpp"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * Number of pixels handled together by the kernel. The lanes are plain arrays
+ * so that the compiler can vectorize the inner loops.
+ */
+constexpr int Lanes = 8;
+
+/**
+ * GLSL fract().
+ */
+auto Fract(float X) -> float { return X - std::floor(X); }
+
+/**
+ * GLSL clamp() as done on the GPU. NaN input gives the lower limit,
+ * which is what fmin/fmax give us.
+ */
+auto Clamp01(float X) -> float { return std::fmin(std::fmax(X, 0.f), 1.f); }
+
+/**
+ * Conversion of a normalized float to an 8 bit color channel, same as the GPU
+ * does when writing to an R8G8B8A8 target.
+ */
+auto ToUnorm8(float X) -> unsigned char { return static_cast<unsigned char>(std::lround(Clamp01(X) * 255.f)); }
+
+/**
+ * Shade one packet of pixels on the same row.
+ * @Z0x, Z0y - Start value of z for each of the lanes.
+ * @pOut - Where to write the colors.
+ * @NumLanes - Number of lanes that are valid, the end of a row may be shorter.
+ */
+auto ShadePacket(fluffy::juliasw::uniforms const& U, float const* Z0x, float const* Z0y, Color* pOut, int NumLanes)
+    -> void {
+  float Zx[Lanes]{};
+  float Zy[Lanes]{};
+  int   Iterations[Lanes]{};
+  int   Active[Lanes]{};
+
+  for (int L = 0; L < Lanes; ++L) {
+    Zx[L]     = Z0x[L];
+    Zy[L]     = Z0y[L];
+    Active[L] = L < NumLanes;
+  }
+
+  auto const Cx = U.C[0];
+  auto const Cy = U.C[1];
+
+  // ---
+  // NOTE: Same loop as in the shader. A lane that has escaped keeps its z and iteration count.
+  // ---
+  for (int Idx = 0; Idx < fluffy::juliasw::MaxIterations; ++Idx) {
+    int NumActive{};
+    for (int L = 0; L < Lanes; ++L) {
+      auto const Nx      = Zx[L] * Zx[L] - Zy[L] * Zy[L] + Cx;
+      auto const Ny      = Zx[L] * Zy[L] * 2.f + Cy;
+      auto const A       = Active[L];
+      auto const Escaped = int(Nx * Nx + Ny * Ny > 4.f);
+      Zx[L]              = A ? Nx : Zx[L];
+      Zy[L]              = A ? Ny : Zy[L];
+      Iterations[L] += A & (1 - Escaped);
+      Active[L] = A & (1 - Escaped);
+      NumActive += Active[L];
+    }
+    if (!NumActive)
+      break;
+  }
+
+  // ---
+  // NOTE: Another few iterations decreases errors in the smoothing calculation.
+  // ---
+  for (int Idx = 0; Idx < 2; ++Idx) {
+    for (int L = 0; L < Lanes; ++L) {
+      auto const Nx = Zx[L] * Zx[L] - Zy[L] * Zy[L] + Cx;
+      auto const Ny = Zx[L] * Zy[L] * 2.f + Cy;
+      Zx[L]         = Nx;
+      Zy[L]         = Ny;
+    }
+  }
+
+  for (int L = 0; L < NumLanes; ++L) {
+    auto const Length    = std::sqrt(Zx[L] * Zx[L] + Zy[L] * Zy[L]);
+    auto const SmoothVal = float(Iterations[L]) + 1.f - (std::log(std::log(Length)) / std::log(2.f));
+    auto const Norm      = SmoothVal / float(fluffy::juliasw::MaxIterations);
+
+    if (Norm > 0.999f) {
+      pOut[L] = Color{0, 0, 0, 0xFF};
+    } else {
+      auto const Rgb = fluffy::juliasw::Hsv2rgb(Norm, 1.f, 1.f);
+      pOut[L]        = Color{ToUnorm8(Rgb.x), ToUnorm8(Rgb.y), ToUnorm8(Rgb.z), 0xFF};
+    }
+  }
+}
+
+/**
+ * Render the rows [YStart, YEnd).
+ */
+auto RenderRows(fluffy::juliasw::uniforms const& U, int Width, int Height, int YStart, int YEnd, Color* pColorArray)
+    -> void {
+  float Z0x[Lanes]{};
+  float Z0y[Lanes]{};
+
+  for (int Y = YStart; Y < YEnd; ++Y) {
+    // ---
+    // NOTE: fragTexCoord is sampled at the pixel center and runs from 0 to 1 across the screen.
+    // ---
+    auto const TexCoordY = (float(Y) + 0.5f) / float(Height);
+    auto const Zy        = (TexCoordY + U.Offset[1] / U.ScreenDims[1]) * 1.5f / U.Zoom;
+
+    for (int X = 0; X < Width; X += Lanes) {
+      auto const NumLanes = std::min(Lanes, Width - X);
+      for (int L = 0; L < Lanes; ++L) {
+        auto const TexCoordX = (float(X + L) + 0.5f) / float(Width);
+        Z0x[L]               = (TexCoordX + U.Offset[0] / U.ScreenDims[0]) * 2.5f / U.Zoom;
+        Z0y[L]               = Zy;
+      }
+      ShadePacket(U, Z0x, Z0y, pColorArray + size_t(Y) * size_t(Width) + size_t(X), NumLanes);
+    }
+  }
+}
+
+}; // end of anonymous namespace
+
+namespace fluffy {
+namespace juliasw {
+
+/**
+ * Convert Hue Saturation Value (HSV) color into RGB. Same as in the shader.
+ */
+auto Hsv2rgb(float H, float S, float V) -> Vector3 {
+  float const K[4]{1.f, 2.f / 3.f, 1.f / 3.f, 3.f};
+  float       Rgb[3]{};
+  for (int Idx = 0; Idx < 3; ++Idx) {
+    auto const P = std::abs(Fract(H + K[Idx]) * 6.f - K[3]);
+    // mix(x, y, a) = x * (1 - a) + y * a
+    Rgb[Idx] = V * (K[0] * (1.f - S) + Clamp01(P - K[0]) * S);
+  }
+  return {Rgb[0], Rgb[1], Rgb[2]};
+}
+
+/**
+ * Shade a single pixel.
+ * @TexCoordX, TexCoordY - Normalized screen coordinate, i.e. fragTexCoord in the shader.
+ */
+auto ShadePixel(uniforms const& U, float TexCoordX, float TexCoordY) -> Color {
+  float Z0x[Lanes]{};
+  float Z0y[Lanes]{};
+  Color Result[Lanes]{};
+  Z0x[0] = (TexCoordX + U.Offset[0] / U.ScreenDims[0]) * 2.5f / U.Zoom;
+  Z0y[0] = (TexCoordY + U.Offset[1] / U.ScreenDims[1]) * 1.5f / U.Zoom;
+  ShadePacket(U, Z0x, Z0y, Result, 1);
+  return Result[0];
+}
+
+/**
+ * Render the Julia set into pColorArray which must hold Width * Height pixels.
+ * @NThreads - Number of threads to use. 0 means use all available.
+ */
+auto RenderJuliaSet(uniforms const& U, int Width, int Height, Color* pColorArray, int NThreads) -> void {
+  if (!pColorArray || Width <= 0 || Height <= 0)
+    return;
+
+  if (NThreads <= 0)
+    NThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+  NThreads = std::min(NThreads, Height);
+
+  // ---
+  // NOTE: Give each of the threads a block of rows. The first blocks take the remainder.
+  // ---
+  auto vT         = std::vector<std::thread>{};
+  auto YIncrement = Height / NThreads;
+  auto Remainder  = Height % NThreads;
+  auto YStart     = 0;
+  for (int Idx = 0; Idx < NThreads; ++Idx) {
+    auto const YEnd = YStart + YIncrement + (Idx < Remainder ? 1 : 0);
+    vT.push_back(std::thread(RenderRows, std::cref(U), Width, Height, YStart, YEnd, pColorArray));
+    YStart = YEnd;
+  }
+
+  for (auto& T : vT) {
+    if (T.joinable())
+      T.join();
+  }
+}
+
+/**
+ * Create an image with the Julia set. Release with UnloadImage.
+ */
+auto GenImageJuliaSet(uniforms const& U, int Width, int Height, int NThreads) -> Image {
+  Image Result{};
+  Result.data    = MemAlloc(static_cast<unsigned int>(size_t(Width) * size_t(Height) * sizeof(Color)));
+  Result.width   = Width;
+  Result.height  = Height;
+  Result.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  Result.mipmaps = 1;
+
+  RenderJuliaSet(U, Width, Height, static_cast<Color*>(Result.data), NThreads);
+  return Result;
+}
+
+/**
+ * Compare two R8G8B8A8 images pixel by pixel. Alpha is not compared.
+ * @Tolerance - Allowed difference per channel before a pixel counts as different.
+ */
+auto CompareImages(Image const& A, Image const& B, int Tolerance) -> image_diff {
+  image_diff Result{};
+
+  if (!A.data || !B.data || A.width != B.width || A.height != B.height ||
+      A.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || B.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    Result.SizeMismatch = true;
+    return Result;
+  }
+
+  auto const* pA = static_cast<Color const*>(A.data);
+  auto const* pB = static_cast<Color const*>(B.data);
+
+  Result.NumPixels = size_t(A.width) * size_t(A.height);
+
+  size_t SumDiff{};
+  for (size_t Idx = 0; Idx < Result.NumPixels; ++Idx) {
+    auto const Dr      = std::abs(int(pA[Idx].r) - int(pB[Idx].r));
+    auto const Dg      = std::abs(int(pA[Idx].g) - int(pB[Idx].g));
+    auto const Db      = std::abs(int(pA[Idx].b) - int(pB[Idx].b));
+    auto const MaxDiff = std::max({Dr, Dg, Db});
+
+    SumDiff += Dr + Dg + Db;
+    Result.MaxChannelDiff = std::max(Result.MaxChannelDiff, MaxDiff);
+    if (MaxDiff > Tolerance)
+      ++Result.NumDifferent;
+  }
+
+  Result.MeanChannelDiff = double(SumDiff) / double(3 * Result.NumPixels);
+  return Result;
+}
+
+}; // namespace juliasw
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
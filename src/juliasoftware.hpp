@@ -0,0 +1,77 @@
+#ifndef SRC_JULIASOFTWARE_HPP
+#define SRC_JULIASOFTWARE_HPP
+
+/**
+ * Software (CPU) implementation of shaders/glsl330/julia_set.fs.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include "raylib.h"
+
+#include <cstddef>
+
+namespace fluffy {
+namespace juliasw {
+
+/**
+ * Same value as MAX_ITERATIONS in julia_set.fs.
+ */
+constexpr int MaxIterations = 255;
+
+/**
+ * Mirror of the uniforms that the juliashader app hands over to julia_set.fs.
+ */
+struct uniforms {
+  float ScreenDims[2]{}; //!< Dimensions of the screen.
+  float C[2]{};          //!< c.x = real, c.y = imaginary component. Equation done is z^2 + c
+  float Offset[2]{};     //!< Offset of the scale.
+  float Zoom{1.f};       //!< Zoom of the scale.
+};
+
+/**
+ * Result of a pixel by pixel comparison of two images.
+ */
+struct image_diff {
+  size_t NumPixels{};       //!< Number of pixels compared.
+  size_t NumDifferent{};    //!< Pixels where at least one channel differs by more than the tolerance.
+  int    MaxChannelDiff{};  //!< Largest difference found on any channel.
+  double MeanChannelDiff{}; //!< Mean absolute difference over all rgb channels.
+  bool   SizeMismatch{};    //!< Images have different dimensions or format, nothing compared.
+};
+
+auto Hsv2rgb(float H, float S, float V) -> Vector3;
+auto ShadePixel(uniforms const& U, float TexCoordX, float TexCoordY) -> Color;
+auto RenderJuliaSet(uniforms const& U, int Width, int Height, Color* pColorArray, int NThreads = 0) -> void;
+auto GenImageJuliaSet(uniforms const& U, int Width, int Height, int NThreads = 0) -> Image;
+auto CompareImages(Image const& A, Image const& B, int Tolerance = 0) -> image_diff;
+
+}; // namespace juliasw
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,326 @@
+/**
+ * Hardware performance counters for scoped regions of code.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "perfcounters.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<bool> gEnabled{};
+
+/**
+ * Totals per region name, shared by all threads.
+ */
+struct registry {
+  std::mutex                                        Mut{};
+  std::map<std::string, fluffy::perf::region_stats> Stats{};
+  std::string                                       Status{};
+};
+
+auto Registry() -> registry& {
+  static registry Reg{};
+  return Reg;
+}
+
+/**
+ * Keep the first reason the counters could not be opened.
+ */
+auto SetStatus(std::string const& Reason) -> void {
+  auto&           Reg = Registry();
+  std::lock_guard Lock(Reg.Mut);
+  if (Reg.Status.empty())
+    Reg.Status = Reason;
+}
+
+/**
+ * The counter group of one thread, closed when the thread exits.
+ */
+struct thread_group {
+  int  Fd[fluffy::perf::NumCounters]{};
+  bool Tried{};
+  bool Open{};
+
+  thread_group() { std::fill(std::begin(Fd), std::end(Fd), -1); } // Not fd 0, Close would close stdin.
+  thread_group(thread_group const&)                    = delete;
+  auto operator=(thread_group const&) -> thread_group& = delete;
+
+  ~thread_group() { Close(); }
+
+  auto Close() -> void {
+#ifdef __linux__
+    for (auto& F : Fd) {
+      if (F >= 0)
+        close(F);
+      F = -1;
+    }
+#endif
+    Open = false;
+  }
+
+  /**
+   * Open the group the first time only. A failure is not retried, the kernel will not
+   * change its mind for this thread.
+   */
+  auto TryOpen() -> bool {
+    if (Tried)
+      return Open;
+    Tried = true;
+
+#ifdef __linux__
+    static constexpr uint64_t Config[fluffy::perf::NumCounters]{
+        PERF_COUNT_HW_CPU_CYCLES,    PERF_COUNT_HW_INSTRUCTIONS,         PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS};
+
+    for (int Idx = 0; Idx < fluffy::perf::NumCounters; ++Idx) {
+      perf_event_attr Attr{};
+      Attr.size           = sizeof(Attr);
+      Attr.type           = PERF_TYPE_HARDWARE;
+      Attr.config         = Config[Idx];
+      Attr.disabled       = Idx == 0 ? 1 : 0; // The leader starts the whole group.
+      Attr.exclude_kernel = 1;                // Allowed with perf_event_paranoid 2.
+      Attr.exclude_hv     = 1;
+      Attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      // ---
+      // NOTE: pid 0 and cpu -1 counts the calling thread on any CPU.
+      // ---
+      auto const F = syscall(SYS_perf_event_open, &Attr, 0, -1, Idx == 0 ? -1 : Fd[0], PERF_FLAG_FD_CLOEXEC);
+      if (F < 0) {
+        auto const Error = errno;
+        SetStatus(std::string("perf_event_open failed: ") + std::strerror(Error) +
+                  (EACCES == Error || EPERM == Error ? ". Check /proc/sys/kernel/perf_event_paranoid."
+                                                    : ". No hardware PMU, i.e. in a VM?"));
+        Close();
+        return false;
+      }
+      Fd[Idx] = int(F);
+    }
+
+    ioctl(Fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(Fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    Open = true;
+#else
+    SetStatus("Hardware counters are only supported on Linux.");
+#endif
+    return Open;
+  }
+
+  auto Read() -> fluffy::perf::counts {
+    fluffy::perf::counts Result{};
+    if (!TryOpen())
+      return Result;
+
+#ifdef __linux__
+    // ---
+    // NOTE: Group read format: nr, time enabled, time running, then one value per counter.
+    //       When the PMU is shared the group only runs part of the time, so scale up.
+    // ---
+    uint64_t Buffer[3 + fluffy::perf::NumCounters]{};
+    if (read(Fd[0], Buffer, sizeof(Buffer)) != ssize_t(sizeof(Buffer)) || Buffer[0] != fluffy::perf::NumCounters)
+      return Result;
+
+    auto const Enabled = Buffer[1];
+    auto const Running = Buffer[2];
+    if (!Running)
+      return Result;
+
+    for (int Idx = 0; Idx < fluffy::perf::NumCounters; ++Idx) {
+      auto const Value  = Buffer[3 + Idx];
+      Result.Value[Idx] = Running < Enabled ? uint64_t(double(Value) * double(Enabled) / double(Running)) : Value;
+    }
+    Result.Valid = true;
+#endif
+    return Result;
+  }
+};
+
+auto ThreadGroup() -> thread_group& {
+  thread_local thread_group Group{};
+  return Group;
+}
+
+/**
+ * Ratio that prints as 0 instead of nan or inf.
+ */
+auto Ratio(double Numerator, double Denominator) -> double {
+  return Denominator > 0. ? Numerator / Denominator : 0.;
+}
+
+}; // end of anonymous namespace
+
+namespace fluffy {
+namespace perf {
+
+/**
+ */
+auto Enable(bool On) -> void { gEnabled.store(On, std::memory_order_relaxed); }
+
+/**
+ */
+auto IsEnabled() -> bool { return gEnabled.load(std::memory_order_relaxed); }
+
+/**
+ */
+auto Available() -> bool { return ThreadGroup().TryOpen(); }
+
+/**
+ */
+auto Status() -> std::string {
+  auto&           Reg = Registry();
+  std::lock_guard Lock(Reg.Mut);
+  return Reg.Status;
+}
+
+/**
+ */
+auto ReadThreadCounters() -> counts { return ThreadGroup().Read(); }
+
+/**
+ */
+region::region(char const* pRegionName) : pName(pRegionName) {
+  if (!pName || !IsEnabled())
+    return;
+  Active    = true;
+  Start     = ReadThreadCounters();
+  StartTime = std::chrono::steady_clock::now();
+}
+
+/**
+ */
+region::~region() {
+  if (!Active)
+    return;
+
+  auto const EndTime = std::chrono::steady_clock::now();
+  auto const End     = ReadThreadCounters();
+
+  auto&           Reg   = Registry();
+  std::lock_guard Lock(Reg.Mut);
+  auto&           Stats = Reg.Stats[pName];
+  if (Stats.Name.empty())
+    Stats.Name = pName;
+  ++Stats.Calls;
+  Stats.Seconds += std::chrono::duration<double>(EndTime - StartTime).count();
+  if (Start.Valid && End.Valid) {
+    ++Stats.CountedCalls;
+    for (int Idx = 0; Idx < NumCounters; ++Idx)
+      Stats.Value[Idx] += End.Value[Idx] - Start.Value[Idx];
+  }
+}
+
+/**
+ */
+auto Snapshot() -> std::vector<region_stats> {
+  auto&           Reg = Registry();
+  std::lock_guard Lock(Reg.Mut);
+
+  std::vector<region_stats> Result{};
+  Result.reserve(Reg.Stats.size());
+  for (auto const& [Name, Stats] : Reg.Stats)
+    Result.push_back(Stats);
+  return Result;
+}
+
+/**
+ */
+auto Reset() -> void {
+  auto&           Reg = Registry();
+  std::lock_guard Lock(Reg.Mut);
+  Reg.Stats.clear();
+}
+
+/**
+ */
+auto Report(std::ostream& Out) -> void {
+  auto const vStats = Snapshot();
+  auto const Reason = Status();
+
+  Out << std::left << std::setw(28) << "Region" << std::right << std::setw(10) << "Calls" << std::setw(12)
+      << "ms/call" << std::setw(8) << "IPC" << std::setw(12) << "Miss/kInst" << std::setw(12) << "Branch %"
+      << std::endl;
+
+  for (auto const& S : vStats) {
+    auto const Cycles       = double(S.Value[int(counter::Cycles)]);
+    auto const Instructions = double(S.Value[int(counter::Instructions)]);
+    auto const CacheMisses  = double(S.Value[int(counter::CacheMisses)]);
+    auto const BranchMisses = double(S.Value[int(counter::BranchMisses)]);
+    auto const Branches     = double(S.Value[int(counter::Branches)]);
+
+    Out << std::left << std::setw(28) << S.Name << std::right << std::setw(10) << S.Calls << std::fixed
+        << std::setprecision(3) << std::setw(12) << 1000. * Ratio(S.Seconds, double(S.Calls));
+    if (S.CountedCalls) {
+      Out << std::setprecision(2) << std::setw(8) << Ratio(Instructions, Cycles) << std::setw(12)
+          << 1000. * Ratio(CacheMisses, Instructions) << std::setw(12) << 100. * Ratio(BranchMisses, Branches);
+    } else {
+      Out << std::setw(8) << "-" << std::setw(12) << "-" << std::setw(12) << "-";
+    }
+    Out << std::defaultfloat << std::endl;
+  }
+
+  if (!Reason.empty())
+    Out << "Hardware counters not available. " << Reason << std::endl;
+}
+
+/**
+ */
+auto WriteCsv(std::string const& FileName) -> bool {
+  std::ofstream File(FileName);
+  if (!File)
+    return false;
+
+  File << "region,calls,counted_calls,seconds,cycles,instructions,cache_misses,branch_misses,branches" << std::endl;
+  for (auto const& S : Snapshot()) {
+    File << S.Name << ',' << S.Calls << ',' << S.CountedCalls << ',' << std::setprecision(9) << S.Seconds;
+    for (int Idx = 0; Idx < NumCounters; ++Idx)
+      File << ',' << S.Value[Idx];
+    File << std::endl;
+  }
+  return bool(File);
+}
+
+}; // namespace perf
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,139 @@
+#ifndef SRC_PERFCOUNTERS_HPP
+#define SRC_PERFCOUNTERS_HPP
+
+/**
+ * Hardware performance counters for scoped regions of code.
+ *
+ * Each thread opens its own group of counters with perf_event_open the first time
+ * it enters a region, counting cycles, instructions, cache misses, branch misses and branches
+ * of that thread in user space. A region adds the counts and the wall time between
+ * its construction and destruction to the totals for its name, which can be printed
+ * as a report or written as CSV.
+ *
+ * When the kernel denies access (perf_event_paranoid, containers, VMs without a PMU),
+ * or on other platforms than Linux, regions still measure time and the counters are
+ * reported as not available.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace fluffy {
+namespace perf {
+
+enum class counter : int { Cycles, Instructions, CacheMisses, BranchMisses, Branches, NumCounters };
+
+constexpr int NumCounters = int(counter::NumCounters);
+
+/**
+ * Counts of the calling thread since its counters were opened.
+ */
+struct counts {
+  uint64_t Value[NumCounters]{};
+  bool     Valid{}; //!< False when the hardware counters are not available.
+};
+
+/**
+ * Totals for all the regions with the same name.
+ */
+struct region_stats {
+  std::string Name{};
+  uint64_t    Calls{};
+  uint64_t    CountedCalls{}; //!< Calls where the hardware counters were available.
+  double      Seconds{};
+  uint64_t    Value[NumCounters]{};
+};
+
+/**
+ * Regions are only measured when enabled. Disabled by default, so that a region
+ * costs one atomic load when nobody asked for the numbers.
+ */
+auto Enable(bool On) -> void;
+auto IsEnabled() -> bool;
+
+/**
+ * True when the calling thread could open its counters.
+ */
+auto Available() -> bool;
+
+/**
+ * Why the counters are not available, empty when they are.
+ */
+auto Status() -> std::string;
+
+/**
+ * Read the counters of the calling thread, opening them if needed.
+ */
+auto ReadThreadCounters() -> counts;
+
+/**
+ * Measure from construction to destruction and add the result to the totals of pName,
+ * which must outlive the region. Use on one thread only.
+ */
+struct region {
+  explicit region(char const* pName);
+  ~region();
+  region(region const&)                    = delete;
+  auto operator=(region const&) -> region& = delete;
+
+  char const*                           pName{};
+  bool                                  Active{};
+  counts                                Start{};
+  std::chrono::steady_clock::time_point StartTime{};
+};
+
+/**
+ * Totals of all regions, sorted by name.
+ */
+auto Snapshot() -> std::vector<region_stats>;
+
+/**
+ * Forget all totals.
+ */
+auto Reset() -> void;
+
+/**
+ * Print a table with time per call, IPC, cache misses per 1000 instructions and the share of
+ * the branches that were mispredicted.
+ */
+auto Report(std::ostream& Out) -> void;
+
+/**
+ * Write the totals as CSV, one line per region. Return false when the file can not be written.
+ */
+auto WriteCsv(std::string const& FileName) -> bool;
+
+}; // namespace perf
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
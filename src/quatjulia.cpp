@@ -0,0 +1,366 @@
+/**
+ * CPU ray-marcher for quaternion Julia sets.
+ *
+ * The distance estimate is d = 0.5 |q| log|q| / |q'|, where the running derivative
+ * only needs its length, |q'| <- 2 |q| |q'|. The kernels work on packets of rays
+ * stored as plain arrays, so that the compiler can vectorize the inner loops.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "quatjulia.hpp"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * Number of rays handled together by the kernel.
+ */
+constexpr int Lanes = 8;
+
+/**
+ * Bail out radius squared for the iteration.
+ */
+constexpr float EscapeRadius2 = 16.f;
+
+/**
+ * States of a ray.
+ */
+constexpr int Marching = 0;
+constexpr int Hit      = 1;
+constexpr int Missed   = 2;
+
+/**
+ * Distance estimates for a packet of points, in fractal units.
+ */
+auto DistanceEstimatePacket(fluffy::quatjulia::params const& P,
+                            float const*                     Px,
+                            float const*                     Py,
+                            float const*                     Pz,
+                            float*                           pDistance) -> void {
+  float Qa[Lanes]{};
+  float Qb[Lanes]{};
+  float Qc[Lanes]{};
+  float Qd[Lanes]{};
+  float Q2[Lanes]{};
+  float Md2[Lanes]{}; //!< |q'|^2
+
+  for (int L = 0; L < Lanes; ++L) {
+    Qa[L]  = Px[L];
+    Qb[L]  = Py[L];
+    Qc[L]  = Pz[L];
+    Qd[L]  = P.Slice;
+    Q2[L]  = Qa[L] * Qa[L] + Qb[L] * Qb[L] + Qc[L] * Qc[L] + Qd[L] * Qd[L];
+    Md2[L] = 1.f;
+  }
+
+  // ---
+  // NOTE: q^2 = (a^2 - b^2 - c^2 - d^2, 2ab, 2ac, 2ad). A lane that has escaped keeps its values.
+  // ---
+  for (int Idx = 0; Idx < P.MaxIterations; ++Idx) {
+    for (int L = 0; L < Lanes; ++L) {
+      auto const Active = Q2[L] < EscapeRadius2;
+      auto const NMd2   = 4.f * Q2[L] * Md2[L];
+      auto const Na     = Qa[L] * Qa[L] - Qb[L] * Qb[L] - Qc[L] * Qc[L] - Qd[L] * Qd[L] + P.C[0];
+      auto const Nb     = 2.f * Qa[L] * Qb[L] + P.C[1];
+      auto const Nc     = 2.f * Qa[L] * Qc[L] + P.C[2];
+      auto const Nd     = 2.f * Qa[L] * Qd[L] + P.C[3];
+      Md2[L]            = Active ? NMd2 : Md2[L];
+      Qa[L]             = Active ? Na : Qa[L];
+      Qb[L]             = Active ? Nb : Qb[L];
+      Qc[L]             = Active ? Nc : Qc[L];
+      Qd[L]             = Active ? Nd : Qd[L];
+      Q2[L]             = Qa[L] * Qa[L] + Qb[L] * Qb[L] + Qc[L] * Qc[L] + Qd[L] * Qd[L];
+    }
+  }
+
+  // ---
+  // NOTE: 0.5 |q| log|q| / |q'| written with the squares, 0.25 sqrt(Q2 / Md2) log(Q2).
+  //       Inside the set the estimate goes to zero or below, which counts as a hit. The
+  //       limits keep orbits that go to zero from giving NaN.
+  // ---
+  for (int L = 0; L < Lanes; ++L) {
+    auto const SafeQ2 = std::max(Q2[L], 1e-30f);
+    pDistance[L]      = 0.25f * std::sqrt(SafeQ2 / std::max(Md2[L], 1e-30f)) * std::log(SafeQ2);
+  }
+}
+
+/**
+ * Camera basis and projection, same as BeginMode3D does it.
+ */
+struct view {
+  Vector3 Position{};
+  Vector3 Forward{};
+  Vector3 Right{};
+  Vector3 Up{};
+  float   HalfHeight{}; //!< tan(fovy / 2) for perspective, half the height in world units for orthographic.
+  float   Aspect{};
+  bool    Orthographic{};
+  int     Width{};
+  int     Height{};
+};
+
+auto Sub(Vector3 A, Vector3 B) -> Vector3 { return {A.x - B.x, A.y - B.y, A.z - B.z}; }
+auto Dot(Vector3 A, Vector3 B) -> float { return A.x * B.x + A.y * B.y + A.z * B.z; }
+auto Cross(Vector3 A, Vector3 B) -> Vector3 {
+  return {A.y * B.z - A.z * B.y, A.z * B.x - A.x * B.z, A.x * B.y - A.y * B.x};
+}
+auto Normalize(Vector3 A) -> Vector3 {
+  auto const Length = std::sqrt(Dot(A, A));
+  return Length > 0.f ? Vector3{A.x / Length, A.y / Length, A.z / Length} : A;
+}
+
+auto MakeView(Camera3D const& Camera, int Width, int Height) -> view {
+  view Result{};
+  Result.Position     = Camera.position;
+  Result.Forward      = Normalize(Sub(Camera.target, Camera.position));
+  Result.Right        = Normalize(Cross(Result.Forward, Camera.up));
+  Result.Up           = Cross(Result.Right, Result.Forward);
+  Result.Orthographic = CAMERA_ORTHOGRAPHIC == Camera.projection;
+  Result.HalfHeight   = Result.Orthographic ? Camera.fovy * 0.5f : std::tan(Camera.fovy * 0.5f * PI / 180.f);
+  Result.Aspect       = float(Width) / float(Height);
+  Result.Width        = Width;
+  Result.Height       = Height;
+  return Result;
+}
+
+/**
+ * Shade a hit. The normal is the gradient of the distance estimate, from four samples
+ * on the corners of a tetrahedron.
+ */
+auto ShadeHit(fluffy::quatjulia::params const& P, Vector3 Pos, Vector3 Dir, int Steps) -> Color {
+  auto const H = P.Epsilon;
+
+  float const K[4][3]{{1.f, -1.f, -1.f}, {-1.f, -1.f, 1.f}, {-1.f, 1.f, -1.f}, {1.f, 1.f, 1.f}};
+  float       Px[Lanes]{};
+  float       Py[Lanes]{};
+  float       Pz[Lanes]{};
+  float       D[Lanes]{};
+  for (int Idx = 0; Idx < 4; ++Idx) {
+    Px[Idx] = Pos.x + K[Idx][0] * H;
+    Py[Idx] = Pos.y + K[Idx][1] * H;
+    Pz[Idx] = Pos.z + K[Idx][2] * H;
+  }
+  DistanceEstimatePacket(P, Px, Py, Pz, D);
+
+  Vector3 Normal{};
+  for (int Idx = 0; Idx < 4; ++Idx) {
+    Normal.x += K[Idx][0] * D[Idx];
+    Normal.y += K[Idx][1] * D[Idx];
+    Normal.z += K[Idx][2] * D[Idx];
+  }
+  Normal = Normalize(Normal);
+
+  // ---
+  // NOTE: A key light and a head light, and the number of steps as a cheap ambient occlusion.
+  // ---
+  auto const KeyLight  = Normalize(Vector3{0.5f, 0.8f, 0.3f});
+  auto const Diffuse   = 0.6f * std::max(0.f, Dot(Normal, KeyLight)) + 0.4f * std::max(0.f, -Dot(Normal, Dir));
+  auto const Occlusion = 1.f - 0.7f * float(Steps) / float(P.MaxSteps);
+  auto const Light     = std::clamp((0.2f + 0.8f * Diffuse) * Occlusion, 0.f, 1.f);
+
+  return Color{static_cast<unsigned char>(P.Col.r * Light),
+               static_cast<unsigned char>(P.Col.g * Light),
+               static_cast<unsigned char>(P.Col.b * Light),
+               0xFF};
+}
+
+/**
+ * March one packet of rays on row Y, starting at column X.
+ * @NumLanes - Number of lanes that are valid, the end of a row may be shorter.
+ */
+auto MarchPacket(fluffy::quatjulia::params const& P, view const& V, int X, int Y, int NumLanes, Color* pOut) -> void {
+  float Ox[Lanes]{};
+  float Oy[Lanes]{};
+  float Oz[Lanes]{};
+  float Dx[Lanes]{};
+  float Dy[Lanes]{};
+  float Dz[Lanes]{};
+  float T[Lanes]{};
+  float TMax[Lanes]{};
+  int   State[Lanes]{};
+  int   Steps[Lanes]{};
+
+  // ---
+  // NOTE: Set up the rays in fractal units, and clip them against the bounding sphere.
+  // ---
+  auto const Radius = std::max(2.f, std::sqrt(P.C[0] * P.C[0] + P.C[1] * P.C[1] + P.C[2] * P.C[2] + P.C[3] * P.C[3]));
+  auto const NdcY   = 1.f - 2.f * (float(Y) + 0.5f) / float(V.Height);
+  for (int L = 0; L < Lanes; ++L) {
+    auto const NdcX = 2.f * (float(X + L) + 0.5f) / float(V.Width) - 1.f;
+    auto const Sx   = NdcX * V.HalfHeight * V.Aspect;
+    auto const Sy   = NdcY * V.HalfHeight;
+
+    Vector3 Origin = V.Position;
+    Vector3 Dir    = V.Forward;
+    if (V.Orthographic) {
+      Origin = {Origin.x + Sx * V.Right.x + Sy * V.Up.x,
+                Origin.y + Sx * V.Right.y + Sy * V.Up.y,
+                Origin.z + Sx * V.Right.z + Sy * V.Up.z};
+    } else {
+      Dir = Normalize({Dir.x + Sx * V.Right.x + Sy * V.Up.x,
+                       Dir.y + Sx * V.Right.y + Sy * V.Up.y,
+                       Dir.z + Sx * V.Right.z + Sy * V.Up.z});
+    }
+    Origin = {Origin.x / P.Scale, Origin.y / P.Scale, Origin.z / P.Scale};
+
+    auto const B    = Dot(Origin, Dir);
+    auto const C    = Dot(Origin, Origin) - Radius * Radius;
+    auto const Disc = B * B - C;
+    auto const Root = std::sqrt(std::max(Disc, 0.f));
+
+    Ox[L]    = Origin.x;
+    Oy[L]    = Origin.y;
+    Oz[L]    = Origin.z;
+    Dx[L]    = Dir.x;
+    Dy[L]    = Dir.y;
+    Dz[L]    = Dir.z;
+    T[L]     = std::max(-B - Root, 0.f);
+    TMax[L]  = -B + Root;
+    State[L] = (L < NumLanes && Disc > 0.f && TMax[L] > 0.f) ? Marching : Missed;
+  }
+
+  float Px[Lanes]{};
+  float Py[Lanes]{};
+  float Pz[Lanes]{};
+  float D[Lanes]{};
+  for (int Step = 0; Step < P.MaxSteps; ++Step) {
+    for (int L = 0; L < Lanes; ++L) {
+      Px[L] = Ox[L] + T[L] * Dx[L];
+      Py[L] = Oy[L] + T[L] * Dy[L];
+      Pz[L] = Oz[L] + T[L] * Dz[L];
+    }
+
+    DistanceEstimatePacket(P, Px, Py, Pz, D);
+
+    int NumMarching{};
+    for (int L = 0; L < Lanes; ++L) {
+      if (Marching != State[L])
+        continue;
+      if (D[L] < P.Epsilon) {
+        State[L] = Hit;
+      } else {
+        T[L] += D[L];
+        ++Steps[L];
+        if (T[L] > TMax[L])
+          State[L] = Missed;
+      }
+      NumMarching += Marching == State[L];
+    }
+    if (!NumMarching)
+      break;
+  }
+
+  for (int L = 0; L < NumLanes; ++L) {
+    if (Hit == State[L])
+      pOut[L] = ShadeHit(P, {Px[L], Py[L], Pz[L]}, {Dx[L], Dy[L], Dz[L]}, Steps[L]);
+    else
+      pOut[L] = Color{0, 0, 0, 0};
+  }
+}
+
+}; // end of anonymous namespace
+
+namespace fluffy {
+namespace quatjulia {
+
+/**
+ */
+auto DistanceEstimate(params const& P, Vector3 Pos) -> float {
+  float Px[Lanes]{Pos.x};
+  float Py[Lanes]{Pos.y};
+  float Pz[Lanes]{Pos.z};
+  float D[Lanes]{};
+  DistanceEstimatePacket(P, Px, Py, Pz, D);
+  return D[0];
+}
+
+/**
+ */
+auto RenderQuatJulia(params const& P, Camera3D const& Camera, int Width, int Height, Color* pColorArray, int NThreads)
+    -> void {
+  if (!pColorArray || Width <= 0 || Height <= 0)
+    return;
+
+  if (NThreads <= 0)
+    NThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+
+  auto const V        = MakeView(Camera, Width, Height);
+  auto const NumTileX = (Width + TileSize - 1) / TileSize;
+  auto const NumTileY = (Height + TileSize - 1) / TileSize;
+  auto const NumTiles = NumTileX * NumTileY;
+
+  // ---
+  // NOTE: The threads take the next tile from a shared counter until all are done.
+  // ---
+  std::atomic<int> NextTile{};
+  auto             ldaRenderTiles = [&]() -> void {
+    for (auto Tile = NextTile.fetch_add(1); Tile < NumTiles; Tile = NextTile.fetch_add(1)) {
+      auto const X0 = (Tile % NumTileX) * TileSize;
+      auto const Y0 = (Tile / NumTileX) * TileSize;
+      auto const X1 = std::min(X0 + TileSize, Width);
+      auto const Y1 = std::min(Y0 + TileSize, Height);
+      for (int Y = Y0; Y < Y1; ++Y) {
+        for (int X = X0; X < X1; X += Lanes)
+          MarchPacket(P, V, X, Y, std::min(Lanes, X1 - X), pColorArray + size_t(Y) * size_t(Width) + size_t(X));
+      }
+    }
+  };
+
+  auto vT = std::vector<std::thread>{};
+  for (int Idx = 0; Idx < std::min(NThreads, NumTiles); ++Idx)
+    vT.push_back(std::thread(ldaRenderTiles));
+
+  for (auto& T : vT) {
+    if (T.joinable())
+      T.join();
+  }
+}
+
+/**
+ */
+auto GenImageQuatJulia(params const& P, Camera3D const& Camera, int Width, int Height, int NThreads) -> Image {
+  Image Result{};
+  Result.data    = MemAlloc(static_cast<unsigned int>(size_t(Width) * size_t(Height) * sizeof(Color)));
+  Result.width   = Width;
+  Result.height  = Height;
+  Result.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  Result.mipmaps = 1;
+
+  RenderQuatJulia(P, Camera, Width, Height, static_cast<Color*>(Result.data), NThreads);
+  return Result;
+}
+
+}; // namespace quatjulia
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,81 @@
+#ifndef SRC_QUATJULIA_HPP
+#define SRC_QUATJULIA_HPP
+
+/**
+ * CPU ray-marcher for quaternion Julia sets, q -> q^2 + c.
+ *
+ * The 3D object is the slice of the 4D set where the last component is fixed.
+ * Rays are marched with the analytic distance estimator, in packets of rays on the
+ * same row, and the image is split in tiles that the threads pick from a shared
+ * counter so that cheap tiles (background) do not leave threads idle.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include "raylib.h"
+
+namespace fluffy {
+namespace quatjulia {
+
+/**
+ * Size of the square tiles handed to the render threads.
+ */
+constexpr int TileSize = 16;
+
+struct params {
+  float C[4]{-0.2f, 0.6f, 0.2f, 0.2f}; //!< The quaternion constant.
+  float Slice{0.f};                    //!< Value of the 4th component for the 3D slice.
+  float Scale{3.f};                    //!< World units per fractal unit.
+  int   MaxIterations{10};             //!< Iterations of q^2 + c per distance estimate.
+  int   MaxSteps{128};                 //!< Ray marching steps before giving up on a ray.
+  float Epsilon{1e-3f};                //!< Hit when the estimated distance is below this, in fractal units.
+  Color Col{ORANGE};                   //!< Surface color. The background is left transparent.
+};
+
+/**
+ * Distance estimate from P, in fractal units, to the surface.
+ */
+auto DistanceEstimate(params const& P, Vector3 Pos) -> float;
+
+/**
+ * Render into pColorArray which must hold Width * Height pixels.
+ * Both CAMERA_PERSPECTIVE and CAMERA_ORTHOGRAPHIC are handled the same way as BeginMode3D.
+ * @NThreads - Number of threads to use. 0 means use all available.
+ */
+auto RenderQuatJulia(
+    params const& P, Camera3D const& Camera, int Width, int Height, Color* pColorArray, int NThreads = 0) -> void;
+
+/**
+ * Create an image with the quaternion Julia set. Release with UnloadImage.
+ */
+auto GenImageQuatJulia(params const& P, Camera3D const& Camera, int Width, int Height, int NThreads = 0) -> Image;
+
+}; // namespace quatjulia
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,501 @@
+/**
+ * The 2D primitives the curves pages draw, sent to one of a few backends.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "renderbackend.hpp"
+
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+using fluffy::render::backend;
+using fluffy::render::backend_kind;
+using fluffy::render::op;
+
+constexpr std::array<char const*, fluffy::render::NumOps> aOpNames{
+    "BeginFrame", "EndFrame", "Clear", "Line", "Lines", "Squares", "CircleLines", "CircleGradient", "Text", "Glyphs"};
+
+auto Count(backend& B, op Op, uint64_t NumItems = 1) -> void {
+  ++B.aCalls[size_t(Op)];
+  B.aItems[size_t(Op)] += NumItems;
+}
+
+template <typename T> auto Put(std::vector<uint8_t>& vStream, T Value) -> void {
+  auto const Pos = vStream.size();
+  vStream.resize(Pos + sizeof(T));
+  std::memcpy(vStream.data() + Pos, &Value, sizeof(T));
+}
+
+auto Put(std::vector<uint8_t>& vStream, Color Col) -> void {
+  vStream.insert(vStream.end(), {Col.r, Col.g, Col.b, Col.a});
+}
+
+/**
+ * Append the op to the stream when B records. True when it does, for the payload.
+ */
+auto Record(backend& B, op Op) -> bool {
+  if (backend_kind::Recording != B.Kind)
+    return false;
+  B.vStream.push_back(uint8_t(Op));
+  return true;
+}
+
+/**
+ * Number of glyphs in the default font of B, the valid glyph indices are below it.
+ */
+auto NumFontGlyphs(backend const& B) -> int {
+  if (backend_kind::Raylib == B.Kind)
+    return GetFontDefault().glyphCount;
+  return fluffy::softraster::NumGlyphs;
+}
+
+/**
+ * Reads a stream front to back. Reading past the end gives zeros and clears Ok.
+ */
+struct reader {
+  std::span<uint8_t const> Stream{};
+  size_t                   Pos{};
+  bool                     Ok{true};
+
+  template <typename T> auto Get() -> T {
+    T Value{};
+    if (Pos + sizeof(T) > Stream.size()) {
+      Ok  = false;
+      Pos = Stream.size();
+      return Value;
+    }
+    std::memcpy(&Value, Stream.data() + Pos, sizeof(T));
+    Pos += sizeof(T);
+    return Value;
+  }
+
+  auto GetColor() -> Color { return Color{Get<uint8_t>(), Get<uint8_t>(), Get<uint8_t>(), Get<uint8_t>()}; }
+};
+
+}; // namespace
+
+namespace fluffy {
+namespace render {
+
+/**
+ */
+auto Backend(backend_kind Kind, int Width, int Height) -> backend {
+  backend B{.Kind = Kind, .Width = Width, .Height = Height};
+  if (backend_kind::Recording == Kind) {
+    B.vStream.assign(StreamMagic.begin(), StreamMagic.end());
+    B.vStream.push_back(StreamVersion);
+  }
+  if (backend_kind::Software == Kind)
+    B.Canvas = fluffy::softraster::Canvas(Width, Height);
+  return B;
+}
+
+/**
+ */
+auto ResetCounters(backend& B) -> void {
+  B.aCalls    = {};
+  B.aItems    = {};
+  B.NumFrames = 0;
+}
+
+/**
+ */
+auto BeginFrame(backend& B) -> void {
+  Count(B, op::BeginFrame, 0);
+  if (backend_kind::Raylib == B.Kind)
+    BeginDrawing();
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Begin(B.Canvas);
+  Record(B, op::BeginFrame);
+}
+
+/**
+ */
+auto EndFrame(backend& B) -> void {
+  Count(B, op::EndFrame, 0);
+  ++B.NumFrames;
+  if (backend_kind::Raylib == B.Kind)
+    EndDrawing();
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Rasterize(B.Canvas);
+  Record(B, op::EndFrame);
+}
+
+/**
+ */
+auto Clear(backend& B, Color Col) -> void {
+  Count(B, op::Clear);
+  if (backend_kind::Raylib == B.Kind)
+    ClearBackground(Col);
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Clear(B.Canvas, Col);
+  if (Record(B, op::Clear))
+    Put(B.vStream, Col);
+}
+
+/**
+ */
+auto Line(backend& B, float X0, float Y0, float X1, float Y1, Color Col) -> void {
+  Count(B, op::Line);
+  if (backend_kind::Raylib == B.Kind)
+    DrawLine(int(X0), int(Y0), int(X1), int(Y1), Col);
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Line(B.Canvas, X0, Y0, X1, Y1, Col);
+  if (Record(B, op::Line)) {
+    for (auto const V : {X0, Y0, X1, Y1})
+      Put(B.vStream, V);
+    Put(B.vStream, Col);
+  }
+}
+
+/**
+ */
+auto CircleLines(backend& B, float X, float Y, float Radius, Color Col) -> void {
+  Count(B, op::CircleLines);
+  if (backend_kind::Raylib == B.Kind)
+    DrawCircleLines(int(X), int(Y), Radius, Col);
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Ring(B.Canvas, X, Y, Radius, Col);
+  if (Record(B, op::CircleLines)) {
+    for (auto const V : {X, Y, Radius})
+      Put(B.vStream, V);
+    Put(B.vStream, Col);
+  }
+}
+
+/**
+ */
+auto CircleGradient(backend& B, float X, float Y, float Radius, Color Inner, Color Outer) -> void {
+  Count(B, op::CircleGradient);
+  if (backend_kind::Raylib == B.Kind)
+    DrawCircleGradient(int(X), int(Y), Radius, Inner, Outer);
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Disc(B.Canvas, X, Y, Radius, Inner, Outer);
+  if (Record(B, op::CircleGradient)) {
+    for (auto const V : {X, Y, Radius})
+      Put(B.vStream, V);
+    Put(B.vStream, Inner);
+    Put(B.vStream, Outer);
+  }
+}
+
+/**
+ * Texts longer than what a u16 can count are cut in the stream.
+ */
+auto Text(backend& B, char const* pText, int X, int Y, int FontSize, Color Col) -> void {
+  auto const Length = std::strlen(pText);
+  Count(B, op::Text, Length);
+  if (backend_kind::Raylib == B.Kind)
+    DrawText(pText, X, Y, FontSize, Col);
+  else if (backend_kind::Software == B.Kind)
+    fluffy::softraster::Text(B.Canvas, pText, float(X), float(Y), float(FontSize), Col);
+  if (Record(B, op::Text)) {
+    auto const NumChars = uint16_t(std::min<size_t>(Length, UINT16_MAX));
+    for (auto const V : {X, Y, FontSize})
+      Put(B.vStream, int32_t(V));
+    Put(B.vStream, Col);
+    Put(B.vStream, NumChars);
+    B.vStream.insert(B.vStream.end(), pText, pText + NumChars);
+  }
+}
+
+/**
+ */
+auto BeginLines(backend& B) -> void {
+  Count(B, op::Lines, 0);
+  if (backend_kind::Raylib == B.Kind)
+    rlBegin(RL_LINES);
+  if (Record(B, op::Lines)) {
+    B.BatchPos  = B.vStream.size();
+    B.BatchSize = 0;
+    Put(B.vStream, B.BatchSize);
+  }
+}
+
+/**
+ */
+auto AddLine(backend& B, float X0, float Y0, float X1, float Y1, Color Col) -> void {
+  ++B.aItems[size_t(op::Lines)];
+  if (backend_kind::Raylib == B.Kind) {
+    rlCheckRenderBatchLimit(2);
+    rlColor4ub(Col.r, Col.g, Col.b, Col.a);
+    rlVertex2f(X0, Y0);
+    rlVertex2f(X1, Y1);
+  } else if (backend_kind::Software == B.Kind) {
+    fluffy::softraster::Line(B.Canvas, X0, Y0, X1, Y1, Col);
+  } else if (backend_kind::Recording == B.Kind) {
+    for (auto const V : {X0, Y0, X1, Y1})
+      Put(B.vStream, V);
+    Put(B.vStream, Col);
+    ++B.BatchSize;
+  }
+}
+
+/**
+ */
+auto EndLines(backend& B) -> void {
+  if (backend_kind::Raylib == B.Kind)
+    rlEnd();
+  else if (backend_kind::Recording == B.Kind)
+    std::memcpy(B.vStream.data() + B.BatchPos, &B.BatchSize, sizeof(B.BatchSize));
+}
+
+/**
+ * The squares are quads with the default texture, so that they batch with the shapes.
+ */
+auto BeginSquares(backend& B) -> void {
+  Count(B, op::Squares, 0);
+  if (backend_kind::Raylib == B.Kind) {
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+  }
+  if (Record(B, op::Squares)) {
+    B.BatchPos  = B.vStream.size();
+    B.BatchSize = 0;
+    Put(B.vStream, B.BatchSize);
+  }
+}
+
+/**
+ */
+auto AddSquare(backend& B, float X, float Y, float HalfSize, Color Col) -> void {
+  ++B.aItems[size_t(op::Squares)];
+  if (backend_kind::Raylib == B.Kind) {
+    auto const H = HalfSize;
+    rlCheckRenderBatchLimit(4);
+    rlColor4ub(Col.r, Col.g, Col.b, Col.a);
+    rlVertex2f(X - H, Y - H);
+    rlVertex2f(X - H, Y + H);
+    rlVertex2f(X + H, Y + H);
+    rlVertex2f(X + H, Y - H);
+  } else if (backend_kind::Software == B.Kind) {
+    fluffy::softraster::Rect(B.Canvas, X - HalfSize, Y - HalfSize, X + HalfSize, Y + HalfSize, Col);
+  } else if (backend_kind::Recording == B.Kind) {
+    for (auto const V : {X, Y, HalfSize})
+      Put(B.vStream, V);
+    Put(B.vStream, Col);
+    ++B.BatchSize;
+  }
+}
+
+/**
+ */
+auto EndSquares(backend& B) -> void {
+  if (backend_kind::Raylib == B.Kind) {
+    rlEnd();
+    rlSetTexture(0);
+  } else if (backend_kind::Recording == B.Kind) {
+    std::memcpy(B.vStream.data() + B.BatchPos, &B.BatchSize, sizeof(B.BatchSize));
+  }
+}
+
+/**
+ */
+auto GlyphIndex(backend const& B, int Codepoint) -> int {
+  if (backend_kind::Raylib == B.Kind)
+    return GetGlyphIndex(GetFontDefault(), Codepoint);
+  return std::max(Codepoint - 32, 0);
+}
+
+/**
+ */
+auto Glyphs(backend& B, float X, float Y, std::span<int const> Glyph, float FontSize, Color Col) -> void {
+  Count(B, op::Glyphs, Glyph.size());
+
+  if (backend_kind::Raylib == B.Kind) {
+    auto const Font    = GetFontDefault();
+    auto const Scale   = FontSize / float(Font.baseSize);
+    auto const Spacing = FontSize / 10.f; //!< As DrawText.
+    auto const TexW    = float(Font.texture.width);
+    auto const TexH    = float(Font.texture.height);
+
+    rlSetTexture(Font.texture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(Col.r, Col.g, Col.b, Col.a);
+    for (auto const Idx : Glyph) {
+      if (Idx < 0 || Idx >= Font.glyphCount)
+        continue;
+      rlCheckRenderBatchLimit(4);
+
+      auto const& Rec  = Font.recs[Idx];
+      auto const& Info = Font.glyphs[Idx];
+      auto const  X0   = X + float(Info.offsetX) * Scale;
+      auto const  Y0   = Y + float(Info.offsetY) * Scale;
+      auto const  X1   = X0 + Rec.width * Scale;
+      auto const  Y1   = Y0 + Rec.height * Scale;
+
+      rlTexCoord2f(Rec.x / TexW, Rec.y / TexH);
+      rlVertex2f(X0, Y0);
+      rlTexCoord2f(Rec.x / TexW, (Rec.y + Rec.height) / TexH);
+      rlVertex2f(X0, Y1);
+      rlTexCoord2f((Rec.x + Rec.width) / TexW, (Rec.y + Rec.height) / TexH);
+      rlVertex2f(X1, Y1);
+      rlTexCoord2f((Rec.x + Rec.width) / TexW, Rec.y / TexH);
+      rlVertex2f(X1, Y0);
+
+      X += float(Info.advanceX ? Info.advanceX : Rec.width) * Scale + Spacing;
+    }
+    rlEnd();
+    rlSetTexture(0);
+  } else if (backend_kind::Software == B.Kind) {
+    for (auto const Idx : Glyph) {
+      fluffy::softraster::Glyph(B.Canvas, X, Y, Idx, FontSize, Col);
+      X += fluffy::softraster::GlyphStep(FontSize);
+    }
+  }
+
+  if (Record(B, op::Glyphs)) {
+    auto const NumGlyphs = uint8_t(std::min<size_t>(Glyph.size(), UINT8_MAX));
+    for (auto const V : {X, Y, FontSize})
+      Put(B.vStream, V);
+    Put(B.vStream, Col);
+    Put(B.vStream, NumGlyphs);
+    for (size_t Idx = 0; Idx < NumGlyphs; ++Idx)
+      Put(B.vStream, uint16_t(Glyph[Idx]));
+  }
+}
+
+/**
+ */
+auto Replay(std::span<uint8_t const> Stream, backend& B) -> bool {
+  reader In{Stream};
+
+  for (auto const C : StreamMagic)
+    if (char(In.Get<uint8_t>()) != C)
+      return false;
+  if (StreamVersion != In.Get<uint8_t>() || !In.Ok)
+    return false;
+
+  while (In.Pos < Stream.size()) {
+    auto const Op = op(In.Get<uint8_t>());
+
+    if (op::BeginFrame == Op) {
+      BeginFrame(B);
+    } else if (op::EndFrame == Op) {
+      EndFrame(B);
+    } else if (op::Clear == Op) {
+      auto const Col = In.GetColor();
+      if (In.Ok)
+        Clear(B, Col);
+    } else if (op::Line == Op || op::CircleLines == Op || op::CircleGradient == Op) {
+      std::array<float, 4> aV{};
+      for (size_t Idx = 0; Idx < (op::Line == Op ? 4u : 3u); ++Idx)
+        aV[Idx] = In.Get<float>();
+      auto const Col   = In.GetColor();
+      auto const Outer = op::CircleGradient == Op ? In.GetColor() : Col;
+      if (!In.Ok)
+        break;
+      if (op::Line == Op)
+        Line(B, aV[0], aV[1], aV[2], aV[3], Col);
+      else if (op::CircleLines == Op)
+        CircleLines(B, aV[0], aV[1], aV[2], Col);
+      else
+        CircleGradient(B, aV[0], aV[1], aV[2], Col, Outer);
+    } else if (op::Lines == Op || op::Squares == Op) {
+      auto const NumItems = In.Get<uint32_t>();
+      op::Lines == Op ? BeginLines(B) : BeginSquares(B);
+      for (uint32_t Item = 0; Item < NumItems && In.Ok; ++Item) {
+        auto const X0  = In.Get<float>();
+        auto const Y0  = In.Get<float>();
+        auto const X1  = In.Get<float>();
+        auto const Y1  = op::Lines == Op ? In.Get<float>() : 0.f;
+        auto const Col = In.GetColor();
+        if (!In.Ok)
+          break;
+        op::Lines == Op ? AddLine(B, X0, Y0, X1, Y1, Col) : AddSquare(B, X0, Y0, X1, Col);
+      }
+      op::Lines == Op ? EndLines(B) : EndSquares(B);
+    } else if (op::Text == Op) {
+      auto const X        = In.Get<int32_t>();
+      auto const Y        = In.Get<int32_t>();
+      auto const FontSize = In.Get<int32_t>();
+      auto const Col      = In.GetColor();
+      auto const NumChars = In.Get<uint16_t>();
+      if (!In.Ok || In.Pos + NumChars > Stream.size())
+        return false;
+      auto const Txt = std::string(reinterpret_cast<char const*>(Stream.data() + In.Pos), NumChars);
+      In.Pos += NumChars;
+      Text(B, Txt.c_str(), X, Y, FontSize, Col);
+    } else if (op::Glyphs == Op) {
+      auto const                 X         = In.Get<float>();
+      auto const                 Y         = In.Get<float>();
+      auto const                 FontSize  = In.Get<float>();
+      auto const                 Col       = In.GetColor();
+      auto const                 NumGlyphs = In.Get<uint8_t>();
+      std::array<int, UINT8_MAX> aGlyph{};
+      for (size_t Idx = 0; Idx < NumGlyphs; ++Idx)
+        aGlyph[Idx] = In.Get<uint16_t>();
+      if (!In.Ok)
+        break;
+      if (std::any_of(aGlyph.begin(), aGlyph.begin() + NumGlyphs, [&](int G) { return G >= NumFontGlyphs(B); }))
+        return false;
+      Glyphs(B, X, Y, std::span(aGlyph.data(), NumGlyphs), FontSize, Col);
+    } else {
+      return false;
+    }
+  }
+
+  return In.Ok;
+}
+
+/**
+ */
+auto WriteStream(backend const& B, std::string const& FileName) -> bool {
+  std::ofstream Out(FileName, std::ios::binary);
+  if (!Out)
+    return false;
+  Out.write(reinterpret_cast<char const*>(B.vStream.data()), std::streamsize(B.vStream.size()));
+  return bool(Out);
+}
+
+/**
+ */
+auto Report(backend const& B, std::ostream& Out) -> void {
+  auto const NumFrames = double(std::max<uint64_t>(B.NumFrames, 1));
+
+  Out << "Frames: " << B.NumFrames << std::endl;
+  Out << std::left << std::setw(28) << "Op" << std::right << std::setw(14) << "Calls/frame" << std::setw(14)
+      << "Items/frame" << std::endl;
+  for (size_t Idx = 0; Idx < NumOps; ++Idx) {
+    if (!B.aCalls[Idx])
+      continue;
+    Out << std::left << std::setw(28) << aOpNames[Idx] << std::right << std::fixed << std::setprecision(1)
+        << std::setw(14) << double(B.aCalls[Idx]) / NumFrames << std::setw(14) << double(B.aItems[Idx]) / NumFrames
+        << std::defaultfloat << std::endl;
+  }
+}
+
+}; // namespace render
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,172 @@
+#ifndef SRC_RENDERBACKEND_HPP
+#define SRC_RENDERBACKEND_HPP
+
+/**
+ * The 2D primitives the curves pages draw, sent to one of a few backends.
+ *
+ * The raylib backend draws them. The null backend only counts the calls and the items,
+ * lines, squares and characters, so that the CPU cost of a page can be measured without
+ * a window or a GPU. The recording backend counts the same and also appends each call to
+ * a compact binary command stream, that can be written to a file and replayed into any
+ * backend later. The software backend draws them on the CPU into a canvas, see
+ * fluffy::softraster, for images without a display.
+ *
+ * The stream starts with the four bytes "FLRS" and a version byte. Each command is one
+ * op byte and the payload of the op, floats and integers in the byte order of the host
+ * and a color as four bytes r, g, b, a:
+ *
+ *   BeginFrame, EndFrame  -
+ *   Clear                 color
+ *   Line                  f32 x0, y0, x1, y1, color
+ *   Lines                 u32 n, n * (f32 x0, y0, x1, y1, color)
+ *   Squares               u32 n, n * (f32 x, y, half size, color)
+ *   CircleLines           f32 x, y, radius, color
+ *   CircleGradient        f32 x, y, radius, color inner, color outer
+ *   Text                  i32 x, y, size, color, u16 n, n * char
+ *   Glyphs                f32 x, y, size, color, u8 n, n * u16 glyph index
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include "softraster.hpp"
+
+#include "raylib.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace fluffy {
+namespace render {
+
+enum class backend_kind : uint8_t { Raylib, Null, Recording, Software };
+
+enum class op : uint8_t {
+  BeginFrame,
+  EndFrame,
+  Clear,
+  Line,
+  Lines,
+  Squares,
+  CircleLines,
+  CircleGradient,
+  Text,
+  Glyphs,
+  NumOps
+};
+
+constexpr size_t NumOps = size_t(op::NumOps);
+
+constexpr std::array<char, 4> StreamMagic{'F', 'L', 'R', 'S'};
+constexpr uint8_t             StreamVersion = 1;
+
+/**
+ * Where the primitives go, and what has gone there since the counters were reset.
+ */
+struct backend {
+  backend_kind                 Kind{};
+  int                          Width{}; //!< Screen size in pixels, for culling.
+  int                          Height{};
+  std::array<uint64_t, NumOps> aCalls{};
+  std::array<uint64_t, NumOps> aItems{}; //!< Lines, squares, circles, characters and glyphs.
+  uint64_t                     NumFrames{};
+  std::vector<uint8_t>         vStream{};  //!< Recording only.
+  size_t                       BatchPos{}; //!< Where the count of the open batch is in vStream.
+  uint32_t                     BatchSize{};
+  fluffy::softraster::canvas   Canvas{}; //!< Software only, rasterized at EndFrame.
+};
+
+/**
+ * A backend of Kind for a screen of Width x Height. The stream of a recording backend
+ * starts with the header.
+ */
+auto Backend(backend_kind Kind, int Width, int Height) -> backend;
+
+/**
+ * Zero the counters, the stream is kept.
+ */
+auto ResetCounters(backend& B) -> void;
+
+auto BeginFrame(backend& B) -> void;
+auto EndFrame(backend& B) -> void;
+auto Clear(backend& B, Color Col) -> void;
+
+auto Line(backend& B, float X0, float Y0, float X1, float Y1, Color Col) -> void;
+auto CircleLines(backend& B, float X, float Y, float Radius, Color Col) -> void;
+auto CircleGradient(backend& B, float X, float Y, float Radius, Color Inner, Color Outer) -> void;
+auto Text(backend& B, char const* pText, int X, int Y, int FontSize, Color Col) -> void;
+
+/**
+ * Lines and squares in batches, all the items between Begin and End go to the GPU
+ * together. Only one batch can be open at a time.
+ */
+auto BeginLines(backend& B) -> void;
+auto AddLine(backend& B, float X0, float Y0, float X1, float Y1, Color Col) -> void;
+auto EndLines(backend& B) -> void;
+
+auto BeginSquares(backend& B) -> void;
+auto AddSquare(backend& B, float X, float Y, float HalfSize, Color Col) -> void;
+auto EndSquares(backend& B) -> void;
+
+/**
+ * Index of Codepoint in the default font, for Glyphs. Without raylib the default font is
+ * taken to start at space, as it does.
+ */
+auto GlyphIndex(backend const& B, int Codepoint) -> int;
+
+/**
+ * Glyphs of the default font from the top left corner X, Y, as quads textured from the
+ * font atlas, the same quads as DrawText would make.
+ */
+auto Glyphs(backend& B, float X, float Y, std::span<int const> Glyph, float FontSize, Color Col) -> void;
+
+/**
+ * Send the commands of a recorded stream to B. False when the stream is not a stream, ends
+ * in the middle of a command or has a glyph that is not in the font of B, what came before
+ * is sent.
+ */
+auto Replay(std::span<uint8_t const> Stream, backend& B) -> bool;
+
+/**
+ * Write the recorded stream to FileName. Returns false when the file could not be written.
+ */
+auto WriteStream(backend const& B, std::string const& FileName) -> bool;
+
+/**
+ * Print the calls and items per frame of each op.
+ */
+auto Report(backend const& B, std::ostream& Out) -> void;
+
+}; // namespace render
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -18,6 +18,7 @@
  *
  ********************************************************************************************/
 
+#include "juliasoftware.hpp"
 #include "raylib.h"
 #include "utils.h"
 
@@ -25,6 +26,8 @@
 
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include <unistd.h>
 
 #ifdef __APPLE__
@@ -90,17 +93,124 @@ const float pointsOfInterest[6][2] = {
     {-0.70176f, -0.3842f},
 };
 
+/**
+ * Render the shader into an image so that it can be compared with the software renderer.
+ * The render texture is upside down when read back, hence the flip.
+ */
+Image RenderShaderToImage(Shader shader, RenderTexture2D const& target) {
+  RenderTexture2D Check = LoadRenderTexture(target.texture.width, target.texture.height);
+  BeginTextureMode(Check);
+  ClearBackground(BLACK);
+  BeginShaderMode(shader);
+  DrawTextureEx(target.texture, (Vector2){0.0f, 0.0f}, 0.0f, 1.0f, WHITE);
+  EndShaderMode();
+  EndTextureMode();
+
+  Image Result = LoadImageFromTexture(Check.texture);
+  ImageFlipVertical(&Result);
+  ImageFormat(&Result, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  UnloadRenderTexture(Check);
+  return Result;
+}
+
+/**
+ * Compare the shader output with the software renderer and log the result.
+ * Return true when the images match within the tolerance.
+ */
+bool CompareShaderWithSoftware(Shader shader, RenderTexture2D const& target, fluffy::juliasw::uniforms const& U) {
+  // ---
+  // NOTE: The GPU is allowed to fuse multiply-adds and use its own log, so allow
+  //       for some difference per channel, and a small fraction of pixels close to the
+  //       set boundary where the iteration count flips.
+  // ---
+  constexpr int    Tolerance           = 8;
+  constexpr double MaxFractionDiffering = 0.01;
+
+  Image GpuImage = RenderShaderToImage(shader, target);
+  Image CpuImage = fluffy::juliasw::GenImageJuliaSet(U, GpuImage.width, GpuImage.height);
+
+  auto const Diff = fluffy::juliasw::CompareImages(GpuImage, CpuImage, Tolerance);
+  auto const Ok   = !Diff.SizeMismatch && Diff.NumDifferent <= size_t(MaxFractionDiffering * Diff.NumPixels);
+
+  TraceLog(Ok ? LOG_INFO : LOG_WARNING,
+           "Shader vs software: %zu of %zu pixels differ by more than %i. Max diff: %i. Mean diff: %f. %s",
+           Diff.NumDifferent,
+           Diff.NumPixels,
+           Tolerance,
+           Diff.MaxChannelDiff,
+           Diff.MeanChannelDiff,
+           Ok ? "OK" : "MISMATCH");
+
+  if (!Ok) {
+    ExportImage(GpuImage, "juliaset_gpu.png");
+    ExportImage(CpuImage, "juliaset_cpu.png");
+  }
+
+  UnloadImage(GpuImage);
+  UnloadImage(CpuImage);
+  return Ok;
+}
+
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void) {
+int main(int argc, char* argv[]) {
   // Initialization
   //--------------------------------------------------------------------------------------
   const int screenWidth  = 800;
   const int screenHeight = 450;
 
+  // ---
+  // NOTE: Command line options.
+  //       --cpu      Use the software renderer also when there is an OpenGL context.
+  //       --compare  Compare shader and software output once and exit.
+  //       --output   File name used for the image when running headless.
+  //       --headless Skip the window and write the software rendered image to file.
+  // ---
+  bool        useSoftware = false;
+  bool        compareOnly = false;
+  bool        headless    = false;
+  std::string outputFile  = "juliaset.png";
+  for (int Idx = 1; Idx < argc; ++Idx) {
+    auto const Arg = std::string(argv[Idx]);
+    if (Arg == "--cpu")
+      useSoftware = true;
+    else if (Arg == "--compare")
+      compareOnly = true;
+    else if (Arg == "--headless")
+      headless = true;
+    else if (Arg == "--output" && Idx + 1 < argc)
+      outputFile = argv[++Idx];
+  }
+
+  // ---
+  // NOTE: Without a display there is no window and no OpenGL context, and InitWindow exits
+  //       the program with a fatal log. So decide before it, and fall back to the software
+  //       renderer writing the image to file.
+  // ---
+#ifdef __linux__
+  headless = headless || (std::getenv("DISPLAY") == nullptr && std::getenv("WAYLAND_DISPLAY") == nullptr);
+#endif
+
   SetTraceLogLevel(LOG_DEBUG);
 
+  if (headless) {
+    fluffy::juliasw::uniforms U{};
+    U.ScreenDims[0] = float(screenWidth);
+    U.ScreenDims[1] = float(screenHeight);
+    U.C[0]          = pointsOfInterest[0][0];
+    U.C[1]          = pointsOfInterest[0][1];
+    U.Offset[0]     = -float(screenWidth) / 2;
+    U.Offset[1]     = -float(screenHeight) / 2;
+    U.Zoom          = 1.0f;
+
+    Image CpuImage = fluffy::juliasw::GenImageJuliaSet(U, screenWidth, screenHeight);
+    auto  Ok       = ExportImage(CpuImage, outputFile.c_str());
+    TraceLog(LOG_INFO, "Headless. Software rendered julia set written to %s", outputFile.c_str());
+    UnloadImage(CpuImage);
+    return Ok ? 0 : 1;
+  }
+
   SetConfigFlags(FLAG_WINDOW_HIGHDPI);
   InitWindow(screenWidth, screenHeight, "raylib [shaders] example - julia sets");
 
@@ -147,6 +257,32 @@ int main(void) {
   bool showControls   = true;  // Show controls
   bool pause          = false; // Pause animation
 
+  // ---
+  // NOTE: The software renderer draws into an image that is uploaded to this texture.
+  // ---
+  auto ldaUniforms = [&]() -> fluffy::juliasw::uniforms {
+    fluffy::juliasw::uniforms U{};
+    U.ScreenDims[0] = screenDims[0];
+    U.ScreenDims[1] = screenDims[1];
+    U.C[0]          = c[0];
+    U.C[1]          = c[1];
+    U.Offset[0]     = offset[0];
+    U.Offset[1]     = offset[1];
+    U.Zoom          = zoom;
+    return U;
+  };
+
+  if (compareOnly) {
+    auto const Ok = CompareShaderWithSoftware(shader, target, ldaUniforms());
+    UnloadShader(shader);
+    UnloadRenderTexture(target);
+    CloseWindow();
+    return Ok ? 0 : 1;
+  }
+
+  Image     softwareImage   = GenImageColor(GetScreenWidth(), GetScreenHeight(), BLACK);
+  Texture2D softwareTexture = LoadTextureFromImage(softwareImage);
+
   SetTargetFPS(60); // Set our game to run at 60 frames-per-second
   //--------------------------------------------------------------------------------------
 
@@ -178,6 +314,10 @@ int main(void) {
       pause = !pause; // Pause animation (c change)
     if (IsKeyPressed(KEY_F1))
       showControls = !showControls; // Toggle whether or not to show controls
+    if (IsKeyPressed(KEY_C))
+      useSoftware = !useSoftware; // Toggle between shader and software renderer
+    if (IsKeyPressed(KEY_V))
+      CompareShaderWithSoftware(shader, target, ldaUniforms());
 
     if (!pause) {
       if (IsKeyPressed(KEY_RIGHT))
@@ -232,13 +372,21 @@ int main(void) {
     BeginDrawing();
     ClearBackground(BLACK); // Clear screen background
 
-    // Draw the saved texture and rendered julia set with shader
-    // NOTE: We do not invert texture on Y, already considered inside shader
-    BeginShaderMode(shader);
-    // WARNING: If FLAG_WINDOW_HIGHDPI is enabled, HighDPI monitor scaling should be considered
-    // when rendering the RenderTexture2D to fit in the HighDPI scaled Window
-    DrawTextureEx(target.texture, (Vector2){0.0f, 0.0f}, 0.0f, 1.0f, WHITE);
-    EndShaderMode();
+    if (useSoftware) {
+      // Render the julia set on the CPU and upload it
+      fluffy::juliasw::RenderJuliaSet(
+          ldaUniforms(), softwareImage.width, softwareImage.height, static_cast<Color*>(softwareImage.data));
+      UpdateTexture(softwareTexture, softwareImage.data);
+      DrawTexture(softwareTexture, 0, 0, WHITE);
+    } else {
+      // Draw the saved texture and rendered julia set with shader
+      // NOTE: We do not invert texture on Y, already considered inside shader
+      BeginShaderMode(shader);
+      // WARNING: If FLAG_WINDOW_HIGHDPI is enabled, HighDPI monitor scaling should be considered
+      // when rendering the RenderTexture2D to fit in the HighDPI scaled Window
+      DrawTextureEx(target.texture, (Vector2){0.0f, 0.0f}, 0.0f, 1.0f, WHITE);
+      EndShaderMode();
+    }
 
     if (showControls) {
       DrawText("Press Mouse buttons right/left to zoom in/out and move", 10, 15, 10, RAYWHITE);
@@ -246,6 +394,9 @@ int main(void) {
       DrawText("Press KEYS [1 - 6] to change point of interest", 10, 45, 10, RAYWHITE);
       DrawText("Press KEY_LEFT | KEY_RIGHT to change speed", 10, 60, 10, RAYWHITE);
       DrawText("Press KEY_SPACE to pause movement animation", 10, 75, 10, RAYWHITE);
+      DrawText("Press KEY_C to toggle software renderer", 10, 90, 10, RAYWHITE);
+      DrawText("Press KEY_V to compare shader and software output", 10, 105, 10, RAYWHITE);
+      DrawText(useSoftware ? "Renderer: software" : "Renderer: shader", 10, 120, 10, RAYWHITE);
     }
     EndDrawing();
     //----------------------------------------------------------------------------------
@@ -253,8 +404,10 @@ int main(void) {
 
   // De-Initialization
   //--------------------------------------------------------------------------------------
-  UnloadShader(shader);        // Unload shader
-  UnloadRenderTexture(target); // Unload render texture
+  UnloadShader(shader);            // Unload shader
+  UnloadRenderTexture(target);     // Unload render texture
+  UnloadTexture(softwareTexture);  // Unload software renderer texture
+  UnloadImage(softwareImage);      // Unload software renderer image
 
   CloseWindow(); // Close window and OpenGL context
   //--------------------------------------------------------------------------------------
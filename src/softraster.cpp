@@ -0,0 +1,649 @@
+/**
+ * CPU rasterizer for the 2D primitives of the curves pages.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "softraster.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+using fluffy::softraster::canvas;
+using fluffy::softraster::primitive;
+using fluffy::softraster::shape;
+using fluffy::softraster::TileSize;
+
+/**
+ * 5 x 7 bitmap font from space to tilde, one row per byte from the top, bit 4 leftmost.
+ */
+constexpr uint8_t aFont5x7[fluffy::softraster::NumGlyphs][7]{
+    {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000}, // space
+    {0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00000, 0b00100}, // !
+    {0b01010, 0b01010, 0b01010, 0b00000, 0b00000, 0b00000, 0b00000}, // "
+    {0b01010, 0b01010, 0b11111, 0b01010, 0b11111, 0b01010, 0b01010}, // #
+    {0b00100, 0b01111, 0b10100, 0b01110, 0b00101, 0b11110, 0b00100}, // $
+    {0b11000, 0b11001, 0b00010, 0b00100, 0b01000, 0b10011, 0b00011}, // %
+    {0b01100, 0b10010, 0b10100, 0b01000, 0b10101, 0b10010, 0b01101}, // &
+    {0b01100, 0b00100, 0b01000, 0b00000, 0b00000, 0b00000, 0b00000}, // '
+    {0b00010, 0b00100, 0b01000, 0b01000, 0b01000, 0b00100, 0b00010}, // (
+    {0b01000, 0b00100, 0b00010, 0b00010, 0b00010, 0b00100, 0b01000}, // )
+    {0b00000, 0b00100, 0b10101, 0b01110, 0b10101, 0b00100, 0b00000}, // *
+    {0b00000, 0b00100, 0b00100, 0b11111, 0b00100, 0b00100, 0b00000}, // +
+    {0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b00100, 0b01000}, // ,
+    {0b00000, 0b00000, 0b00000, 0b11111, 0b00000, 0b00000, 0b00000}, // -
+    {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b01100, 0b01100}, // .
+    {0b00000, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b00000}, // /
+    {0b01110, 0b10001, 0b10011, 0b10101, 0b11001, 0b10001, 0b01110}, // 0
+    {0b00100, 0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110}, // 1
+    {0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b01000, 0b11111}, // 2
+    {0b11111, 0b00010, 0b00100, 0b00010, 0b00001, 0b10001, 0b01110}, // 3
+    {0b00010, 0b00110, 0b01010, 0b10010, 0b11111, 0b00010, 0b00010}, // 4
+    {0b11111, 0b10000, 0b11110, 0b00001, 0b00001, 0b10001, 0b01110}, // 5
+    {0b00110, 0b01000, 0b10000, 0b11110, 0b10001, 0b10001, 0b01110}, // 6
+    {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b01000, 0b01000}, // 7
+    {0b01110, 0b10001, 0b10001, 0b01110, 0b10001, 0b10001, 0b01110}, // 8
+    {0b01110, 0b10001, 0b10001, 0b01111, 0b00001, 0b00010, 0b01100}, // 9
+    {0b00000, 0b01100, 0b01100, 0b00000, 0b01100, 0b01100, 0b00000}, // :
+    {0b00000, 0b01100, 0b01100, 0b00000, 0b01100, 0b00100, 0b01000}, // ;
+    {0b00010, 0b00100, 0b01000, 0b10000, 0b01000, 0b00100, 0b00010}, // <
+    {0b00000, 0b00000, 0b11111, 0b00000, 0b11111, 0b00000, 0b00000}, // =
+    {0b01000, 0b00100, 0b00010, 0b00001, 0b00010, 0b00100, 0b01000}, // >
+    {0b01110, 0b10001, 0b00001, 0b00010, 0b00100, 0b00000, 0b00100}, // ?
+    {0b01110, 0b10001, 0b00001, 0b01101, 0b10101, 0b10101, 0b01110}, // @
+    {0b01110, 0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001}, // A
+    {0b11110, 0b10001, 0b10001, 0b11110, 0b10001, 0b10001, 0b11110}, // B
+    {0b01110, 0b10001, 0b10000, 0b10000, 0b10000, 0b10001, 0b01110}, // C
+    {0b11100, 0b10010, 0b10001, 0b10001, 0b10001, 0b10010, 0b11100}, // D
+    {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b11111}, // E
+    {0b11111, 0b10000, 0b10000, 0b11110, 0b10000, 0b10000, 0b10000}, // F
+    {0b01110, 0b10001, 0b10000, 0b10111, 0b10001, 0b10001, 0b01111}, // G
+    {0b10001, 0b10001, 0b10001, 0b11111, 0b10001, 0b10001, 0b10001}, // H
+    {0b01110, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110}, // I
+    {0b00111, 0b00010, 0b00010, 0b00010, 0b00010, 0b10010, 0b01100}, // J
+    {0b10001, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010, 0b10001}, // K
+    {0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b11111}, // L
+    {0b10001, 0b11011, 0b10101, 0b10101, 0b10001, 0b10001, 0b10001}, // M
+    {0b10001, 0b10001, 0b11001, 0b10101, 0b10011, 0b10001, 0b10001}, // N
+    {0b01110, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110}, // O
+    {0b11110, 0b10001, 0b10001, 0b11110, 0b10000, 0b10000, 0b10000}, // P
+    {0b01110, 0b10001, 0b10001, 0b10001, 0b10101, 0b10010, 0b01101}, // Q
+    {0b11110, 0b10001, 0b10001, 0b11110, 0b10100, 0b10010, 0b10001}, // R
+    {0b01111, 0b10000, 0b10000, 0b01110, 0b00001, 0b00001, 0b11110}, // S
+    {0b11111, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100}, // T
+    {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01110}, // U
+    {0b10001, 0b10001, 0b10001, 0b10001, 0b10001, 0b01010, 0b00100}, // V
+    {0b10001, 0b10001, 0b10001, 0b10101, 0b10101, 0b10101, 0b01010}, // W
+    {0b10001, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001, 0b10001}, // X
+    {0b10001, 0b10001, 0b10001, 0b01010, 0b00100, 0b00100, 0b00100}, // Y
+    {0b11111, 0b00001, 0b00010, 0b00100, 0b01000, 0b10000, 0b11111}, // Z
+    {0b01110, 0b01000, 0b01000, 0b01000, 0b01000, 0b01000, 0b01110}, // [
+    {0b00000, 0b10000, 0b01000, 0b00100, 0b00010, 0b00001, 0b00000}, // backslash
+    {0b01110, 0b00010, 0b00010, 0b00010, 0b00010, 0b00010, 0b01110}, // ]
+    {0b00100, 0b01010, 0b10001, 0b00000, 0b00000, 0b00000, 0b00000}, // ^
+    {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b11111}, // _
+    {0b01000, 0b00100, 0b00010, 0b00000, 0b00000, 0b00000, 0b00000}, // `
+    {0b00000, 0b00000, 0b01110, 0b00001, 0b01111, 0b10001, 0b01111}, // a
+    {0b10000, 0b10000, 0b10110, 0b11001, 0b10001, 0b10001, 0b11110}, // b
+    {0b00000, 0b00000, 0b01110, 0b10000, 0b10000, 0b10001, 0b01110}, // c
+    {0b00001, 0b00001, 0b01101, 0b10011, 0b10001, 0b10001, 0b01111}, // d
+    {0b00000, 0b00000, 0b01110, 0b10001, 0b11111, 0b10000, 0b01110}, // e
+    {0b00110, 0b01001, 0b01000, 0b11100, 0b01000, 0b01000, 0b01000}, // f
+    {0b00000, 0b01111, 0b10001, 0b10001, 0b01111, 0b00001, 0b01110}, // g
+    {0b10000, 0b10000, 0b10110, 0b11001, 0b10001, 0b10001, 0b10001}, // h
+    {0b00100, 0b00000, 0b01100, 0b00100, 0b00100, 0b00100, 0b01110}, // i
+    {0b00010, 0b00000, 0b00110, 0b00010, 0b00010, 0b10010, 0b01100}, // j
+    {0b10000, 0b10000, 0b10010, 0b10100, 0b11000, 0b10100, 0b10010}, // k
+    {0b01100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b01110}, // l
+    {0b00000, 0b00000, 0b11010, 0b10101, 0b10101, 0b10001, 0b10001}, // m
+    {0b00000, 0b00000, 0b10110, 0b11001, 0b10001, 0b10001, 0b10001}, // n
+    {0b00000, 0b00000, 0b01110, 0b10001, 0b10001, 0b10001, 0b01110}, // o
+    {0b00000, 0b00000, 0b11110, 0b10001, 0b11110, 0b10000, 0b10000}, // p
+    {0b00000, 0b00000, 0b01101, 0b10011, 0b01111, 0b00001, 0b00001}, // q
+    {0b00000, 0b00000, 0b10110, 0b11001, 0b10000, 0b10000, 0b10000}, // r
+    {0b00000, 0b00000, 0b01110, 0b10000, 0b01110, 0b00001, 0b11110}, // s
+    {0b01000, 0b01000, 0b11100, 0b01000, 0b01000, 0b01001, 0b00110}, // t
+    {0b00000, 0b00000, 0b10001, 0b10001, 0b10001, 0b10011, 0b01101}, // u
+    {0b00000, 0b00000, 0b10001, 0b10001, 0b10001, 0b01010, 0b00100}, // v
+    {0b00000, 0b00000, 0b10001, 0b10001, 0b10101, 0b10101, 0b01010}, // w
+    {0b00000, 0b00000, 0b10001, 0b01010, 0b00100, 0b01010, 0b10001}, // x
+    {0b00000, 0b00000, 0b10001, 0b10001, 0b01111, 0b00001, 0b01110}, // y
+    {0b00000, 0b00000, 0b11111, 0b00010, 0b00100, 0b01000, 0b11111}, // z
+    {0b00010, 0b00100, 0b00100, 0b01000, 0b00100, 0b00100, 0b00010}, // {
+    {0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100, 0b00100}, // |
+    {0b01000, 0b00100, 0b00100, 0b00010, 0b00100, 0b00100, 0b01000}, // }
+    {0b00000, 0b00000, 0b01000, 0b10101, 0b00010, 0b00000, 0b00000}, // ~
+};
+
+/**
+ * The part of the canvas that one tile covers, in pixels.
+ */
+struct tile {
+  Color* pPixels{};
+  int    X0{};
+  int    Y0{};
+  int    X1{}; //!< Exclusive, clipped to the canvas.
+  int    Y1{};
+};
+
+/**
+ * Blend Col over D with Coverage times its alpha.
+ */
+inline auto BlendPixel(Color& D, Color Col, float Coverage) -> void {
+  auto const A = int(Coverage * float(Col.a) + 0.5f);
+  if (A <= 0)
+    return;
+
+  if (A >= 255) {
+    D = Color{Col.r, Col.g, Col.b, 255};
+    return;
+  }
+  auto const B = 255 - A;
+  D.r          = uint8_t((Col.r * A + D.r * B + 127) / 255);
+  D.g          = uint8_t((Col.g * A + D.g * B + 127) / 255);
+  D.b          = uint8_t((Col.b * A + D.b * B + 127) / 255);
+  D.a          = uint8_t(A + (D.a * B + 127) / 255);
+}
+
+inline auto Blend(tile const& T, int X, int Y, Color Col, float Coverage) -> void {
+  BlendPixel(T.pPixels[(Y - T.Y0) * TileSize + (X - T.X0)], Col, Coverage);
+}
+
+inline auto Saturate(float V) -> float { return std::clamp(V, 0.f, 1.f); }
+
+/**
+ * Pixel bounds of a primitive, what Rasterize bins with.
+ */
+auto Bounds(canvas const& C, primitive const& P) -> std::array<float, 4> {
+  switch (P.Shape) {
+  case shape::Clear:
+    return {0.f, 0.f, float(C.Width), float(C.Height)};
+  case shape::Line:
+  case shape::Rect:
+    return {std::min(P.X0, P.X1) - 1.f, std::min(P.Y0, P.Y1) - 1.f, std::max(P.X0, P.X1) + 1.f,
+            std::max(P.Y0, P.Y1) + 1.f};
+  case shape::Ring:
+  case shape::Disc:
+    return {P.X0 - P.R - 1.f, P.Y0 - P.R - 1.f, P.X0 + P.R + 1.f, P.Y0 + P.R + 1.f};
+  case shape::Glyph:
+    return {P.X0 - 1.f,
+            P.Y0 - 1.f,
+            P.X0 + float(fluffy::softraster::GlyphCellW) * P.R + 1.f,
+            P.Y0 + float(fluffy::softraster::GlyphBaseSize) * P.R + 1.f};
+  }
+  return {};
+}
+
+/**
+ * Skip the tiles in the bounds that a line or a ring does not get near.
+ */
+auto Touches(primitive const& P, float TX0, float TY0) -> bool {
+  constexpr float Half    = 0.5f * float(TileSize);
+  constexpr float Reach   = 0.7072f * float(TileSize) + 1.f; //!< Half the diagonal and the anti-aliasing.
+  auto const      CentreX = TX0 + Half;
+  auto const      CentreY = TY0 + Half;
+
+  if (shape::Line == P.Shape) {
+    auto const Dx  = P.X1 - P.X0;
+    auto const Dy  = P.Y1 - P.Y0;
+    auto const Len = std::hypot(Dx, Dy);
+    return Len < 1.f || std::abs((CentreX - P.X0) * Dy - (CentreY - P.Y0) * Dx) / Len <= Reach;
+  }
+  if (shape::Ring == P.Shape) {
+    auto const Dist = std::hypot(CentreX - P.X0, CentreY - P.Y0);
+    return Dist + Reach >= P.R && Dist - Reach <= P.R;
+  }
+  return true;
+}
+
+/**
+ * Anti-aliased line one pixel wide. Walks the major axis, and on the minor axis covers
+ * the pixels as far from the line as their centre is from it.
+ */
+auto DrawLine(tile const& T, primitive const& P) -> void {
+  auto       X0    = P.X0;
+  auto       Y0    = P.Y0;
+  auto       X1    = P.X1;
+  auto       Y1    = P.Y1;
+  auto const Steep = std::abs(Y1 - Y0) > std::abs(X1 - X0);
+  if (Steep) {
+    std::swap(X0, Y0);
+    std::swap(X1, Y1);
+  }
+  if (X0 > X1) {
+    std::swap(X0, X1);
+    std::swap(Y0, Y1);
+  }
+
+  auto const Dx    = X1 - X0;
+  auto const Dy    = Y1 - Y0;
+  auto const Len   = std::hypot(Dx, Dy);
+  auto const Slope = Dx > 0.f ? Dy / Dx : 0.f;
+  auto const CosA  = Len > 0.f ? Dx / Len : 1.f;
+
+  // ---
+  // NOTE: The major axis of the tile, in the swapped space.
+  // ---
+  auto const MajorLo = Steep ? T.Y0 : T.X0;
+  auto const MajorHi = Steep ? T.Y1 : T.X1;
+  auto const MinorLo = Steep ? T.X0 : T.Y0;
+  auto const MinorHi = Steep ? T.X1 : T.Y1;
+
+  // ---
+  // NOTE: A pixel is covered when its centre is less than Reach from the line on the minor
+  //       axis, that is two pixels for an axis aligned line and at most three.
+  // ---
+  auto const Reach       = 1.f / CosA;
+  auto const MajorStride = Steep ? TileSize : 1;
+  auto const MinorStride = Steep ? 1 : TileSize;
+  auto const pOrigin     = T.pPixels - (MajorLo * MajorStride + MinorLo * MinorStride);
+
+  auto const First = std::max(int(std::floor(std::fmax(X0, float(MajorLo) - 1.f))), MajorLo);
+  auto const Last  = std::min(int(std::floor(std::fmin(X1, float(MajorHi)))), MajorHi - 1);
+  for (int Major = First; Major <= Last; ++Major) {
+    auto const Overlap = std::min(float(Major + 1), X1) - std::max(float(Major), X0);
+    auto const Along   = Dx > 0.f ? Overlap : 1.f;
+    auto const Centre  = std::clamp(float(Major) + 0.5f, X0, X1);
+    auto const Y       = Y0 + Slope * (Centre - X0) - 0.5f; //!< Against the pixel centres.
+
+    auto const MinorFirst = std::max(int(std::floor(Y - Reach)) + 1, MinorLo);
+    auto const MinorLast  = std::min(int(std::ceil(Y + Reach)) - 1, MinorHi - 1);
+    auto const pRow       = pOrigin + Major * MajorStride;
+    for (int Minor = MinorFirst; Minor <= MinorLast; ++Minor) {
+      auto const Coverage = Saturate(1.f - std::abs(float(Minor) - Y) * CosA) * Along;
+      BlendPixel(pRow[Minor * MinorStride], P.Col, Coverage);
+    }
+  }
+}
+
+/**
+ * Circle outline one pixel wide, only the pixels near the outline are visited.
+ */
+auto DrawRing(tile const& T, primitive const& P) -> void {
+  auto const Outer = P.R + 1.f;
+  auto const Inner = P.R - 1.f;
+  auto const RowLo = std::max(int(std::floor(P.Y0 - Outer)), T.Y0);
+  auto const RowHi = std::min(int(std::ceil(P.Y0 + Outer)), T.Y1 - 1);
+
+  for (int Y = RowLo; Y <= RowHi; ++Y) {
+    auto const Dy  = float(Y) + 0.5f - P.Y0;
+    auto const Out = std::sqrt(std::max(Outer * Outer - Dy * Dy, 0.f));
+    auto const In  = Inner > std::abs(Dy) ? std::sqrt(Inner * Inner - Dy * Dy) : 0.f;
+
+    auto ldaSpan = [&](float From, float To) {
+      auto const XLo = std::max(int(std::floor(From - 0.5f)), T.X0);
+      auto const XHi = std::min(int(std::ceil(To + 0.5f)), T.X1 - 1);
+      for (int X = XLo; X <= XHi; ++X) {
+        auto const Dist = std::hypot(float(X) + 0.5f - P.X0, Dy);
+        Blend(T, X, Y, P.Col, Saturate(1.f - std::abs(Dist - P.R)));
+      }
+    };
+
+    if (In < 1.f) {
+      ldaSpan(P.X0 - Out, P.X0 + Out);
+    } else {
+      ldaSpan(P.X0 - Out, P.X0 - In);
+      ldaSpan(P.X0 + In, P.X0 + Out);
+    }
+  }
+}
+
+/**
+ * Filled circle going from Col at the centre to Col2 at the edge.
+ */
+auto DrawDisc(tile const& T, primitive const& P) -> void {
+  auto const Outer = P.R + 0.5f;
+  auto const RowLo = std::max(int(std::floor(P.Y0 - Outer)), T.Y0);
+  auto const RowHi = std::min(int(std::ceil(P.Y0 + Outer)), T.Y1 - 1);
+
+  for (int Y = RowLo; Y <= RowHi; ++Y) {
+    auto const Dy  = float(Y) + 0.5f - P.Y0;
+    auto const Out = std::sqrt(std::max(Outer * Outer - Dy * Dy, 0.f));
+    auto const XLo = std::max(int(std::floor(P.X0 - Out)), T.X0);
+    auto const XHi = std::min(int(std::ceil(P.X0 + Out)), T.X1 - 1);
+    for (int X = XLo; X <= XHi; ++X) {
+      auto const Dist = std::hypot(float(X) + 0.5f - P.X0, Dy);
+      auto const F    = P.R > 0.f ? Saturate(Dist / P.R) : 0.f;
+      auto const Col  = Color{uint8_t(float(P.Col.r) + F * (float(P.Col2.r) - float(P.Col.r))),
+                              uint8_t(float(P.Col.g) + F * (float(P.Col2.g) - float(P.Col.g))),
+                              uint8_t(float(P.Col.b) + F * (float(P.Col2.b) - float(P.Col.b))),
+                              uint8_t(float(P.Col.a) + F * (float(P.Col2.a) - float(P.Col.a)))};
+      Blend(T, X, Y, Col, Saturate(Outer - Dist));
+    }
+  }
+}
+
+/**
+ * Axis aligned rectangle, the edge pixels covered by how much of them is inside.
+ */
+auto DrawRect(tile const& T, primitive const& P) -> void {
+  auto const X0  = std::min(P.X0, P.X1);
+  auto const X1  = std::max(P.X0, P.X1);
+  auto const Y0  = std::min(P.Y0, P.Y1);
+  auto const Y1  = std::max(P.Y0, P.Y1);
+  auto const XLo = std::max(int(std::floor(X0)), T.X0);
+  auto const XHi = std::min(int(std::ceil(X1)), T.X1) - 1;
+  auto const YLo = std::max(int(std::floor(Y0)), T.Y0);
+  auto const YHi = std::min(int(std::ceil(Y1)), T.Y1) - 1;
+
+  for (int Y = YLo; Y <= YHi; ++Y) {
+    auto const CovY = std::min(float(Y + 1), Y1) - std::max(float(Y), Y0);
+    for (int X = XLo; X <= XHi; ++X) {
+      auto const CovX = std::min(float(X + 1), X1) - std::max(float(X), X0);
+      Blend(T, X, Y, P.Col, Saturate(CovX) * Saturate(CovY));
+    }
+  }
+}
+
+/**
+ * Glyph scaled by R from the atlas, sampled bilinearly at the pixel centres.
+ */
+auto DrawGlyph(tile const& T, primitive const& P) -> void {
+  using namespace fluffy::softraster;
+
+  auto const& Atlas = GlyphAtlas();
+  auto const  CellX = P.Glyph * GlyphCellW;
+
+  auto ldaTexel = [&](int U, int V) -> float {
+    if (U < 0 || U >= GlyphCellW || V < 0 || V >= GlyphBaseSize)
+      return 0.f;
+    return float(Atlas.vCoverage[size_t(V) * size_t(Atlas.Width) + size_t(CellX + U)]);
+  };
+
+  auto const Inv = 1.f / P.R;
+  auto const XLo = std::max(int(std::floor(P.X0 - 1.f)), T.X0);
+  auto const XHi = std::min(int(std::ceil(P.X0 + float(GlyphCellW) * P.R + 1.f)), T.X1 - 1);
+  auto const YLo = std::max(int(std::floor(P.Y0 - 1.f)), T.Y0);
+  auto const YHi = std::min(int(std::ceil(P.Y0 + float(GlyphBaseSize) * P.R + 1.f)), T.Y1 - 1);
+
+  for (int Y = YLo; Y <= YHi; ++Y) {
+    auto const V  = (float(Y) + 0.5f - P.Y0) * Inv - 0.5f;
+    auto const V0 = int(std::floor(V));
+    auto const FV = V - float(V0);
+    for (int X = XLo; X <= XHi; ++X) {
+      auto const U      = (float(X) + 0.5f - P.X0) * Inv - 0.5f;
+      auto const U0     = int(std::floor(U));
+      auto const FU     = U - float(U0);
+      auto const Top    = ldaTexel(U0, V0) + FU * (ldaTexel(U0 + 1, V0) - ldaTexel(U0, V0));
+      auto const Bottom = ldaTexel(U0, V0 + 1) + FU * (ldaTexel(U0 + 1, V0 + 1) - ldaTexel(U0, V0 + 1));
+      Blend(T, X, Y, P.Col, (Top + FV * (Bottom - Top)) / 255.f);
+    }
+  }
+}
+
+auto DrawPrimitive(tile const& T, primitive const& P) -> void {
+  switch (P.Shape) {
+  case shape::Clear:
+    std::fill_n(T.pPixels, TileSize * TileSize, P.Col);
+    break;
+  case shape::Line:
+    DrawLine(T, P);
+    break;
+  case shape::Ring:
+    DrawRing(T, P);
+    break;
+  case shape::Disc:
+    DrawDisc(T, P);
+    break;
+  case shape::Rect:
+    DrawRect(T, P);
+    break;
+  case shape::Glyph:
+    DrawGlyph(T, P);
+    break;
+  }
+}
+
+/**
+ * Put the primitives from First up to Last into the bins of Thread.
+ */
+auto BinPrimitives(canvas& C, int Thread, size_t First, size_t Last) -> void {
+  auto const NumTiles = size_t(C.NumTilesX) * size_t(C.NumTilesY);
+  auto*      pBins    = C.vBins.data() + size_t(Thread) * NumTiles;
+
+  for (size_t Idx = First; Idx < Last; ++Idx) {
+    auto const& P = C.vPrimitives[Idx];
+    auto const  B = Bounds(C, P);
+    if (B[2] < 0.f || B[3] < 0.f)
+      continue;
+
+    // ---
+    // NOTE: Clamp in float first, a far endpoint, i.e. at deep zoom, does not fit in an int.
+    // ---
+    auto const ldaTile = [](float V, int Size) { return int(std::floor(std::fmin(std::fmax(V, -1.f), float(Size)))); };
+    auto const TX0     = std::max(ldaTile(B[0], C.Width) / TileSize, 0);
+    auto const TY0     = std::max(ldaTile(B[1], C.Height) / TileSize, 0);
+    auto const TX1     = std::min(ldaTile(B[2], C.Width) / TileSize, C.NumTilesX - 1);
+    auto const TY1     = std::min(ldaTile(B[3], C.Height) / TileSize, C.NumTilesY - 1);
+
+    for (int TY = TY0; TY <= TY1; ++TY)
+      for (int TX = TX0; TX <= TX1; ++TX)
+        if (Touches(P, float(TX * TileSize), float(TY * TileSize)))
+          pBins[size_t(TY) * size_t(C.NumTilesX) + size_t(TX)].push_back(uint32_t(Idx));
+  }
+}
+
+/**
+ * Draw the tiles the shared counter hands out, the bins of the threads in thread order so
+ * that the primitives are drawn in the order they came.
+ */
+auto DrawTiles(canvas& C, int NThreads, std::atomic<int>& NextTile) -> void {
+  auto const NumTiles = C.NumTilesX * C.NumTilesY;
+
+  for (int Idx = NextTile++; Idx < NumTiles; Idx = NextTile++) {
+    auto const TX = Idx % C.NumTilesX;
+    auto const TY = Idx / C.NumTilesX;
+    auto const T  = tile{C.vPixels.data() + size_t(Idx) * TileSize * TileSize,
+                        TX * TileSize,
+                        TY * TileSize,
+                        std::min((TX + 1) * TileSize, C.Width),
+                        std::min((TY + 1) * TileSize, C.Height)};
+
+    for (int Thread = 0; Thread < NThreads; ++Thread)
+      for (auto const PrimIdx : C.vBins[size_t(Thread) * size_t(NumTiles) + size_t(Idx)])
+        DrawPrimitive(T, C.vPrimitives[PrimIdx]);
+  }
+}
+
+}; // namespace
+
+namespace fluffy {
+namespace softraster {
+
+/**
+ */
+auto GlyphAtlas() -> glyph_atlas const& {
+  static glyph_atlas const Atlas = [] {
+    glyph_atlas Result{NumGlyphs * GlyphCellW, GlyphBaseSize};
+    Result.vCoverage.resize(size_t(Result.Width) * size_t(Result.Height));
+
+    // ---
+    // NOTE: The 5 x 7 glyphs go one row down in the cells, the rows below are for descenders.
+    // ---
+    for (int Glyph = 0; Glyph < NumGlyphs; ++Glyph)
+      for (int Row = 0; Row < 7; ++Row)
+        for (int Col = 0; Col < 5; ++Col)
+          if (aFont5x7[Glyph][Row] & (0x10 >> Col))
+            Result.vCoverage[size_t(Row + 1) * size_t(Result.Width) + size_t(Glyph * GlyphCellW + Col)] = 255;
+    return Result;
+  }();
+  return Atlas;
+}
+
+/**
+ */
+auto Canvas(int Width, int Height, int NThreads) -> canvas {
+  canvas C{};
+  C.Width     = std::max(Width, 1);
+  C.Height    = std::max(Height, 1);
+  C.NumTilesX = (C.Width + TileSize - 1) / TileSize;
+  C.NumTilesY = (C.Height + TileSize - 1) / TileSize;
+  C.NThreads  = NThreads > 0 ? NThreads : std::max<int>(std::thread::hardware_concurrency(), 1);
+  C.vPixels.resize(size_t(C.NumTilesX) * size_t(C.NumTilesY) * TileSize * TileSize);
+  return C;
+}
+
+/**
+ */
+auto Begin(canvas& C) -> void { C.vPrimitives.clear(); }
+
+auto Clear(canvas& C, Color Col) -> void { C.vPrimitives.push_back(primitive{.Shape = shape::Clear, .Col = Col}); }
+
+auto Line(canvas& C, float X0, float Y0, float X1, float Y1, Color Col) -> void {
+  C.vPrimitives.push_back(primitive{.Shape = shape::Line, .X0 = X0, .Y0 = Y0, .X1 = X1, .Y1 = Y1, .Col = Col});
+}
+
+/**
+ * A negative radius draws the same circle, as it does in raylib.
+ */
+auto Ring(canvas& C, float X, float Y, float Radius, Color Col) -> void {
+  C.vPrimitives.push_back(primitive{.Shape = shape::Ring, .X0 = X, .Y0 = Y, .R = std::abs(Radius), .Col = Col});
+}
+
+auto Disc(canvas& C, float X, float Y, float Radius, Color Inner, Color Outer) -> void {
+  C.vPrimitives.push_back(
+      primitive{.Shape = shape::Disc, .X0 = X, .Y0 = Y, .R = std::abs(Radius), .Col = Inner, .Col2 = Outer});
+}
+
+auto Rect(canvas& C, float X0, float Y0, float X1, float Y1, Color Col) -> void {
+  C.vPrimitives.push_back(primitive{.Shape = shape::Rect, .X0 = X0, .Y0 = Y0, .X1 = X1, .Y1 = Y1, .Col = Col});
+}
+
+/**
+ * Glyphs outside of the atlas are left out.
+ */
+auto Glyph(canvas& C, float X, float Y, int Index, float FontSize, Color Col) -> void {
+  if (Index < 0 || Index >= NumGlyphs || FontSize <= 0.f)
+    return;
+  C.vPrimitives.push_back(primitive{
+      .Shape = shape::Glyph, .X0 = X, .Y0 = Y, .R = FontSize / float(GlyphBaseSize), .Col = Col, .Glyph = Index});
+}
+
+/**
+ * The spacing is FontSize / 10 as in DrawText.
+ */
+auto GlyphStep(float FontSize) -> float {
+  return float(GlyphAdvance) * FontSize / float(GlyphBaseSize) + FontSize / 10.f;
+}
+
+/**
+ * Characters that are not in the atlas are drawn as '?'.
+ */
+auto Text(canvas& C, char const* pText, float X, float Y, float FontSize, Color Col) -> float {
+  auto const Step = GlyphStep(FontSize);
+  auto       XPos = X;
+
+  for (auto const* pC = pText; *pC; ++pC) {
+    auto const Index = (*pC >= ' ' && *pC <= '~') ? *pC - ' ' : '?' - ' ';
+    if (Index)
+      Glyph(C, XPos, Y, Index, FontSize, Col);
+    XPos += Step;
+  }
+  return XPos - X;
+}
+
+/**
+ */
+auto Rasterize(canvas& C) -> void {
+  auto const NumTiles = size_t(C.NumTilesX) * size_t(C.NumTilesY);
+  auto const NThreads = int(std::clamp<size_t>(std::min<size_t>(size_t(C.NThreads), NumTiles), 1, 256));
+  auto const NumPrims = C.vPrimitives.size();
+
+  C.vBins.resize(size_t(NThreads) * NumTiles);
+  for (auto& vBin : C.vBins)
+    vBin.clear();
+
+  // ---
+  // NOTE: All threads bin before any of them draws, the calling thread is one of them.
+  // ---
+  std::atomic<int> NextTile{};
+  std::barrier<>   Sync(NThreads);
+  auto             ldaWork = [&](int Thread) {
+    BinPrimitives(C,
+                  Thread,
+                  NumPrims * size_t(Thread) / size_t(NThreads),
+                  NumPrims * size_t(Thread + 1) / size_t(NThreads));
+    Sync.arrive_and_wait();
+    DrawTiles(C, NThreads, NextTile);
+  };
+
+  std::vector<std::thread> vT{};
+  for (int Thread = 1; Thread < NThreads; ++Thread)
+    vT.push_back(std::thread(ldaWork, Thread));
+  ldaWork(0);
+
+  for (auto& T : vT)
+    T.join();
+}
+
+/**
+ */
+auto GetPixel(canvas const& C, int X, int Y) -> Color {
+  if (X < 0 || Y < 0 || X >= C.Width || Y >= C.Height)
+    return Color{};
+  auto const Tile = size_t(Y / TileSize) * size_t(C.NumTilesX) + size_t(X / TileSize);
+  return C.vPixels[Tile * TileSize * TileSize + size_t(Y % TileSize) * TileSize + size_t(X % TileSize)];
+}
+
+/**
+ */
+auto CopyPixels(canvas const& C, Color* pOut) -> void {
+  for (int Y = 0; Y < C.Height; ++Y) {
+    auto const* pRow = C.vPixels.data() + size_t(Y / TileSize) * size_t(C.NumTilesX) * TileSize * TileSize +
+                       size_t(Y % TileSize) * TileSize;
+    for (int TX = 0; TX < C.NumTilesX; ++TX) {
+      auto const Num = std::min(TileSize, C.Width - TX * TileSize);
+      std::memcpy(pOut + size_t(Y) * size_t(C.Width) + size_t(TX) * TileSize,
+                  pRow + size_t(TX) * TileSize * TileSize,
+                  size_t(Num) * sizeof(Color));
+    }
+  }
+}
+
+/**
+ */
+auto GenImageCanvas(canvas const& C) -> Image {
+  Image Result{};
+  Result.data    = MemAlloc(static_cast<unsigned int>(size_t(C.Width) * size_t(C.Height) * sizeof(Color)));
+  Result.width   = C.Width;
+  Result.height  = C.Height;
+  Result.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  Result.mipmaps = 1;
+
+  CopyPixels(C, static_cast<Color*>(Result.data));
+  return Result;
+}
+
+}; // namespace softraster
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,153 @@
+#ifndef SRC_SOFTRASTER_HPP
+#define SRC_SOFTRASTER_HPP
+
+/**
+ * CPU rasterizer for the 2D primitives of the curves pages, for images made without a
+ * display.
+ *
+ * The primitives of a frame are collected first. Rasterize then bins them into square
+ * tiles of the canvas, each thread binning its own range of primitives, and the threads
+ * take one tile at a time and draw the primitives of it in the order they came. A tile is
+ * TileSize x TileSize pixels stored together, so that a thread only writes to the cache
+ * lines of its own tile.
+ *
+ * Lines and circles are anti-aliased from the distance of the pixel centre to the shape,
+ * walking the major axis of a line as Wu's algorithm does. Text is sampled from a glyph
+ * atlas baked from a 5 x 7 bitmap font, with glyph index 0 at space as in the default font
+ * of raylib.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace fluffy {
+namespace softraster {
+
+constexpr int TileSize = 64;
+
+constexpr int GlyphBaseSize = 10; //!< Atlas cell height, the font size that draws the atlas 1:1.
+constexpr int GlyphCellW    = 6;
+constexpr int GlyphAdvance  = 5;  //!< Pixels to the next glyph at GlyphBaseSize, without the spacing.
+constexpr int NumGlyphs     = 95; //!< Space to tilde.
+
+enum class shape : uint8_t { Clear, Line, Ring, Disc, Rect, Glyph };
+
+/**
+ * One primitive in pixels. A line goes from X0, Y0 to X1, Y1. Ring and Disc are centred at
+ * X0, Y0 with radius R, a disc going from Col at the centre to Col2 at the edge. A rect is
+ * X0, Y0 to X1, Y1. A glyph has its top left corner at X0, Y0 and is R times the atlas.
+ */
+struct primitive {
+  shape   Shape{};
+  float   X0{};
+  float   Y0{};
+  float   X1{};
+  float   Y1{};
+  float   R{};
+  Color   Col{};
+  Color   Col2{};
+  int32_t Glyph{};
+};
+
+/**
+ * Coverage of the glyphs, NumGlyphs cells of GlyphCellW x GlyphBaseSize in one row.
+ */
+struct glyph_atlas {
+  int                  Width{};
+  int                  Height{};
+  std::vector<uint8_t> vCoverage{};
+};
+
+struct canvas {
+  int                                Width{};
+  int                                Height{};
+  int                                NumTilesX{};
+  int                                NumTilesY{};
+  int                                NThreads{};
+  std::vector<Color>                 vPixels{}; //!< Tile by tile, each tile row by row.
+  std::vector<primitive>             vPrimitives{};
+  std::vector<std::vector<uint32_t>> vBins{}; //!< Primitive indices per thread and tile.
+};
+
+/**
+ * The atlas, baked the first time it is used.
+ */
+auto GlyphAtlas() -> glyph_atlas const&;
+
+/**
+ * A transparent canvas of Width x Height pixels. NThreads 0 means use all available.
+ */
+auto Canvas(int Width, int Height, int NThreads = 0) -> canvas;
+
+/**
+ * Start a new frame, the pixels are kept until something is drawn over them.
+ */
+auto Begin(canvas& C) -> void;
+
+auto Clear(canvas& C, Color Col) -> void;
+auto Line(canvas& C, float X0, float Y0, float X1, float Y1, Color Col) -> void;
+auto Ring(canvas& C, float X, float Y, float Radius, Color Col) -> void;
+auto Disc(canvas& C, float X, float Y, float Radius, Color Inner, Color Outer) -> void;
+auto Rect(canvas& C, float X0, float Y0, float X1, float Y1, Color Col) -> void;
+auto Glyph(canvas& C, float X, float Y, int Index, float FontSize, Color Col) -> void;
+
+/**
+ * Pixels from one glyph to the next at FontSize, the advance and the spacing of DrawText.
+ */
+auto GlyphStep(float FontSize) -> float;
+
+/**
+ * Text from X, Y with the same spacing as DrawText. Returns the width in pixels.
+ */
+auto Text(canvas& C, char const* pText, float X, float Y, float FontSize, Color Col) -> float;
+
+/**
+ * Draw the primitives since Begin into the pixels.
+ */
+auto Rasterize(canvas& C) -> void;
+
+auto GetPixel(canvas const& C, int X, int Y) -> Color;
+
+/**
+ * The pixels row by row, Width x Height of them.
+ */
+auto CopyPixels(canvas const& C, Color* pOut) -> void;
+
+/**
+ * The pixels as an R8G8B8A8 image, unload it with UnloadImage.
+ */
+auto GenImageCanvas(canvas const& C) -> Image;
+
+}; // namespace softraster
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,363 @@
+/**
+ * Trend points for the trails drawn behind the animations.
+ *
+ * MIT License - see bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+#include "trendbuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace fluffy {
+namespace trend {
+
+ring_buffer::ring_buffer(size_t Capacity)
+    : vX(Capacity), vY(Capacity), vChunkBounds(Capacity ? Capacity / ChunkSize + 2 : 0) {}
+
+auto ring_buffer::Push(float X, float Y) -> void {
+  if (vX.empty())
+    return;
+
+  vX[Head] = X;
+  vY[Head] = Y;
+  Head     = Head + 1 == vX.size() ? 0 : Head + 1;
+
+  auto& Bounds = vChunkBounds[(Pushed / ChunkSize) % vChunkBounds.size()];
+  if (0 == Pushed % ChunkSize)
+    Bounds = es::bounds2{};
+  es::Expand(Bounds, X, Y);
+
+  if (Count < vX.size())
+    ++Count;
+  ++Pushed;
+}
+
+auto ring_buffer::Reset(size_t Capacity) -> void {
+  if (Capacity != vX.size()) {
+    vX.assign(Capacity, 0.f);
+    vY.assign(Capacity, 0.f);
+    vChunkBounds.assign(Capacity ? Capacity / ChunkSize + 2 : 0, es::bounds2{});
+  }
+  Clear();
+}
+
+auto ring_buffer::Clear() -> void {
+  Head   = 0;
+  Count  = 0;
+  Pushed = 0;
+  ++Cleared;
+}
+
+/**
+ * Until the ring is full the points are in [0, Count). After that the oldest point is at
+ * Head, so the order is [Head, Capacity) followed by [0, Head).
+ */
+auto ring_buffer::Segments() const -> std::array<segment, 2> {
+  std::span<float const> X(vX);
+  std::span<float const> Y(vY);
+  if (!Full())
+    return {segment{X.first(Count), Y.first(Count)}, segment{}};
+  return {segment{X.subspan(Head), Y.subspan(Head)}, segment{X.first(Head), Y.first(Head)}};
+}
+
+//------------------------------------------------------------------------------
+/**
+ * The new points are the last NumNew of the trend, and are transformed in one pass. When
+ * the trail is built again only the runs of chunks of the trend near the view are. Points
+ * that have left the trend are dropped from the front.
+ */
+auto pixel_trail::Update(ring_buffer const& Trend, es::affine2 const& E2P, es::bounds2 const& View) -> size_t {
+  auto const SameZoom = E2P.Scale.x == this->E2P.Scale.x && E2P.Scale.y == this->E2P.Scale.y;
+  auto const Rebuild  = !SameZoom || Trend.NumCleared() != Cleared || Trend.Capacity() != Capacity ||
+                       !es::Contains(Built, View);
+  if (Rebuild) {
+    Points.clear();
+    vTail.clear();
+    Built = es::Grow(View, CullMargin);
+  } else if (E2P.Offset.x != this->E2P.Offset.x || E2P.Offset.y != this->E2P.Offset.y) {
+    auto const DX = E2P.Offset.x - this->E2P.Offset.x;
+    auto const DY = E2P.Offset.y - this->E2P.Offset.y;
+    for (auto& P : Points) {
+      P.X += DX;
+      P.Y += DY;
+    }
+    for (auto& P : vTail) {
+      P.X += DX;
+      P.Y += DY;
+    }
+  }
+  auto const NumNew = Rebuild ? Trend.Size() : std::min<size_t>(Trend.NumPushed() - Pushed, Trend.Size());
+
+  this->E2P = E2P;
+  First     = Trend.NumPushed() - Trend.Size();
+  TrendSize = Trend.Size();
+  Capacity  = Trend.Capacity();
+  Pushed    = Trend.NumPushed();
+  Cleared   = Trend.NumCleared();
+
+  auto ldaInside = [this](float X, float Y) {
+    return Built.MinX <= X && X <= Built.MaxX && Built.MinY <= Y && Y <= Built.MaxY;
+  };
+  auto ldaPoint = [this](size_t Idx, float X, float Y) { return trail_point{X, Y, First + Idx}; };
+
+  size_t NumTransformed{};
+  if (Rebuild) {
+    Trend.ForEachRunIn(Built, [&](size_t Begin, size_t End) {
+      Begin = Begin ? Begin - 1 : 0;
+      End   = std::min(End + 1, Trend.Size());
+      TransformRange(Trend, Begin, End);
+      for (size_t Idx = Begin; Idx < End; ++Idx)
+        Append(ldaPoint(Idx, vNewX[Idx - Begin], vNewY[Idx - Begin]));
+      NumTransformed += End - Begin;
+    });
+  } else if (NumNew) {
+    auto const Begin = Trend.Size() - NumNew;
+    TransformRange(Trend, Begin, Trend.Size());
+    NumTransformed = NumNew;
+
+    // ---
+    // NOTE: A point is kept when it or the point before it is inside. When a point comes
+    //       inside after points that were culled, the one before it is kept too.
+    // ---
+    auto PrvInside = Begin && ldaInside(Trend.X(Begin - 1), Trend.Y(Begin - 1));
+    for (size_t Idx = Begin; Idx < Trend.Size(); ++Idx) {
+      auto const Inside = ldaInside(Trend.X(Idx), Trend.Y(Idx));
+      auto const Num    = First + Idx;
+      if (Inside && Idx && NextNum != Num) {
+        auto const Prv = E2P * Vector2{Trend.X(Idx - 1), Trend.Y(Idx - 1)};
+        Append(trail_point{Prv.x, Prv.y, Num - 1});
+        ++NumTransformed;
+      }
+      if (Inside || PrvInside)
+        Append(ldaPoint(Idx, vNewX[Idx - Begin], vNewY[Idx - Begin]));
+      PrvInside = Inside;
+    }
+  }
+
+  while (!Points.empty() && Points.front().Num < First)
+    Points.pop_front();
+  if (Points.empty())
+    std::erase_if(vTail, [this](trail_point const& P) { return P.Num < First; });
+
+  return NumTransformed;
+}
+
+/**
+ * From the one or two segments of the ring that the points are in.
+ */
+auto pixel_trail::TransformRange(ring_buffer const& Trend, size_t Begin, size_t End) -> void {
+  vNewX.resize(End - Begin);
+  vNewY.resize(End - Begin);
+  std::span<float> NewX(vNewX);
+  std::span<float> NewY(vNewY);
+  size_t           SegBegin{}; //!< Logical index of the first point of the segment.
+  for (auto const& Seg : Trend.Segments()) {
+    auto const SegEnd = SegBegin + Seg.X.size();
+    auto const Lo     = std::clamp(Begin, SegBegin, SegEnd);
+    auto const Hi     = std::clamp(End, SegBegin, SegEnd);
+    if (Lo < Hi) {
+      es::TransformPoints(E2P,
+                          Seg.X.subspan(Lo - SegBegin, Hi - Lo),
+                          Seg.Y.subspan(Lo - SegBegin, Hi - Lo),
+                          NewX.subspan(Lo - Begin),
+                          NewY.subspan(Lo - Begin));
+    }
+    SegBegin = SegEnd;
+  }
+}
+
+/**
+ * A point closer than Tolerance to the last point kept is dropped, unless it starts a new
+ * run after a gap. A gap also ends the chunk being collected, since the line is broken there.
+ */
+auto pixel_trail::Append(trail_point const& P) -> void {
+  auto const Gap = !(Points.empty() && vTail.empty()) && P.Num != NextNum;
+  NextNum        = P.Num + 1;
+
+  auto Point = P;
+  Point.Gap  = Gap;
+  if (Tolerance <= 0.f) {
+    Points.push_back(Point);
+    return;
+  }
+
+  auto const* pLast = !vTail.empty() ? &vTail.back() : !Points.empty() ? &Points.back() : nullptr;
+  if (!Gap && pLast) {
+    auto const DX = Point.X - pLast->X;
+    auto const DY = Point.Y - pLast->Y;
+    if (DX * DX + DY * DY < Tolerance * Tolerance)
+      return;
+  }
+
+  if (Gap)
+    FlushTail();
+  vTail.push_back(Point);
+  if (ChunkSize == vTail.size()) {
+    Simplify(vTail, Tolerance, vKeep);
+    for (size_t Pos = 0; Pos + 1 < vTail.size(); ++Pos)
+      if (vKeep[Pos])
+        Points.push_back(vTail[Pos]);
+    vTail.erase(vTail.begin(), vTail.end() - 1);
+  }
+}
+
+/**
+ * Simplify what is in the tail and move all of it to Points.
+ */
+auto pixel_trail::FlushTail() -> void {
+  Simplify(vTail, Tolerance, vKeep);
+  for (size_t Pos = 0; Pos < vTail.size(); ++Pos)
+    if (vKeep[Pos])
+      Points.push_back(vTail[Pos]);
+  vTail.clear();
+}
+
+auto pixel_trail::AlphaRamp() -> std::span<uint8_t const> {
+  auto const N = TrendSize;
+  if (vAlpha.size() != N) {
+    vAlpha.resize(N);
+    for (size_t Idx = 0; Idx < N; ++Idx)
+      vAlpha[Idx] = uint8_t((Idx + 1) * 255 / N);
+  }
+  return vAlpha;
+}
+
+/**
+ * Iterative, with the ranges still to look at on a stack. A range keeps the point furthest
+ * from the line between its ends when that point is more than Tolerance away, and is split
+ * there.
+ */
+auto Simplify(std::span<trail_point const> Line, float Tolerance, std::vector<bool>& vKeep) -> void {
+  vKeep.assign(Line.size(), false);
+  if (Line.empty())
+    return;
+  vKeep.front() = true;
+  vKeep.back()  = true;
+
+  auto const                             Tolerance2 = Tolerance * Tolerance;
+  std::vector<std::pair<size_t, size_t>> vRanges{{0, Line.size() - 1}};
+  while (!vRanges.empty()) {
+    auto const [A, B] = vRanges.back();
+    vRanges.pop_back();
+
+    auto const DX   = Line[B].X - Line[A].X;
+    auto const DY   = Line[B].Y - Line[A].Y;
+    auto const Len2 = DX * DX + DY * DY;
+
+    // ---
+    // NOTE: Squared distances from the line through A and B, or from A when A and B are
+    //       at the same place.
+    // ---
+    auto   MaxDist2 = 0.f;
+    size_t MaxIdx   = A;
+    for (size_t Idx = A + 1; Idx < B; ++Idx) {
+      auto const PX    = Line[Idx].X - Line[A].X;
+      auto const PY    = Line[Idx].Y - Line[A].Y;
+      auto const Cross = DX * PY - DY * PX;
+      auto const Dist2 = Len2 > 0.f ? Cross * Cross / Len2 : PX * PX + PY * PY;
+      if (Dist2 > MaxDist2) {
+        MaxDist2 = Dist2;
+        MaxIdx   = Idx;
+      }
+    }
+
+    if (MaxDist2 > Tolerance2) {
+      vKeep[MaxIdx] = true;
+      vRanges.push_back({A, MaxIdx});
+      vRanges.push_back({MaxIdx, B});
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+spsc_queue::spsc_queue(size_t Capacity)
+    : vX(std::bit_ceil(std::max<size_t>(Capacity, 2))), vY(vX.size()), Mask(vX.size() - 1) {}
+
+/**
+ * Only the producer writes WriteIdx, so it is read relaxed. ReadIdx is only loaded again
+ * when the cached copy leaves too little room for all of the samples.
+ */
+auto spsc_queue::Push(std::span<float const> Xs, std::span<float const> Ys) -> size_t {
+  auto const Write = WriteIdx.load(std::memory_order_relaxed);
+  auto       N     = std::min(Xs.size(), Ys.size());
+  if (Write - CachedReadIdx + N > Capacity())
+    CachedReadIdx = ReadIdx.load(std::memory_order_acquire);
+  N = std::min(N, Capacity() - (Write - CachedReadIdx));
+
+  for (size_t Idx = 0; Idx < N; ++Idx) {
+    auto const Slot = (Write + Idx) & Mask;
+    vX[Slot]        = Xs[Idx];
+    vY[Slot]        = Ys[Idx];
+  }
+  WriteIdx.store(Write + N, std::memory_order_release);
+  return N;
+}
+
+auto spsc_queue::Push(float X, float Y) -> bool { return 1 == Push(std::span(&X, 1), std::span(&Y, 1)); }
+
+/**
+ * WriteIdx is only loaded again when the cached copy has fewer samples than asked for, and
+ * ReadIdx is published once for the whole batch.
+ */
+auto spsc_queue::PopInto(ring_buffer& Trend, size_t MaxSamples) -> size_t {
+  auto const Read = ReadIdx.load(std::memory_order_relaxed);
+  if (CachedWriteIdx - Read < MaxSamples)
+    CachedWriteIdx = WriteIdx.load(std::memory_order_acquire);
+
+  auto const N = std::min(CachedWriteIdx - Read, MaxSamples);
+  for (size_t Idx = 0; Idx < N; ++Idx) {
+    auto const Slot = (Read + Idx) & Mask;
+    Trend.Push(vX[Slot], vY[Slot]);
+  }
+  ReadIdx.store(Read + N, std::memory_order_release);
+  return N;
+}
+
+auto spsc_queue::Size() const -> size_t {
+  return WriteIdx.load(std::memory_order_acquire) - ReadIdx.load(std::memory_order_acquire);
+}
+
+//------------------------------------------------------------------------------
+channel::channel(std::string Name, size_t QueueCapacity, size_t TrendCapacity)
+    : Name(std::move(Name)), Queue(QueueCapacity), Trend(TrendCapacity) {}
+
+auto AddChannel(channels& Channels, std::string Name, size_t QueueCapacity, size_t TrendCapacity) -> channel& {
+  Channels.vChannels.push_back(std::make_unique<channel>(std::move(Name), QueueCapacity, TrendCapacity));
+  return *Channels.vChannels.back();
+}
+
+auto DrainAll(channels& Channels, size_t MaxPerChannel) -> size_t {
+  size_t Total{};
+  for (auto& upChannel : Channels.vChannels)
+    Total += upChannel->Queue.PopInto(upChannel->Trend, MaxPerChannel);
+  return Total;
+}
+
+}; // namespace trend
+}; // namespace fluffy
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,368 @@
+#ifndef SRC_TRENDBUFFER_HPP
+#define SRC_TRENDBUFFER_HPP
+
+/**
+ * Trend points for the trails drawn behind the animations.
+ *
+ * A fixed number of points in a ring, with x and y in separate arrays so that the
+ * conversion to pixels and the drawing run through contiguous floats. When the ring
+ * is full a new point overwrites the oldest one, so the memory used is set by the
+ * capacity and not by how long the animation has been running.
+ *
+ * A pixel trail follows a trend, so that a frame only transforms the points pushed since
+ * the frame before.
+ *
+ * Live signals come in through channels. Each channel has one producer thread that
+ * pushes samples into a wait free single producer, single consumer queue, and the
+ * draw loop moves what has arrived into the trend of the channel once per frame.
+ * Neither side takes a lock, so a producer running at 10+ kHz does not stall the
+ * rendering, and a slow frame only makes the queue fill up.
+ *
+ * Copyright (c) 2023 Willy Clarke
+ *
+ * MIT License - see bottom of file.
+ */
+
+#include "engsupport.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace fluffy {
+namespace trend {
+
+/**
+ * Points in one contiguous part of the ring, in logical order.
+ */
+struct segment {
+  std::span<float const> X{};
+  std::span<float const> Y{};
+};
+
+/**
+ * Bounds that everything is inside, for no culling.
+ */
+constexpr es::bounds2 Everywhere{-std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::infinity(),
+                                 std::numeric_limits<float>::infinity()};
+
+/**
+ * Ring of 2D points. Logical index 0 is the oldest point and Size() - 1 the newest.
+ *
+ * The points are also grouped in chunks of ChunkSize in push order, each with its bounds,
+ * as a coarse index for culling. The bounds of a chunk can be larger than the points of it
+ * that are still in the ring, never smaller.
+ */
+struct ring_buffer {
+  static constexpr size_t ChunkSize = 256;
+
+  explicit ring_buffer(size_t Capacity = 0);
+
+  /**
+   * Add a point, overwriting the oldest one when full. Does nothing with zero capacity.
+   */
+  auto Push(float X, float Y) -> void;
+
+  /**
+   * Remove all points, and change the capacity when it is not the same.
+   */
+  auto Reset(size_t Capacity) -> void;
+  auto Clear() -> void;
+
+  auto Size() const -> size_t { return Count; }
+  auto Capacity() const -> size_t { return vX.size(); }
+  auto Full() const -> bool { return Count == vX.size(); }
+
+  /**
+   * Number of points pushed since the last Reset or Clear, including the overwritten ones.
+   * The point at logical index Idx is number NumPushed() - Size() + Idx.
+   */
+  auto NumPushed() const -> uint64_t { return Pushed; }
+
+  /**
+   * Number of Reset and Clear calls, so that a copy of the points can tell when it is stale.
+   */
+  auto NumCleared() const -> uint64_t { return Cleared; }
+
+  /**
+   * The point at logical index Idx, which must be less than Size().
+   */
+  auto X(size_t Idx) const -> float { return vX[Slot(Idx)]; }
+  auto Y(size_t Idx) const -> float { return vY[Slot(Idx)]; }
+
+  /**
+   * The points in logical order as two contiguous parts, the oldest first. The second
+   * part is empty until the ring has wrapped around.
+   */
+  auto Segments() const -> std::array<segment, 2>;
+
+  /**
+   * Call Fn(Idx, X, Y) for all points in logical order.
+   */
+  template <typename F> auto ForEach(F&& Fn) const -> void {
+    size_t Idx = 0;
+    for (auto const& Seg : Segments()) {
+      for (size_t Pos = 0; Pos < Seg.X.size(); ++Pos, ++Idx)
+        Fn(Idx, Seg.X[Pos], Seg.Y[Pos]);
+    }
+  }
+
+  /**
+   * Call Fn(Begin, End) for each run [Begin, End) of logical indices where the chunks
+   * intersect View, oldest first. The chunks outside View are skipped as a whole.
+   */
+  template <typename F> auto ForEachRunIn(es::bounds2 const& View, F&& Fn) const -> void {
+    if (0 == Count)
+      return;
+
+    auto const First = Pushed - Count;
+    uint64_t   RunBegin{};
+    bool       InRun{};
+    for (auto Chunk = First / ChunkSize; Chunk <= (Pushed - 1) / ChunkSize; ++Chunk) {
+      auto const Begin = std::max<uint64_t>(Chunk * ChunkSize, First);
+      if (es::Intersects(vChunkBounds[Chunk % vChunkBounds.size()], View)) {
+        RunBegin = InRun ? RunBegin : Begin;
+        InRun    = true;
+      } else if (InRun) {
+        Fn(size_t(RunBegin - First), size_t(Begin - First));
+        InRun = false;
+      }
+    }
+    if (InRun)
+      Fn(size_t(RunBegin - First), Count);
+  }
+
+  auto Slot(size_t Idx) const -> size_t {
+    auto const Pos = Begin() + Idx;
+    return Pos < vX.size() ? Pos : Pos - vX.size();
+  }
+  auto Begin() const -> size_t { return Full() ? Head : 0; }
+
+  std::vector<float>       vX{};
+  std::vector<float>       vY{};
+  std::vector<es::bounds2> vChunkBounds{}; //!< Bounds of chunk Num / ChunkSize at that modulo the size.
+  size_t                   Head{};         //!< Slot for the next point.
+  size_t                   Count{};        //!< Number of points, at most the capacity.
+  uint64_t                 Pushed{};       //!< Points pushed since the last Clear.
+  uint64_t                 Cleared{};      //!< Reset and Clear calls.
+};
+
+/**
+ * A trend point in pixels. Num is its push number in the trend.
+ */
+struct trail_point {
+  float    X{};
+  float    Y{};
+  uint64_t Num{};
+  bool     Gap{}; //!< Points before this one were culled, no line to it.
+};
+
+/**
+ * The points of a trend in pixels, kept up to date frame by frame. Only the points pushed
+ * to the trend since the last Update are transformed, unless the zoom or the trend changed
+ * in some other way, then all of them are. A pan only moves the points already there.
+ *
+ * Only the points near View are kept. A trail is built for View grown by CullMargin, and
+ * built again when View moves outside of that. New points are culled one by one, and the
+ * points when building again by the chunks of the trend. The point before and after a
+ * culled run is kept, so that lines leaving the view are drawn.
+ *
+ * With a Tolerance above zero the trail is also a level of detail for the trend. A new point
+ * closer than Tolerance pixels to the last point kept is dropped, and every ChunkSize points
+ * kept are simplified with Douglas-Peucker to within Tolerance pixels. The newest points,
+ * in Tail, are drawn as they are until their chunk is full. So the number of points drawn
+ * depends on the length of the trail on screen and not on the capacity of the trend.
+ */
+struct pixel_trail {
+  static constexpr size_t ChunkSize  = 64;
+  static constexpr float  CullMargin = 0.5f; //!< Fraction of the view added on each side.
+
+  /**
+   * Bring the points up to date with Trend, for the part of engineering space in View.
+   * Return the number of points transformed.
+   */
+  auto Update(ring_buffer const& Trend, es::affine2 const& E2P, es::bounds2 const& View = Everywhere) -> size_t;
+
+  /**
+   * Transform the points [Begin, End) of Trend into vNewX/Y.
+   */
+  auto TransformRange(ring_buffer const& Trend, size_t Begin, size_t End) -> void;
+
+  /**
+   * Add a point after the level of detail. A Gap point starts a new chunk.
+   */
+  auto Append(trail_point const& P) -> void;
+  auto FlushTail() -> void;
+
+  /**
+   * Number of points to draw.
+   */
+  auto Size() const -> size_t { return Points.size() + vTail.size(); }
+
+  /**
+   * Call Fn(Idx, X, Y) for the points to draw, oldest first, where Idx is the logical index
+   * of the point in the trend.
+   */
+  template <typename F> auto ForEach(F&& Fn) const -> void {
+    ForEachPoint([&](trail_point const& P) { Fn(size_t(P.Num - First), P.X, P.Y); });
+  }
+
+  template <typename F> auto ForEachPoint(F&& Fn) const -> void {
+    for (auto const& P : Points)
+      Fn(P);
+    for (auto const& P : vTail)
+      Fn(P);
+  }
+
+  /**
+   * Call Fn(From, To) for the lines between the points to draw, oldest first. There is no
+   * line to a Gap point, across the points that were culled.
+   */
+  template <typename F> auto ForEachLine(F&& Fn) const -> void {
+    trail_point const* pPrv = nullptr;
+    ForEachPoint([&](trail_point const& P) {
+      if (pPrv && !P.Gap)
+        Fn(*pPrv, P);
+      pPrv = &P;
+    });
+  }
+
+  /**
+   * Alpha from 1/N * 255 for the oldest point of the trend to 255 for the newest, by logical
+   * index, where N is the size of the trend. Only computed again when N changes.
+   */
+  auto AlphaRamp() -> std::span<uint8_t const>;
+
+  float Tolerance{}; //!< Pixels. Zero keeps every point.
+
+  std::deque<trail_point>  Points{}; //!< Simplified points.
+  std::vector<trail_point> vTail{};  //!< Points after the last simplified chunk, not simplified yet.
+  es::affine2              E2P{};
+  es::bounds2              Built{}; //!< Engineering space the points were culled to.
+  uint64_t                 NextNum{}; //!< Push number after the last point appended.
+  uint64_t                 First{};    //!< Push number of the oldest point in the trend.
+  size_t                   TrendSize{};
+  size_t                   Capacity{}; //!< Trend.Capacity() at the last Update.
+  uint64_t                 Pushed{};   //!< Trend.NumPushed() at the last Update.
+  uint64_t                 Cleared{};  //!< Trend.NumCleared() at the last Update.
+  std::vector<float>       vNewX{};    //!< Scratch for the transformed points.
+  std::vector<float>       vNewY{};
+  std::vector<uint8_t>     vAlpha{};
+  std::vector<bool>        vKeep{}; //!< Scratch for Simplify.
+};
+
+/**
+ * Keep the points of Line within Tolerance of the polyline through the points kept, with
+ * Douglas-Peucker. The first and last points are always kept. Clears and fills vKeep.
+ */
+auto Simplify(std::span<trail_point const> Line, float Tolerance, std::vector<bool>& vKeep) -> void;
+
+/**
+ * Keeps the producer and the consumer indices on separate cache lines.
+ */
+constexpr size_t CacheLineSize = 64;
+
+/**
+ * Wait free queue of 2D samples from one producer thread to one consumer thread, with x
+ * and y in separate arrays. The capacity is rounded up to a power of two. The indices
+ * count pushed and popped samples and only grow, the slot is the index masked.
+ */
+struct spsc_queue {
+  explicit spsc_queue(size_t Capacity);
+
+  /**
+   * Producer side. Push as many of the samples as there is room for, with one release
+   * store for all of them. Return the number pushed.
+   */
+  auto Push(std::span<float const> Xs, std::span<float const> Ys) -> size_t;
+  auto Push(float X, float Y) -> bool;
+
+  /**
+   * Consumer side. Move at most MaxSamples samples, oldest first, into Trend.
+   * Return the number moved.
+   */
+  auto PopInto(ring_buffer& Trend, size_t MaxSamples = SIZE_MAX) -> size_t;
+
+  auto Capacity() const -> size_t { return vX.size(); }
+
+  /**
+   * Samples waiting. Exact only when called from the producer or the consumer with the
+   * other side idle.
+   */
+  auto Size() const -> size_t;
+
+  std::vector<float> vX{};
+  std::vector<float> vY{};
+  size_t             Mask{};
+
+  alignas(CacheLineSize) std::atomic<size_t> WriteIdx{}; //!< Written by the producer.
+  size_t CachedReadIdx{};                                 //!< The producer's last view of ReadIdx.
+
+  alignas(CacheLineSize) std::atomic<size_t> ReadIdx{}; //!< Written by the consumer.
+  size_t CachedWriteIdx{};                               //!< The consumer's last view of WriteIdx.
+};
+
+/**
+ * One live signal, fed by one producer through Queue and drawn from Trend.
+ */
+struct channel {
+  channel(std::string Name, size_t QueueCapacity, size_t TrendCapacity);
+
+  std::string           Name{};
+  spsc_queue            Queue;
+  ring_buffer           Trend;
+  std::atomic<uint64_t> NumDropped{}; //!< Samples the producer could not push, the queue was full.
+};
+
+/**
+ * All the live channels. Channels are added before their producers start, and are not
+ * moved after that.
+ */
+struct channels {
+  std::vector<std::unique_ptr<channel>> vChannels{};
+};
+
+auto AddChannel(channels& Channels, std::string Name, size_t QueueCapacity, size_t TrendCapacity) -> channel&;
+
+/**
+ * Consumer side. Move the waiting samples of all channels into their trends, at most
+ * MaxPerChannel from each. Return the total number moved.
+ */
+auto DrainAll(channels& Channels, size_t MaxPerChannel = SIZE_MAX) -> size_t;
+
+}; // namespace trend
+}; // namespace fluffy
+#endif
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
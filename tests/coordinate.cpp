@@ -7,13 +7,33 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../src/canvasmemory.hpp"
 #include "../src/curvesrobotics.hpp"
 #include "../src/engsupport.hpp"
+#include "../src/fixedstep.hpp"
 #include "../src/fractal.hpp"
+#include "../src/juliasoftware.hpp"
+#include "../src/perfcounters.hpp"
+#include "../src/quatjulia.hpp"
+#include "../src/renderbackend.hpp"
+#include "../src/softraster.hpp"
+#include "../src/trendbuffer.hpp"
 
 #include "raylib.h"
 #include "raymath.h"
 
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
 unsigned int Factorial(unsigned int number) { return number <= 1 ? number : Factorial(number - 1) * number; }
 
 TEST_CASE("Factorials are computed", "[factorial]") {
@@ -39,12 +59,758 @@ TEST_CASE("Invert a Matrix", "[Linear algebra]") {
   REQUIRE(true == BIsInvertible);
 
   if (BIsInvertible) {
-    auto InvB   = MatrixInvert(B);
+    auto InvB   = es::Invert(B);
     auto TstInv = B * InvB;
     REQUIRE(TstInv == es::I());
   }
 }
 
+/**
+ * SIMD products against a plain scalar product, and determinant and inverse of matrices
+ * that the old partial expansion got wrong.
+ */
+TEST_CASE("MatrixSimd", "[Linear algebra]") {
+  auto ldaAt = [](Matrix const& M, int Row, int Col) -> float {
+    return reinterpret_cast<float const*>(&M)[4 * Row + Col];
+  };
+
+  auto ldaNear = [&](Matrix const& M1, Matrix const& M2, float Eps) -> bool {
+    for (int Idx = 0; Idx < 16; ++Idx) {
+      if (std::abs(ldaAt(M1, Idx / 4, Idx % 4) - ldaAt(M2, Idx / 4, Idx % 4)) > Eps)
+        return false;
+    }
+    return true;
+  };
+
+  Matrix const A{1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f, 8.f, 7.f, 6.f, 5.f, 4.f, 3.f, 2.f};
+  Matrix const B{-2.f, 1.f, 2.f, 3.f, 3.f, 2.f, 1.f, -1.f, 4.f, 3.f, 6.f, 5.f, 1.f, 2.f, 7.f, 8.f};
+
+  auto const AB = es::Mul(A, B);
+  for (int Row = 0; Row < 4; ++Row) {
+    for (int Col = 0; Col < 4; ++Col) {
+      float Sum{};
+      for (int K = 0; K < 4; ++K)
+        Sum += ldaAt(A, Row, K) * ldaAt(B, K, Col);
+      REQUIRE(Sum == ldaAt(AB, Row, Col));
+    }
+  }
+
+  auto const V  = Vector4{1.f, -2.f, 3.f, 1.f};
+  auto const BV = B * V;
+  REQUIRE(BV.x == -2.f * 1.f + 1.f * -2.f + 2.f * 3.f + 3.f * 1.f);
+  REQUIRE(BV.w == 1.f * 1.f + 2.f * -2.f + 7.f * 3.f + 8.f * 1.f);
+
+  // ---
+  // NOTE: A has dependent rows, B has determinant 6 (Leibniz formula), and a
+  //       permutation matrix with a bottom row that is not 0 0 0 1.
+  // ---
+  REQUIRE(0.f == es::Determinant(A));
+  REQUIRE(!es::IsMatrixInvertible(A));
+  REQUIRE(std::abs(es::Determinant(B) - 6.f) < 1e-4f);
+
+  Matrix const P{0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+  REQUIRE(-1.f == es::Determinant(P));
+  REQUIRE(es::Invert(P) * P == es::I());
+
+  auto const InvB = es::Invert(B);
+  REQUIRE(ldaNear(B * InvB, es::I(), 1e-5f));
+  REQUIRE(ldaNear(InvB, MatrixInvert(B), 1e-5f));
+
+  auto const Sum = A + B;
+  REQUIRE(Sum.m1 == A.m1 + B.m1);
+}
+
+/**
+ * The double matrices must match a plain loop in the order documented for Mul, and keep
+ * neighbouring pixels apart at a zoom of 1e9 pixels per unit around a point far from origo.
+ */
+TEST_CASE("MatrixDouble", "[Linear algebra]") {
+  auto ldaAt = [](es::matrix4_double const& M, int Row, int Col) -> double {
+    return reinterpret_cast<double const*>(&M)[4 * Row + Col];
+  };
+
+  Matrix const B{-2.f, 1.f, 2.f, 3.f, 3.f, 2.f, 1.f, -1.f, 4.f, 3.f, 6.f, 5.f, 1.f, 2.f, 7.f, 8.f};
+  auto const   BD = es::MatrixDouble(B);
+  REQUIRE(es::ToMatrix(BD) == B);
+  REQUIRE(std::abs(es::Determinant(BD) - 6.) < 1e-12);
+
+  auto const InvB = es::Invert(BD);
+  auto const BI   = BD * InvB;
+  for (int Idx = 0; Idx < 16; ++Idx)
+    REQUIRE(std::abs(ldaAt(BI, Idx / 4, Idx % 4) - ldaAt(es::IDouble(), Idx / 4, Idx % 4)) < 1e-12);
+
+  auto const BB = BD * InvB * BD;
+  for (int Row = 0; Row < 4; ++Row) {
+    auto const V = es::vector4_double{ldaAt(BD, 0, Row), ldaAt(BD, 1, Row), ldaAt(BD, 2, Row), ldaAt(BD, 3, Row)};
+    auto const R = BD * V;
+    REQUIRE(R.x == (ldaAt(BD, 0, 0) * V.x + ldaAt(BD, 0, 1) * V.y) + (ldaAt(BD, 0, 2) * V.z + ldaAt(BD, 0, 3) * V.w));
+    REQUIRE(R.w == (ldaAt(BD, 3, 0) * V.x + ldaAt(BD, 3, 1) * V.y) + (ldaAt(BD, 3, 2) * V.z + ldaAt(BD, 3, 3) * V.w));
+    for (int Col = 0; Col < 4; ++Col)
+      REQUIRE(std::abs(ldaAt(BB, Row, Col) - ldaAt(BD, Row, Col)) < 1e-12);
+  }
+  REQUIRE(!es::IsMatrixInvertible(es::matrix4_double{}));
+  auto const IsZero = es::Invert(es::matrix4_double{}) == es::matrix4_double{};
+  REQUIRE(IsZero);
+
+  // ---
+  // NOTE: Pixels to engineering to grid values and back, as the curves app does at full zoom.
+  // ---
+  constexpr double Zoom   = 1e9;
+  auto const       Scale  = es::SetScaling(es::VectorDouble(Zoom, -Zoom, 1.));
+  auto const       MhE2P  = es::SetTranslation(es::VectorDouble(640., 360., 0.)) * Scale;
+  auto const       MhG2E  = es::SetTranslation(es::VectorDouble(-0.743643887037151, 0.131825904205330, 0.));
+  auto const       P2G    = MhG2E * es::Invert(MhE2P);
+  auto const       G2P    = MhE2P * es::Invert(MhG2E);
+  auto             PrvVal = (P2G * es::PointDouble(99., 200., 0.)).x;
+  for (int X = 100; X < 110; ++X) {
+    auto const Grid = P2G * es::PointDouble(X, 200., 0.);
+    REQUIRE(std::abs(Grid.x - PrvVal - 1. / Zoom) < 1e-6 / Zoom);
+    PrvVal = Grid.x;
+
+    auto const Pixel = G2P * Grid;
+    REQUIRE(std::abs(Pixel.x - X) < 1e-3);
+    REQUIRE(std::abs(Pixel.y - 200.) < 1e-3);
+  }
+}
+
+/**
+ * The es core folds at compile time, and the expression templates give the same results
+ * as the eager operators.
+ */
+TEST_CASE("ConstexprEngSupport", "[Linear algebra]") {
+  constexpr auto P = es::Point(1.f, 2.f, 3.f);
+  static_assert(P.w == 1.f && es::Vector(1.f, 2.f, 3.f).w == 0.f);
+
+  constexpr auto Moved = es::SetTranslation(es::Vector(10.f, 20.f, 30.f)) * P;
+  static_assert(Moved == es::Point(11.f, 22.f, 33.f));
+
+  constexpr auto Scaled = es::SetScaling(es::Vector(2.f, -2.f, 1.f)) * es::SetTranslation(es::Vector(1.f, 1.f, 0.f));
+  static_assert(Scaled * P == es::Point(4.f, -6.f, 3.f));
+  static_assert(es::Invert(Scaled) * (Scaled * P) == P);
+  static_assert(es::Determinant(Scaled) == -4.f);
+  static_assert(!es::IsMatrixInvertible(Matrix{}));
+
+  static_assert(es::Lerp(es::Point(0.f, 0.f, 0.f), es::Point(4.f, 8.f, 0.f), 0.25f) == es::Point(1.f, 2.f, 0.f));
+  static_assert(es::Lerp(P, P, 2.f) == Vector4{});
+
+  constexpr auto E2P = es::affine2{{4.f, -4.f}, {640.f, 360.f}};
+  static_assert(es::Invert(E2P) * (E2P * P) == P);
+  static_assert(es::Affine2(es::ToMatrix(E2P)).Offset.y == 360.f);
+
+  constexpr auto MhE2P =
+      es::SetTranslation(es::VectorDouble(640., 360., 0.)) * es::SetScaling(es::VectorDouble(1e9, -1e9, 1.));
+  static_assert((es::Invert(MhE2P) * es::PointDouble(640., 360., 0.)) == es::PointDouble(0., 0., 0.));
+
+  constexpr auto Dim = es::Vector(2.f, 3.f, 0.f);
+  static_assert(es::xpr::Eval(es::xpr::Val(P) + Dim) == P + Dim);
+  static_assert(es::xpr::Eval((es::xpr::Val(P) - Dim) * 0.5f) == (P - Dim) * 0.5f);
+  static_assert(E2P * (es::xpr::Val(P) + Dim) == E2P * (P + Dim));
+
+  // ---
+  // NOTE: At run time the eager products take the SIMD path.
+  // ---
+  auto const A = es::Point(0.1f, -7.3f, 2.2f);
+  auto const B = es::Vector(3.7f, 0.9f, -1.1f);
+  for (float t = 0.f; t <= 1.f; t += 0.125f) {
+    auto const Fused = es::xpr::Eval(es::xpr::Val(A) + (es::xpr::Val(B) - A) * t);
+    auto const Eager = A + (B - A) * t;
+    auto const Same  = Fused == Eager && es::Lerp(A, B, t) == Eager;
+    REQUIRE(Same);
+  }
+  auto const SameMul = Scaled * (es::xpr::Val(A) + B) == Scaled * (A + B);
+  REQUIRE(SameMul);
+}
+
+/**
+ * Pixel, engineering and grid frames as in the curves app. Changing a frame must reach the
+ * frames below it, and the inverses are only recomputed when read.
+ */
+TEST_CASE("TransformGraph", "[Linear algebra]") {
+  auto const MhE2P =
+      es::SetTranslation(es::VectorDouble(640., 384., 0.)) * es::SetScaling(es::VectorDouble(100., -100., 1.));
+
+  es::transform_graph Frames{};
+  auto const Eng  = es::AddFrame(Frames, MhE2P);
+  auto const Grid = es::AddFrame(Frames, es::SetTranslation(es::VectorDouble(-2., -1., 0.)), Eng);
+  auto const Tip  = es::AddFrame(Frames, es::SetTranslation(es::VectorDouble(0.5, 0., 0.)), Grid);
+
+  auto const ldaPix = [&](es::frame_id Frame, double X, double Y) -> es::vector4_double {
+    return es::World(Frames, Frame) * es::PointDouble(X, Y, 0.);
+  };
+
+  bool Same = ldaPix(Grid, 2., 1.) == es::PointDouble(640., 384., 0.);
+  REQUIRE(Same);
+  Same = ldaPix(Tip, 1.5, 1.) == es::PointDouble(640., 384., 0.);
+  REQUIRE(Same);
+
+  auto const Mouse = es::PointDouble(740., 284., 0.);
+  Same             = es::WorldInv(Frames, Grid) * Mouse == es::PointDouble(3., 2., 0.);
+  REQUIRE(Same);
+  auto const TipInEng = es::Between(Frames, Tip, Eng) * es::PointDouble(0., 0., 0.);
+  REQUIRE(std::abs(TipInEng.x + 1.5) < 1e-12);
+  REQUIRE(std::abs(TipInEng.y + 1.) < 1e-12);
+
+  // ---
+  // NOTE: Move engineering space three times, the frames below follow, and each WorldInv
+  //       is recomputed once when read.
+  // ---
+  auto const NumInversions = Frames.NumInversions;
+  for (int Idx = 1; Idx <= 3; ++Idx)
+    es::SetLocal(Frames, Eng, es::SetTranslation(es::VectorDouble(10. * Idx, 0., 0.)) * MhE2P);
+  Same = ldaPix(Tip, 1.5, 1.) == es::PointDouble(670., 384., 0.);
+  REQUIRE(Same);
+  REQUIRE(Frames.NumInversions == NumInversions);
+
+  Same = es::WorldInv(Frames, Tip) * es::PointDouble(670., 384., 0.) == es::PointDouble(1.5, 1., 0.);
+  REQUIRE(Same);
+  REQUIRE(Frames.NumInversions == NumInversions + 3);
+  es::WorldInv(Frames, Tip);
+  es::WorldInv(Frames, Grid);
+  REQUIRE(Frames.NumInversions == NumInversions + 3);
+}
+
+/**
+ * Batched transforms must give the same x and y as one Mul per point, for the scale and
+ * offset path, the general 2D affine path, the SIMD tail and the threaded path.
+ */
+TEST_CASE("TransformPoints", "[Linear algebra]") {
+  auto const Scale = es::SetTranslation(es::Vector(640.f, 384.f, 0.f)) * es::SetScaling(es::Vector(100.f, -100.f, 1.f));
+  auto       Rotate = Scale;
+  Rotate.m4         = 12.5f;
+  Rotate.m1         = -3.25f;
+
+  for (auto const& M : {Scale, Rotate}) {
+    for (size_t N : {size_t(0), size_t(37), es::TransformPointsParallelThreshold + 5}) {
+      std::vector<float> vX(N);
+      std::vector<float> vY(N);
+      for (size_t Idx = 0; Idx < N; ++Idx) {
+        vX[Idx] = std::sin(0.001f * float(Idx)) * 3.f;
+        vY[Idx] = std::cos(0.0013f * float(Idx)) * 2.f;
+      }
+
+      std::vector<float> vOutX(N);
+      std::vector<float> vOutY(N);
+      es::TransformPoints(M, vX, vY, vOutX, vOutY);
+
+      size_t NumWrong{};
+      for (size_t Idx = 0; Idx < N; ++Idx) {
+        auto const P = M * es::Point(vX[Idx], vY[Idx], 0.f);
+        NumWrong += P.x != vOutX[Idx] || P.y != vOutY[Idx];
+      }
+      REQUIRE(0 == NumWrong);
+
+      // ---
+      // NOTE: In place.
+      // ---
+      es::TransformPoints(M, vX, vY, vX, vY);
+      REQUIRE(vX == vOutX);
+      REQUIRE(vY == vOutY);
+    }
+  }
+}
+
+/**
+ * The scale and offset transform must map points the same way as the matrix it came from.
+ */
+TEST_CASE("Affine2", "[Linear algebra]") {
+  auto const M = es::SetTranslation(es::Vector(640.f, 384.f, 0.f)) * es::SetScaling(es::Vector(100.f, -100.f, 1.f));
+  auto const A = es::Affine2(M);
+  REQUIRE(A.Scale.x == 100.f);
+  REQUIRE(A.Scale.y == -100.f);
+  REQUIRE(A.Offset.x == 640.f);
+  REQUIRE(A.Offset.y == 384.f);
+  REQUIRE(es::ToMatrix(A) == M);
+
+  auto const P = es::Point(1.25f, -0.5f, 0.f);
+  REQUIRE((A * P) == (M * P));
+  REQUIRE((A * es::Vector(1.25f, -0.5f, 0.f)) == (M * es::Vector(1.25f, -0.5f, 0.f)));
+  auto const P2 = A * Vector2{1.25f, -0.5f};
+  REQUIRE(P2.x == (M * P).x);
+  REQUIRE(P2.y == (M * P).y);
+
+  // ---
+  // NOTE: Composition in the same order as for Matrix, and a closed form inverse.
+  // ---
+  auto const G  = es::affine2{{1.f, 1.f}, {-2.f, 3.f}};
+  auto const AG = A * G;
+  REQUIRE((AG * P) == (M * es::ToMatrix(G) * P));
+
+  // ---
+  // NOTE: Powers of two so that the round trip is exact.
+  // ---
+  auto const B   = es::affine2{{128.f, -64.f}, {640.f, 384.f}};
+  auto const Inv = es::Invert(B);
+  REQUIRE(es::IsInvertible(B));
+  REQUIRE((Inv * (B * P)) == P);
+  REQUIRE(es::ToMatrix(Inv) == es::Invert(es::ToMatrix(B)));
+  REQUIRE(!es::IsInvertible(es::affine2{{0.f, 1.f}, {}}));
+
+  std::vector<float> vX{0.f, 1.f, -3.5f, 2.25f, 7.f};
+  std::vector<float> vY{0.f, -1.f, 0.5f, 4.f, -7.f};
+  std::vector<float> vOutX(vX.size());
+  std::vector<float> vOutY(vY.size());
+  es::TransformPoints(A, vX, vY, vOutX, vOutY);
+  for (size_t Idx = 0; Idx < vX.size(); ++Idx) {
+    auto const Q = M * es::Point(vX[Idx], vY[Idx], 0.f);
+    REQUIRE(vOutX[Idx] == Q.x);
+    REQUIRE(vOutY[Idx] == Q.y);
+  }
+}
+
+/**
+ * The ring keeps the newest points in logical order across the wrap around, and the
+ * segments cover the same points as the indexed access.
+ */
+TEST_CASE("TrendRingBuffer", "[trend]") {
+  fluffy::trend::ring_buffer Trend(5);
+  REQUIRE(Trend.Size() == 0);
+  REQUIRE(Trend.Segments()[0].X.empty());
+
+  for (int Idx = 0; Idx < 3; ++Idx)
+    Trend.Push(float(Idx), float(-Idx));
+  REQUIRE(Trend.Size() == 3);
+  REQUIRE(!Trend.Full());
+  REQUIRE(Trend.X(0) == 0.f);
+  REQUIRE(Trend.Y(2) == -2.f);
+  REQUIRE(Trend.Segments()[1].X.empty());
+
+  for (int Idx = 3; Idx < 12; ++Idx)
+    Trend.Push(float(Idx), float(-Idx));
+  REQUIRE(Trend.Full());
+  REQUIRE(Trend.Size() == 5);
+  REQUIRE(Trend.NumPushed() == 12);
+
+  std::vector<float> vX{};
+  Trend.ForEach([&](size_t Idx, float X, float Y) -> void {
+    REQUIRE(X == Trend.X(Idx));
+    REQUIRE(Y == -X);
+    vX.push_back(X);
+  });
+  REQUIRE(vX == std::vector<float>{7.f, 8.f, 9.f, 10.f, 11.f});
+
+  auto const Segs = Trend.Segments();
+  REQUIRE(Segs[0].X.size() + Segs[1].X.size() == 5);
+  REQUIRE(Segs[0].X.front() == 7.f);
+  REQUIRE(Segs[1].X.back() == 11.f);
+
+  Trend.Reset(2);
+  REQUIRE(Trend.Size() == 0);
+  REQUIRE(Trend.Capacity() == 2);
+  Trend.Push(1.f, 2.f);
+  Trend.Push(3.f, 4.f);
+  Trend.Push(5.f, 6.f);
+  REQUIRE(Trend.X(0) == 3.f);
+  REQUIRE(Trend.Y(1) == 6.f);
+
+  fluffy::trend::ring_buffer Empty{};
+  Empty.Push(1.f, 1.f);
+  REQUIRE(Empty.Size() == 0);
+}
+
+/**
+ * A pixel trail transforms only the points pushed since the last update, and must end up
+ * the same as transforming the whole trend, also after the ring wraps.
+ */
+TEST_CASE("TrendPixelTrail", "[trend]") {
+  fluffy::trend::ring_buffer Trend{10};
+  fluffy::trend::pixel_trail Trail{};
+  es::affine2 const          E2P{{100.f, -100.f}, {640.f, 384.f}};
+  auto                       ldaSame = [&](es::affine2 const& A) {
+    bool   Same = Trail.Size() == Trend.Size();
+    size_t Next{};
+    Trail.ForEach([&](size_t Idx, float X, float Y) {
+      Same = Same && Idx == Next++;
+      Same = Same && X == A.Scale.x * Trend.X(Idx) + A.Offset.x;
+      Same = Same && Y == A.Scale.y * Trend.Y(Idx) + A.Offset.y;
+    });
+    return Same;
+  };
+
+  for (int Idx = 0; Idx < 6; ++Idx)
+    Trend.Push(float(Idx), float(-Idx));
+  REQUIRE(Trail.Update(Trend, E2P) == 6);
+  REQUIRE(ldaSame(E2P));
+
+  for (int Idx = 6; Idx < 13; ++Idx)
+    Trend.Push(float(Idx), float(-Idx));
+  REQUIRE(Trail.Update(Trend, E2P) == 7);
+  REQUIRE(ldaSame(E2P));
+  REQUIRE(Trail.Update(Trend, E2P) == 0);
+
+  for (int Idx = 13; Idx < 40; ++Idx)
+    Trend.Push(float(Idx), float(-Idx));
+  REQUIRE(Trail.Update(Trend, E2P) == 10);
+  REQUIRE(ldaSame(E2P));
+
+  auto const Zoomed = es::affine2{{50.f, -50.f}, {640.f, 384.f}};
+  REQUIRE(Trail.Update(Trend, Zoomed) == 10);
+  REQUIRE(ldaSame(Zoomed));
+
+  Trend.Clear();
+  Trend.Push(1.f, 2.f);
+  REQUIRE(Trail.Update(Trend, Zoomed) == 1);
+  REQUIRE(ldaSame(Zoomed));
+
+  auto const Alpha = Trail.AlphaRamp();
+  REQUIRE(Alpha.size() == 1);
+  REQUIRE(Alpha[0] == 255);
+}
+
+/**
+ * With a tolerance the trail keeps few points of a straight trace however long it is, keeps
+ * the corners of a zigzag, and a pan moves the points without transforming them again.
+ */
+TEST_CASE("TrendTrailLevelOfDetail", "[trend]") {
+  fluffy::trend::ring_buffer Trend{20000};
+  fluffy::trend::pixel_trail Trail{.Tolerance = 0.5f};
+  es::affine2 const          E2P{{100.f, -100.f}, {640.f, 384.f}};
+
+  // ---
+  // NOTE: 10000 points on a line 100 pixels long, so 100 points in each pixel.
+  // ---
+  for (int Idx = 0; Idx < 10000; ++Idx)
+    Trend.Push(float(Idx) / 10000.f, 0.25f);
+  for (int Idx = 0; Idx < 10; ++Idx)
+    Trail.Update(Trend, E2P);
+  REQUIRE(Trail.Size() < 50);
+
+  // ---
+  // NOTE: Every point kept must be in the trend, in order.
+  // ---
+  bool   InTrend = true;
+  size_t IdxPrv{};
+  Trail.ForEach([&](size_t Idx, float X, float Y) {
+    InTrend = InTrend && (Idx > IdxPrv || 0 == Idx) && Idx < Trend.Size();
+    InTrend = InTrend && std::abs(X - (E2P.Scale.x * Trend.X(Idx) + E2P.Offset.x)) < 1e-3f;
+    InTrend = InTrend && std::abs(Y - (E2P.Scale.y * Trend.Y(Idx) + E2P.Offset.y)) < 1e-3f;
+    IdxPrv  = Idx;
+  });
+  REQUIRE(InTrend);
+
+  // ---
+  // NOTE: A zigzag 10 pixels high with a corner every 20 pixels keeps all its corners.
+  // ---
+  Trend.Clear();
+  for (int Idx = 0; Idx < 2000; ++Idx)
+    Trend.Push(float(Idx) / 100.f, float(std::abs(Idx % 200 - 100)) / 1000.f);
+  Trail.Update(Trend, E2P);
+  size_t NumCorners{};
+  Trail.ForEach([&](size_t Idx, float, float) { NumCorners += (0 == Idx % 100) ? 1 : 0; });
+  REQUIRE(NumCorners >= 19);
+  REQUIRE(Trail.Size() < 200);
+
+  auto const Panned = es::affine2{E2P.Scale, {E2P.Offset.x + 7.f, E2P.Offset.y - 3.f}};
+  auto const NumPrv = Trail.Size();
+  REQUIRE(Trail.Update(Trend, Panned) == 0);
+  REQUIRE(Trail.Size() == NumPrv);
+
+  // ---
+  // NOTE: Points that leave the trend leave the trail.
+  // ---
+  for (int Idx = 0; Idx < 30000; ++Idx)
+    Trend.Push(20.f + float(Idx) / 100.f, 0.f);
+  Trail.Update(Trend, Panned);
+  bool Fresh = true;
+  Trail.ForEach([&](size_t Idx, float, float) { Fresh = Fresh && Idx < Trend.Size(); });
+  REQUIRE(Fresh);
+  REQUIRE(Trail.First == Trend.NumPushed() - Trend.Size());
+}
+
+/**
+ * Culling skips the chunks of a trend that are outside the view, keeps one point on each
+ * side of a culled run and breaks the line there.
+ */
+TEST_CASE("TrendCulling", "[trend]") {
+  static_assert(es::Intersects(es::Bounds(0.f, 0.f, 2.f, 2.f), es::Bounds(1.f, 3.f, 3.f, 1.f)));
+  static_assert(!es::Intersects(es::bounds2{}, fluffy::trend::Everywhere));
+  static_assert(es::Contains(es::Grow(es::Bounds(0.f, 0.f, 2.f, 2.f), 0.5f), es::Bounds(-1.f, -1.f, 3.f, 3.f)));
+
+  auto const View = es::Transform(es::Invert(es::affine2{{2.f, -2.f}, {1.f, 1.f}}), es::Bounds(0.f, 0.f, 4.f, 4.f));
+  REQUIRE(View.MinX == -0.5f);
+  REQUIRE(View.MaxY == 0.5f);
+
+  // ---
+  // NOTE: Four chunks near the origo, four far out on x and then four near the origo again.
+  // ---
+  constexpr size_t           K = fluffy::trend::ring_buffer::ChunkSize;
+  fluffy::trend::ring_buffer Trend{12 * K};
+  for (size_t Idx = 0; Idx < 12 * K; ++Idx) {
+    auto const Far = Idx >= 4 * K && Idx < 8 * K;
+    Trend.Push((Far ? 1000.f : 0.f) + float(Idx % K) / float(K), 0.f);
+  }
+
+  auto const                             Near = es::Bounds(-1.f, -1.f, 2.f, 1.f);
+  std::vector<std::pair<size_t, size_t>> vRuns{};
+  Trend.ForEachRunIn(Near, [&](size_t Begin, size_t End) { vRuns.push_back({Begin, End}); });
+  REQUIRE(vRuns.size() == 2);
+  REQUIRE(vRuns[0] == std::pair<size_t, size_t>{0, 4 * K});
+  REQUIRE(vRuns[1] == std::pair<size_t, size_t>{8 * K, 12 * K});
+
+  es::affine2 const          E2P{{100.f, -100.f}, {640.f, 384.f}};
+  fluffy::trend::pixel_trail Trail{};
+  REQUIRE(Trail.Update(Trend, E2P, Near) == 8 * K + 2);
+
+  size_t NumGaps{};
+  bool   NearOnly = true;
+  Trail.ForEachPoint([&](fluffy::trend::trail_point const& P) {
+    NumGaps += P.Gap ? 1 : 0;
+    auto const Idx = P.Num - Trail.First;
+    NearOnly       = NearOnly && (Idx < 4 * K + 1 || Idx >= 8 * K - 1);
+  });
+  REQUIRE(NumGaps == 1);
+  REQUIRE(NearOnly);
+
+  // ---
+  // NOTE: No line goes across the culled run, from the first near run to the second.
+  // ---
+  size_t NumLines{};
+  bool   Across = false;
+  Trail.ForEachLine([&](fluffy::trend::trail_point const& From, fluffy::trend::trail_point const& To) {
+    ++NumLines;
+    Across = Across || (From.Num - Trail.First < 4 * K + 1 && To.Num - Trail.First >= 8 * K - 1);
+  });
+  REQUIRE(NumLines == Trail.Size() - 2);
+  REQUIRE(!Across);
+
+  // ---
+  // NOTE: New points far out are culled one by one, except the first one after the view.
+  // ---
+  for (size_t Idx = 0; Idx < 10; ++Idx)
+    Trend.Push(1000.f, 0.f);
+  REQUIRE(Trail.Update(Trend, E2P, Near) == 10);
+  REQUIRE(Trail.Size() == 8 * K + 2 - 10 + 1);
+}
+
+/**
+ * A producer thread pushes a counting signal through a small queue, so that the indices
+ * wrap many times, while the test drains it. Nothing may be lost or come out of order.
+ */
+TEST_CASE("TrendSpscChannels", "[trend]") {
+  fluffy::trend::spsc_queue Queue{100};
+  REQUIRE(Queue.Capacity() == 128);
+
+  for (float Val = 0.f; Val < 128.f; Val += 1.f)
+    REQUIRE(Queue.Push(Val, -Val));
+  REQUIRE(!Queue.Push(0.f, 0.f));
+
+  fluffy::trend::ring_buffer Out{1000};
+  REQUIRE(Queue.PopInto(Out, 28) == 28);
+  REQUIRE(Queue.Size() == 100);
+  std::vector<float> vX(40, 1.f);
+  REQUIRE(Queue.Push(vX, vX) == 28);
+  REQUIRE(Queue.PopInto(Out) == 128);
+  REQUIRE(Out.X(127) == 127.f);
+  REQUIRE(Out.Y(1) == -1.f);
+  REQUIRE(Out.X(128) == 1.f);
+
+  fluffy::trend::channels Channels{};
+  auto& Channel = fluffy::trend::AddChannel(Channels, "count", 64, 200000);
+
+  constexpr size_t NumSamples = 100000;
+  std::thread      Producer([&Channel] {
+    for (size_t Idx = 0; Idx < NumSamples;) {
+      std::array<float, 7> aX{};
+      auto const           N = std::min(aX.size(), NumSamples - Idx);
+      for (size_t Pos = 0; Pos < N; ++Pos)
+        aX[Pos] = float(Idx + Pos);
+      Idx += Channel.Queue.Push(std::span(aX).first(N), std::span(aX).first(N));
+    }
+  });
+
+  size_t NumDrained{};
+  while (NumDrained < NumSamples)
+    NumDrained += fluffy::trend::DrainAll(Channels, 50);
+  Producer.join();
+
+  REQUIRE(Channel.Trend.Size() == NumSamples);
+  bool InOrder = true;
+  Channel.Trend.ForEach([&](size_t Idx, float X, float Y) { InOrder = InOrder && X == float(Idx) && Y == X; });
+  REQUIRE(InOrder);
+}
+
+/**
+ * The null backend counts what a frame draws, the recording backend writes it as a stream
+ * that replays to the same counts.
+ */
+TEST_CASE("RenderBackend", "[render]") {
+  using fluffy::render::op;
+
+  auto ldaFrame = [](fluffy::render::backend& B) {
+    fluffy::render::BeginFrame(B);
+    fluffy::render::Clear(B, WHITE);
+    fluffy::render::Line(B, 0.f, 0.f, 10.f, 10.f, BLUE);
+    fluffy::render::BeginLines(B);
+    for (int Idx = 0; Idx < 3; ++Idx)
+      fluffy::render::AddLine(B, float(Idx), 0.f, float(Idx), 5.f, RED);
+    fluffy::render::EndLines(B);
+    fluffy::render::BeginSquares(B);
+    for (int Idx = 0; Idx < 5; ++Idx)
+      fluffy::render::AddSquare(B, float(Idx), 1.f, 0.5f, GREEN);
+    fluffy::render::EndSquares(B);
+    fluffy::render::CircleLines(B, 3.f, 4.f, 5.f, BLUE);
+    fluffy::render::CircleGradient(B, 3.f, 4.f, 1.f, BLUE, ORANGE);
+    fluffy::render::Text(B, "Fluffy", 10, 20, 20, BLUE);
+    auto const aGlyph = std::array{fluffy::render::GlyphIndex(B, '1'), fluffy::render::GlyphIndex(B, '.')};
+    fluffy::render::Glyphs(B, 1.f, 2.f, aGlyph, 10.f, DARKGRAY);
+    fluffy::render::EndFrame(B);
+  };
+
+  auto Null = fluffy::render::Backend(fluffy::render::backend_kind::Null, 640, 480);
+  ldaFrame(Null);
+  ldaFrame(Null);
+  REQUIRE(Null.vStream.empty());
+  REQUIRE(Null.NumFrames == 2);
+  REQUIRE(Null.aCalls[size_t(op::Lines)] == 2);
+  REQUIRE(Null.aItems[size_t(op::Lines)] == 6);
+  REQUIRE(Null.aItems[size_t(op::Squares)] == 10);
+  REQUIRE(Null.aItems[size_t(op::Text)] == 12);
+  REQUIRE(Null.aItems[size_t(op::Glyphs)] == 4);
+  REQUIRE(fluffy::render::GlyphIndex(Null, ' ') == 0);
+
+  auto Rec = fluffy::render::Backend(fluffy::render::backend_kind::Recording, 640, 480);
+  ldaFrame(Rec);
+  ldaFrame(Rec);
+  REQUIRE(0 == std::memcmp(Rec.vStream.data(), fluffy::render::StreamMagic.data(), 4));
+  REQUIRE(Rec.aCalls == Null.aCalls);
+  REQUIRE(Rec.aItems == Null.aItems);
+
+  // ---
+  // NOTE: One frame is 1 + 5 + 21 + (5 + 3 * 20) + (5 + 5 * 16) + 17 + 21 + (19 + 6) + (18 + 4) + 1 bytes.
+  // ---
+  REQUIRE(Rec.vStream.size() == 5 + 2 * 263);
+
+  auto Replayed = fluffy::render::Backend(fluffy::render::backend_kind::Null, 640, 480);
+  REQUIRE(fluffy::render::Replay(Rec.vStream, Replayed));
+  REQUIRE(Replayed.aCalls == Null.aCalls);
+  REQUIRE(Replayed.aItems == Null.aItems);
+
+  // ---
+  // NOTE: A cut stream sends what is whole and says so.
+  // ---
+  auto Cut = fluffy::render::Backend(fluffy::render::backend_kind::Null, 640, 480);
+  REQUIRE_FALSE(fluffy::render::Replay(std::span(Rec.vStream).first(5 + 263 + 20), Cut));
+  REQUIRE(Cut.NumFrames == 1);
+  REQUIRE_FALSE(fluffy::render::Replay(std::span(Rec.vStream).subspan(1), Cut));
+
+  // ---
+  // NOTE: A glyph index that is not in the font is refused, not used to index it.
+  // ---
+  auto vBadGlyph = std::vector<uint8_t>(Rec.vStream.begin(), Rec.vStream.begin() + 5 + 263);
+  vBadGlyph[5 + 263 - 1 - 2] = 0xFF;
+  REQUIRE_FALSE(fluffy::render::Replay(vBadGlyph, Cut));
+
+  std::ostringstream Out;
+  fluffy::render::Report(Null, Out);
+  REQUIRE(Out.str().find("Squares") != std::string::npos);
+}
+
+/**
+ * Anti-aliased lines, rects, rings and text, the same pixels with one or more threads.
+ */
+TEST_CASE("SoftRaster", "[render]") {
+  auto ldaDraw = [](int NThreads) {
+    auto C = fluffy::softraster::Canvas(150, 100, NThreads);
+    fluffy::softraster::Begin(C);
+    fluffy::softraster::Clear(C, BLACK);
+    fluffy::softraster::Line(C, 10.f, 20.5f, 140.f, 20.5f, WHITE);
+    fluffy::softraster::Line(C, 5.5f, -1e12f, 5.5f, 1e12f, BLUE); //!< Far endpoints, as at deep zoom.
+    fluffy::softraster::Rect(C, 10.f, 40.f, 20.5f, 50.f, WHITE);
+    fluffy::softraster::Ring(C, 100.f, 60.f, -20.f, RED); //!< y flipped, as from the curves pages.
+    fluffy::softraster::Text(C, "A", 30.f, 60.f, 10.f, GREEN);
+    fluffy::softraster::Rasterize(C);
+    return C;
+  };
+
+  auto const C = ldaDraw(1);
+
+  // ---
+  // NOTE: A line through pixel centres covers its row and nothing two pixels away.
+  // ---
+  REQUIRE(fluffy::softraster::GetPixel(C, 70, 20).r == 255);
+  REQUIRE(fluffy::softraster::GetPixel(C, 70, 22).r == 0);
+  REQUIRE(fluffy::softraster::GetPixel(C, 70, 18).r == 0);
+  REQUIRE(fluffy::softraster::GetPixel(C, 5, 50).b > 200);
+
+  // ---
+  // NOTE: The right edge of the rect covers half of its pixel.
+  // ---
+  REQUIRE(fluffy::softraster::GetPixel(C, 15, 45).r == 255);
+  auto const Edge = fluffy::softraster::GetPixel(C, 20, 45).r;
+  REQUIRE(Edge > 100);
+  REQUIRE(Edge < 155);
+  REQUIRE(fluffy::softraster::GetPixel(C, 21, 45).r == 0);
+
+  REQUIRE(fluffy::softraster::GetPixel(C, 120, 60).r > 100);
+  REQUIRE(fluffy::softraster::GetPixel(C, 100, 60).r == 0);
+
+  auto NumText = 0;
+  for (int Y = 60; Y < 70; ++Y)
+    for (int X = 30; X < 36; ++X)
+      NumText += fluffy::softraster::GetPixel(C, X, Y).g > 0 ? 1 : 0;
+  REQUIRE(NumText > 5);
+
+  std::vector<Color> vPixels(150 * 100);
+  fluffy::softraster::CopyPixels(C, vPixels.data());
+  for (int Y = 0; Y < 100; Y += 7) {
+    for (int X = 0; X < 150; X += 3) {
+      auto const Pixel = fluffy::softraster::GetPixel(C, X, Y);
+      REQUIRE(0 == std::memcmp(&vPixels[size_t(Y * 150 + X)], &Pixel, sizeof(Color)));
+    }
+  }
+
+  // ---
+  // NOTE: The threads bin and draw different parts, the pixels come out the same.
+  // ---
+  auto const C4 = ldaDraw(4);
+  REQUIRE(C4.vPixels.size() == C.vPixels.size());
+  REQUIRE(0 == std::memcmp(C4.vPixels.data(), C.vPixels.data(), C.vPixels.size() * sizeof(Color)));
+}
+
+/**
+ * The clock steps whole fixed steps and keeps the rest for the next frame.
+ */
+TEST_CASE("FixedStepClock", "[sim]") {
+  auto C = fluffy::sim::Clock(0.01);
+
+  // ---
+  // NOTE: Frames shorter than a step take none, the time left over shows in Alpha.
+  // ---
+  REQUIRE(fluffy::sim::Advance(C, 0.004) == 0);
+  REQUIRE(std::abs(fluffy::sim::Alpha(C) - 0.4) < 1e-9);
+  REQUIRE(fluffy::sim::Advance(C, 0.008) == 1);
+  fluffy::sim::Tick(C);
+  REQUIRE(std::abs(C.Time - 0.01) < 1e-9);
+  REQUIRE(std::abs(fluffy::sim::Alpha(C) - 0.2) < 1e-9);
+  REQUIRE(std::abs(fluffy::sim::DisplayTime(C) - 0.002) < 1e-9);
+
+  // ---
+  // NOTE: The steps do not depend on the frame rate.
+  // ---
+  for (double FrameRate : {30., 60., 144.}) {
+    auto F = fluffy::sim::Clock(1. / 120.);
+    for (int Frame = 0; Frame < int(FrameRate); ++Frame)
+      for (auto NumSteps = fluffy::sim::Advance(F, 1. / FrameRate); NumSteps > 0; --NumSteps)
+        fluffy::sim::Tick(F);
+    REQUIRE(F.NumSteps >= 119);
+    REQUIRE(F.NumSteps <= 120);
+    REQUIRE(std::abs(F.Time - double(F.NumSteps) / 120.) < 1e-12);
+    REQUIRE(F.Time <= 1. + 1e-9);
+    REQUIRE(fluffy::sim::DisplayTime(F) <= F.Time);
+  }
+
+  auto Fast = fluffy::sim::Clock(0.01, 4.);
+  REQUIRE(fluffy::sim::Advance(Fast, 0.01) == 4);
+
+  // ---
+  // NOTE: A stall is cut to MaxFrame, and a paused clock drops the time.
+  // ---
+  auto Stall = fluffy::sim::Clock(0.01);
+  REQUIRE(fluffy::sim::Advance(Stall, 5.) == 25);
+  Stall.Paused = true;
+  REQUIRE(fluffy::sim::Advance(Stall, 0.1) == 0);
+  REQUIRE(Stall.Accumulator == 0.);
+}
+
 /**
  */
 TEST_CASE("Lerp between two points", "[engsupport]") {
@@ -84,7 +850,7 @@ TEST_CASE("Test3dScreenCalculations2", "[engsupport]") {
   //       from Engineering -> Screen -> Pixel.
   // ---
 
-  auto const MhE2S = MatrixInvert(es::SetTranslation(Eo));
+  auto const MhE2S = es::Invert(es::SetTranslation(Eo));
 
   // ---
   // NOTE: Test that the homogenous matrix get set up correctly.
@@ -177,7 +943,7 @@ TEST_CASE("Test3dCalculations", "[engsupport]") {
 
   // Move from engineering space to screen space
   // i.e. The center of the screen will be at x=3,y=4
-  MhE2S = MatrixInvert(es::SetTranslation(es::Point(3.f, 4.f, 0.f)));
+  MhE2S = es::Invert(es::SetTranslation(es::Point(3.f, 4.f, 0.f)));
   {
     Vector4 const V = MhE2S * Vector4{0.f, 0.f, 0.f, 1.f};
     REQUIRE(V == es::Point(-3.f, -4.f, 0.f));
@@ -296,25 +1062,25 @@ TEST_CASE("TestZoomAndScale", "[engsupport]") {
   // Task: Compute the Pixel x,y value at gridorigo and at the grid corners.
   // ---
 
-  GridCfg.GridCenterValue = es::Point(1.f, 1.f, 0.f);
-  std::cout << "Change GridCenterValue to " << GridCfg.GridCenterValue << std::endl;
+  auto GridCenterValue = es::Point(1.f, 1.f, 0.f);
+  std::cout << "Change GridCenterValue to " << GridCenterValue << std::endl;
 
   // The zoom - aka scaling has changed from the initial 100 to 200.
   // This means that the Grid dimension has changed as well.
   GridCfg.GridDimensions = GridCfg.GridDimensions * (BaseScale / Zoom);
 
   // so to go from GridCenterValue to GridScreenCenter we need a coordinate system transform.
-  auto MhG2S = MatrixInvert(es::SetTranslation(GridCfg.GridCenterValue));
+  auto MhG2S = es::Invert(es::SetTranslation(GridCenterValue));
 
   std::cout << "MhG2S :\n\n " << MhG2S << std::endl;
 
   {
-    auto const EngValGridCentre = MhG2S * GridCfg.GridCenterValue;
+    auto const EngValGridCentre = MhG2S * GridCenterValue;
     std::cout << "EngValGridCentre:" << EngValGridCentre << std::endl;
 
-    auto const PixelPosGridCentre = MhE2P * MhG2S * GridCfg.GridCenterValue;
-    auto const PixelPosGridLL     = MhE2P * MhG2S * (GridCfg.GridCenterValue - GridCfg.GridDimensions * 0.5f);
-    auto const PixelPosGridUR     = MhE2P * MhG2S * (GridCfg.GridCenterValue + GridCfg.GridDimensions * 0.5f);
+    auto const PixelPosGridCentre = MhE2P * MhG2S * GridCenterValue;
+    auto const PixelPosGridLL     = MhE2P * MhG2S * (GridCenterValue - GridCfg.GridDimensions * 0.5f);
+    auto const PixelPosGridUR     = MhE2P * MhG2S * (GridCenterValue + GridCfg.GridDimensions * 0.5f);
     std::cout << "Zoom:" << Zoom << " -> PixelPosGridCentre:\n" << PixelPosGridCentre << std::endl;
     std::cout << "Zoom:" << Zoom << " -> PixelPosGridLowerLeft:\n" << PixelPosGridLL << std::endl;
     std::cout << "Zoom:" << Zoom << " -> PixelPosGridUpperRight:\n" << PixelPosGridUR << std::endl;
@@ -322,16 +1088,16 @@ TEST_CASE("TestZoomAndScale", "[engsupport]") {
 
   // and now we simulate that the grid centre value changes from x,y,z=1,1,0 to 2,2,0
   // but the grid dimension remains the same.
-  GridCfg.GridCenterValue = es::Point(2.f, 2.f, 0.f);
-  MhG2S                   = MatrixInvert(es::SetTranslation(GridCfg.GridCenterValue));
-  std::cout << "\n----\nChange GridCenterValue to " << GridCfg.GridCenterValue << std::endl;
+  GridCenterValue = es::Point(2.f, 2.f, 0.f);
+  MhG2S           = es::Invert(es::SetTranslation(GridCenterValue));
+  std::cout << "\n----\nChange GridCenterValue to " << GridCenterValue << std::endl;
   {
-    auto const EngValGridCentre = MhG2S * GridCfg.GridCenterValue;
+    auto const EngValGridCentre = MhG2S * GridCenterValue;
     std::cout << "EngValGridCentre:" << EngValGridCentre << std::endl;
 
-    auto const PixelPosGridCentre = MhE2P * MhG2S * GridCfg.GridCenterValue;
-    auto const PixelPosGridLL     = MhE2P * MhG2S * (GridCfg.GridCenterValue - GridCfg.GridDimensions * 0.5f);
-    auto const PixelPosGridUR     = MhE2P * MhG2S * (GridCfg.GridCenterValue + GridCfg.GridDimensions * 0.5f);
+    auto const PixelPosGridCentre = MhE2P * MhG2S * GridCenterValue;
+    auto const PixelPosGridLL     = MhE2P * MhG2S * (GridCenterValue - GridCfg.GridDimensions * 0.5f);
+    auto const PixelPosGridUR     = MhE2P * MhG2S * (GridCenterValue + GridCfg.GridDimensions * 0.5f);
     std::cout << "Zoom:" << Zoom << " -> PixelPosGridCentre:\n" << PixelPosGridCentre << std::endl;
     std::cout << "Zoom:" << Zoom << " -> PixelPosGridLowerLeft:\n" << PixelPosGridLL << std::endl;
     std::cout << "Zoom:" << Zoom << " -> PixelPosGridUpperRight:\n" << PixelPosGridUR << std::endl;
@@ -345,17 +1111,17 @@ TEST_CASE("TestZoomAndScale", "[engsupport]") {
     std::cout << "IsMhInvertible: " << IsMhInvertible << std::endl;
 
     int  NumPixels{};
-    auto PosUpperLeft  = es::Vector(GridCfg.GridCenterValue.x - GridCfg.GridDimensions.x * 0.5f,
-                                   GridCfg.GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
+    auto PosUpperLeft  = es::Vector(GridCenterValue.x - GridCfg.GridDimensions.x * 0.5f,
+                                   GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
                                    0.f);
-    auto PosUpperRight = es::Vector(GridCfg.GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f,
-                                    GridCfg.GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
+    auto PosUpperRight = es::Vector(GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f,
+                                    GridCenterValue.y + GridCfg.GridDimensions.y * 0.5,
                                     0.f);
-    // auto PosLowerLeft  = es::Vector(GridCfg.GridCenterValue.x - GridCfg.GridDimensions.x * 0.5f,
-    //                                GridCfg.GridCenterValue.y - GridCfg.GridDimensions.y * 0.5,
+    // auto PosLowerLeft  = es::Vector(GridCenterValue.x - GridCfg.GridDimensions.x * 0.5f,
+    //                                GridCenterValue.y - GridCfg.GridDimensions.y * 0.5,
     //                                0.f);
-    auto PosLowerRight = es::Vector(GridCfg.GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f,
-                                    GridCfg.GridCenterValue.y - GridCfg.GridDimensions.y * 0.5,
+    auto PosLowerRight = es::Vector(GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f,
+                                    GridCenterValue.y - GridCfg.GridDimensions.y * 0.5,
                                     0.f);
     auto PosXY         = PosUpperLeft;
 
@@ -369,7 +1135,7 @@ TEST_CASE("TestZoomAndScale", "[engsupport]") {
 
         // Increment position.
         PosXY.x        = std::min(PosXY.x + 1.f / Zoom, PosUpperRight.x);
-        auto GoodToGoX = PosXY.x <= GridCfg.GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f;
+        auto GoodToGoX = PosXY.x <= GridCenterValue.x + GridCfg.GridDimensions.x * 0.5f;
         if (!GoodToGoX)
           std::cout << "NumPixels:" << NumPixels << ". Trip at PosXY:" << PosXY << std::endl;
 
@@ -378,7 +1144,7 @@ TEST_CASE("TestZoomAndScale", "[engsupport]") {
       PosXY.x = PosUpperLeft.x;
       PosXY.y = std::max(PosXY.y - 1.f / Zoom, PosLowerRight.y);
 
-      auto GoodToGoY = PosXY.y >= GridCfg.GridCenterValue.y - GridCfg.GridDimensions.x * 0.5f;
+      auto GoodToGoY = PosXY.y >= GridCenterValue.y - GridCfg.GridDimensions.x * 0.5f;
       if (!GoodToGoY)
         std::cout << "NumPixels:" << NumPixels << ". Trip at PosXY:" << PosXY << std::endl;
 
@@ -534,6 +1300,411 @@ TEST_CASE("Pixel_Canvas", "[fractal]") {
   REQUIRE(PC.Dimension.x == (PC.PosUR.x - PC.PosUL.x));
   REQUIRE(PC.Dimension.y == -(PC.PosUR.y - PC.PosLR.y));
   REQUIRE(PC.Dimension.y == -(PC.PosUL.y - PC.PosLL.y));
+  REQUIRE(PC.Stride >= PC.Dimension.x);
+  REQUIRE((PC.Stride * sizeof(Color)) % fluffy::memory::CacheLineSize == 0);
+}
+
+TEST_CASE("CanvasMemory", "[fractal]") {
+  REQUIRE(fluffy::memory::RowStride(1) == 16);
+  REQUIRE(fluffy::memory::RowStride(16) == 16);
+  REQUIRE(fluffy::memory::RowStride(17) == 32);
+  REQUIRE(fluffy::memory::RowStride(7680) == 7680);
+
+  // ---
+  // NOTE: Small buffers are cache line aligned, large ones huge page aligned on Linux.
+  // ---
+  auto spSmall = fluffy::memory::AllocateColors(1000);
+  REQUIRE(spSmall);
+  REQUIRE(reinterpret_cast<uintptr_t>(spSmall.get()) % fluffy::memory::CacheLineSize == 0);
+
+  auto const NumPixels8K = size_t(7680) * 4320;
+  auto       spLarge     = fluffy::memory::AllocateColors(NumPixels8K);
+  REQUIRE(spLarge);
+  REQUIRE(reinterpret_cast<uintptr_t>(spLarge.get()) % fluffy::memory::CacheLineSize == 0);
+#ifdef __linux__
+  REQUIRE(reinterpret_cast<uintptr_t>(spLarge.get()) % fluffy::memory::HugePageSize == 0);
+#endif
+  spLarge.get()[NumPixels8K - 1] = RED;
+  REQUIRE(spLarge.get()[NumPixels8K - 1].r == RED.r);
+
+  REQUIRE(fluffy::memory::NumNumaNodes() >= 1);
+  REQUIRE(fluffy::memory::NumaNodeForBlock(0, 8) == 0);
+  REQUIRE(fluffy::memory::NumaNodeForBlock(7, 8) == fluffy::memory::NumNumaNodes() - 1);
+}
+
+/**
+ * Orbit density rendering. Same seed gives the same image.
+ */
+TEST_CASE("Buddhabrot", "[fractal]") {
+  currob::grid_cfg GridCfg{};
+  GridCfg.GridCenterValue = es::PointDouble(-0.5, 0., 0.);
+  GridCfg.GridDimensions  = es::Vector(3.f, 3.f, 0.f);
+
+  fluffy::fractal::density_cfg Cfg{};
+  Cfg.MaxIterations[0] = 200;
+  Cfg.MaxIterations[1] = 50;
+  Cfg.MaxIterations[2] = 20;
+  Cfg.NumSamples       = 20000;
+
+  auto ldaRender = [&](fluffy::fractal::render_mode Mode, bool ImportanceSampling) -> std::vector<Color> {
+    auto  PC    = fluffy::fractal::ConfigurePixelCanvas(50, 50, 100, 100, 33, 33);
+    Image Img{};
+    PC.NThreads            = 4;
+    Cfg.ImportanceSampling = ImportanceSampling;
+    fluffy::fractal::CreateDensityPixelSpace(GridCfg, PC, es::VectorDouble(33., 33., 0.), Mode, Cfg, Img);
+    REQUIRE(Img.data);
+    REQUIRE(Img.width == PC.Stride);
+    REQUIRE(Img.height == 100);
+    auto const* pColor = static_cast<Color const*>(Img.data);
+    return std::vector<Color>(pColor, pColor + Img.width * Img.height);
+  };
+
+  auto ldaNumLit = [](std::vector<Color> const& vColor) -> size_t {
+    return std::count_if(vColor.begin(), vColor.end(), [](Color C) { return C.r || C.g || C.b; });
+  };
+
+  for (auto Mode : {fluffy::fractal::render_mode::Buddhabrot, fluffy::fractal::render_mode::AntiBuddhabrot}) {
+    for (auto ImportanceSampling : {false, true}) {
+      auto const vA = ldaRender(Mode, ImportanceSampling);
+      auto const vB = ldaRender(Mode, ImportanceSampling);
+      REQUIRE(vA.size() == vB.size());
+      REQUIRE(0 == std::memcmp(vA.data(), vB.data(), vA.size() * sizeof(Color)));
+      REQUIRE(ldaNumLit(vA) > 100);
+    }
+  }
+
+  // ---
+  // NOTE: Escape time is not a density mode and leaves the image alone.
+  // ---
+  Image Img{};
+  auto  PC = fluffy::fractal::ConfigurePixelCanvas(50, 50, 100, 100, 33, 33);
+  fluffy::fractal::CreateDensityPixelSpace(
+      GridCfg, PC, es::VectorDouble(33., 33., 0.), fluffy::fractal::render_mode::EscapeTime, Cfg, Img);
+  REQUIRE(nullptr == Img.data);
+}
+
+/**
+ * Adaptive supersampling should look like supersampling every pixel, at a fraction of the samples.
+ */
+TEST_CASE("AdaptiveSupersampling", "[fractal]") {
+  constexpr int Zoom = 40;
+
+  currob::grid_cfg GridCfg{};
+  GridCfg.GridCenterValue = es::PointDouble(0., 0., 0.);
+  GridCfg.GridDimensions  = es::Vector(200.f / Zoom, 150.f / Zoom, 0.f);
+
+  std::shared_ptr<Color> vspColors[3]{};
+  Image                  vImg[3]{};
+  size_t                 vNumSupersampled[3]{};
+  for (int Idx = 0; Idx < 3; ++Idx) {
+    auto PC    = fluffy::fractal::ConfigurePixelCanvas(100, 75, 200, 150, Zoom, Zoom);
+    PC.Quality = fluffy::fractal::render_quality(Idx);
+    fluffy::fractal::CreateFractalPixelSpace(
+        GridCfg, PC, es::VectorDouble(Zoom, Zoom, 0.), es::VectorDouble(-0.4, 0.6, 0.), vImg[Idx]);
+    REQUIRE(vImg[Idx].data);
+    vspColors[Idx]        = PC.spColorArray;
+    vNumSupersampled[Idx] = PC.NumSupersampled;
+  }
+
+  auto const& Single      = vImg[int(fluffy::fractal::render_quality::Single)];
+  auto const& Adaptive    = vImg[int(fluffy::fractal::render_quality::Adaptive)];
+  auto const& Supersample = vImg[int(fluffy::fractal::render_quality::Supersample)];
+
+  REQUIRE(0 == vNumSupersampled[int(fluffy::fractal::render_quality::Single)]);
+  REQUIRE(vNumSupersampled[int(fluffy::fractal::render_quality::Adaptive)] > 0);
+  REQUIRE(vNumSupersampled[int(fluffy::fractal::render_quality::Adaptive)] <
+          vNumSupersampled[int(fluffy::fractal::render_quality::Supersample)] / 2);
+
+  auto const AdaptiveDiff = fluffy::juliasw::CompareImages(Adaptive, Supersample, 16);
+  auto const SingleDiff   = fluffy::juliasw::CompareImages(Single, Supersample, 16);
+  REQUIRE(AdaptiveDiff.NumDifferent * 100 <= AdaptiveDiff.NumPixels);
+  REQUIRE(AdaptiveDiff.MeanChannelDiff < SingleDiff.MeanChannelDiff / 10.);
+}
+
+/**
+ * Inverse iteration. For c = 0 the Julia set is the unit circle.
+ */
+TEST_CASE("InverseIteration", "[fractal]") {
+  for (auto const& Constant : {es::VectorDouble(0., 0., 0.), es::VectorDouble(-0.4, 0.6, 0.)}) {
+    auto const Z  = fluffy::fractal::RepellingFixedPoint(Constant);
+    auto const Zx = Z.x * Z.x - Z.y * Z.y + Constant.x;
+    auto const Zy = 2. * Z.x * Z.y + Constant.y;
+    REQUIRE(std::abs(Zx - Z.x) < 1e-12);
+    REQUIRE(std::abs(Zy - Z.y) < 1e-12);
+    REQUIRE(4. * (Z.x * Z.x + Z.y * Z.y) > 1.); // |2z| > 1, repelling.
+  }
+
+  constexpr int Zoom = 100;
+
+  currob::grid_cfg GridCfg{};
+  GridCfg.GridCenterValue = es::PointDouble(0., 0., 0.);
+  GridCfg.GridDimensions  = es::Vector(3.f, 3.f, 0.f);
+
+  auto  PC = fluffy::fractal::ConfigurePixelCanvas(150, 150, 300, 300, Zoom, Zoom);
+  Image Img{};
+  fluffy::fractal::CreateInverseIterationPixelSpace(
+      GridCfg, PC, es::VectorDouble(Zoom, Zoom, 0.), es::VectorDouble(0., 0., 0.), {}, Img);
+  REQUIRE(Img.data);
+
+  auto const* pColor = static_cast<Color const*>(Img.data);
+  int         NumLit{};
+  int         NumOffCircle{};
+  for (int Y = 0; Y < Img.height; ++Y) {
+    for (int X = 0; X < Img.width; ++X) {
+      if (!pColor[Y * Img.width + X].r)
+        continue;
+      ++NumLit;
+      auto const Px = -1.5 + (X + 0.5) / Zoom;
+      auto const Py = 1.5 - (Y + 0.5) / Zoom;
+      NumOffCircle += std::abs(std::sqrt(Px * Px + Py * Py) - 1.) >= 1. / Zoom;
+    }
+  }
+  REQUIRE(0 == NumOffCircle);
+  REQUIRE(NumLit > 2 * 3.14 * Zoom * 0.9);
+}
+
+/**
+ * Reentrant render API. Concurrent renders must give the same pixels as a serial render,
+ * and the output buffers must go back to the pool.
+ */
+TEST_CASE("RenderFractal", "[fractal]") {
+  fluffy::fractal::render_request Request{};
+  Request.Width    = 61; // Not a multiple of the row alignment, to get padding.
+  Request.Height   = 40;
+  Request.Zoom     = 30.;
+  Request.Quality  = fluffy::fractal::render_quality::Adaptive;
+  Request.NThreads = 2;
+
+  REQUIRE(!fluffy::fractal::RenderFractal(fluffy::fractal::render_request{}).Ok);
+
+  fluffy::memory::buffer_pool Pool{};
+  auto const Serial = fluffy::fractal::RenderFractal(Request, &Pool);
+  REQUIRE(Serial.Ok);
+  REQUIRE(Serial.Stride >= Serial.Width);
+  REQUIRE(Serial.NumSupersampled > 0);
+
+  auto ldaSame = [&](fluffy::fractal::render_result const& Result) -> bool {
+    for (int Y = 0; Y < Request.Height; ++Y) {
+      if (std::memcmp(Result.pPixels + size_t(Y) * Result.Stride,
+                      Serial.pPixels + size_t(Y) * Serial.Stride,
+                      sizeof(Color) * Request.Width))
+        return false;
+    }
+    return true;
+  };
+
+  constexpr int NCallers = 4;
+  {
+    std::vector<fluffy::fractal::render_result> vResult(NCallers);
+    std::vector<std::thread>                    vT{};
+    for (int Idx = 0; Idx < NCallers; ++Idx)
+      vT.push_back(std::thread([&, Idx]() { vResult[Idx] = fluffy::fractal::RenderFractal(Request, &Pool); }));
+    for (auto& T : vT) {
+      if (T.joinable())
+        T.join();
+    }
+    for (auto const& Result : vResult) {
+      REQUIRE(Result.Ok);
+      REQUIRE(ldaSame(Result));
+    }
+  }
+  REQUIRE(NCallers == Pool.NumFree());
+
+  // ---
+  // NOTE: Pooled buffers are reused, and the caller can supply the output.
+  // ---
+  {
+    auto const Again = fluffy::fractal::RenderFractal(Request, &Pool);
+    REQUIRE(NCallers - 1 == Pool.NumFree());
+    REQUIRE(ldaSame(Again));
+  }
+
+  // ---
+  // NOTE: The caller's columns to the right of Width, i.e. a neighbouring tile, are left alone.
+  // ---
+  auto const         Sentinel = Color{255, 0, 255, 255};
+  std::vector<Color> vOutput(size_t(Request.Width + 3) * Request.Height, Sentinel);
+  auto               Caller = Request;
+  Caller.pOutput            = vOutput.data();
+  Caller.OutputStride       = Request.Width + 3;
+  auto const Result         = fluffy::fractal::RenderFractal(Caller);
+  REQUIRE(Result.Ok);
+  REQUIRE(!Result.spPixels);
+  REQUIRE(vOutput.data() == Result.pPixels);
+  REQUIRE(ldaSame(Result));
+  auto Untouched = true;
+  for (int Y = 0; Y < Request.Height; ++Y) {
+    for (int X = Request.Width; X < Caller.OutputStride; ++X) {
+      auto const& Pixel = vOutput[size_t(Y) * Caller.OutputStride + X];
+      Untouched         = Untouched && 0 == std::memcmp(&Pixel, &Sentinel, sizeof(Color));
+    }
+  }
+  REQUIRE(Untouched);
+
+  auto const Img = fluffy::fractal::ToImage(Result);
+  REQUIRE(Img.width == Caller.OutputStride);
+  REQUIRE(Img.height == Request.Height);
+}
+
+/**
+ * Scoped regions. The hardware counters may be denied in the test environment, the
+ * timing must work either way.
+ */
+TEST_CASE("PerfCounters", "[perf]") {
+#ifdef __linux__
+  auto const StdinOpen = fcntl(0, F_GETFD) != -1;
+#endif
+  fluffy::perf::Reset();
+  fluffy::perf::Enable(false);
+  { fluffy::perf::region PerfRegion{"test.disabled"}; }
+  REQUIRE(fluffy::perf::Snapshot().empty());
+
+  fluffy::perf::Enable(true);
+  volatile double Sum{};
+  for (int Call = 0; Call < 3; ++Call) {
+    fluffy::perf::region PerfRegion{"test.loop"};
+    for (int Idx = 0; Idx < 100000; ++Idx)
+      Sum = Sum + std::sqrt(double(Idx));
+  }
+  fluffy::perf::Enable(false);
+
+  auto const vStats = fluffy::perf::Snapshot();
+  REQUIRE(1 == vStats.size());
+  REQUIRE("test.loop" == vStats[0].Name);
+  REQUIRE(3 == vStats[0].Calls);
+  REQUIRE(vStats[0].Seconds > 0.);
+  if (fluffy::perf::Available()) {
+    REQUIRE(3 == vStats[0].CountedCalls);
+    REQUIRE(vStats[0].Value[int(fluffy::perf::counter::Instructions)] > 100000);
+  } else {
+    REQUIRE(0 == vStats[0].CountedCalls);
+    REQUIRE(!fluffy::perf::Status().empty());
+  }
+
+  std::ostringstream Out{};
+  fluffy::perf::Report(Out);
+  REQUIRE(Out.str().find("test.loop") != std::string::npos);
+  fluffy::perf::Reset();
+
+#ifdef __linux__
+  // ---
+  // NOTE: The first region of a thread opens its group, and when that fails closes what it
+  //       opened. Only that, stdin stays open.
+  // ---
+  fluffy::perf::Enable(true);
+  std::thread([] { fluffy::perf::region PerfRegion{"test.thread"}; }).join();
+  fluffy::perf::Enable(false);
+  REQUIRE(StdinOpen == (fcntl(0, F_GETFD) != -1));
+  fluffy::perf::Reset();
+#endif
+}
+
+/**
+ * Test the software version of julia_set.fs.
+ */
+TEST_CASE("JuliaSoftwareRenderer", "[juliasw]") {
+  // ---
+  // NOTE: Hue 0, 1/3 and 2/3 gives pure red, green and blue.
+  // ---
+  {
+    auto const Red   = fluffy::juliasw::Hsv2rgb(0.f, 1.f, 1.f);
+    auto const Green = fluffy::juliasw::Hsv2rgb(1.f / 3.f, 1.f, 1.f);
+    auto const Blue  = fluffy::juliasw::Hsv2rgb(2.f / 3.f, 1.f, 1.f);
+    REQUIRE(Red.x == 1.f);
+    REQUIRE(Red.y == 0.f);
+    REQUIRE(Red.z == 0.f);
+    REQUIRE(Green.y == 1.f);
+    REQUIRE(Blue.z == 1.f);
+  }
+
+  constexpr int Width  = 80;
+  constexpr int Height = 45;
+
+  fluffy::juliasw::uniforms U{};
+  U.ScreenDims[0] = Width;
+  U.ScreenDims[1] = Height;
+  U.C[0]          = -0.348827f;
+  U.C[1]          = 0.607167f;
+  U.Offset[0]     = -Width / 2.f;
+  U.Offset[1]     = -Height / 2.f;
+  U.Zoom          = 1.f;
+
+  // ---
+  // NOTE: z = 0 is inside the set for this constant and must be black.
+  //       A point far away escapes at once and gets a color.
+  // ---
+  {
+    auto const Inside = fluffy::juliasw::ShadePixel(U, 0.5f, 0.5f);
+    REQUIRE(Inside.r == 0);
+    REQUIRE(Inside.g == 0);
+    REQUIRE(Inside.b == 0);
+    REQUIRE(Inside.a == 255);
+
+    auto const Outside = fluffy::juliasw::ShadePixel(U, 1.5f, 1.5f);
+    REQUIRE((Outside.r + Outside.g + Outside.b) > 0);
+  }
+
+  // ---
+  // NOTE: The result must not depend on the number of threads, and match per pixel shading.
+  // ---
+  {
+    Image One  = fluffy::juliasw::GenImageJuliaSet(U, Width, Height, 1);
+    Image Many = fluffy::juliasw::GenImageJuliaSet(U, Width, Height, 7);
+
+    auto const Diff = fluffy::juliasw::CompareImages(One, Many);
+    REQUIRE(Diff.SizeMismatch == false);
+    REQUIRE(Diff.NumPixels == Width * Height);
+    REQUIRE(Diff.NumDifferent == 0);
+
+    auto const* pColor = static_cast<Color const*>(One.data);
+    auto const  Pixel  = fluffy::juliasw::ShadePixel(U, (13 + 0.5f) / Width, (17 + 0.5f) / Height);
+    REQUIRE(pColor[17 * Width + 13].r == Pixel.r);
+    REQUIRE(pColor[17 * Width + 13].g == Pixel.g);
+    REQUIRE(pColor[17 * Width + 13].b == Pixel.b);
+
+    UnloadImage(One);
+    UnloadImage(Many);
+  }
+}
+
+/**
+ * Quaternion Julia ray-marcher. For c = 0 the set is the unit ball.
+ */
+TEST_CASE("QuatJuliaRayMarcher", "[quatjulia]") {
+  fluffy::quatjulia::params P{};
+  P.C[0] = P.C[1] = P.C[2] = P.C[3] = 0.f;
+
+  // ---
+  // NOTE: The estimate is a lower bound of the distance, and close to it near the surface.
+  // ---
+  for (auto R : {1.05f, 1.2f, 1.5f}) {
+    auto const D = fluffy::quatjulia::DistanceEstimate(P, Vector3{0.f, R, 0.f});
+    REQUIRE(D <= R - 1.f + 1e-4f);
+    REQUIRE(D > 0.5f * (R - 1.f));
+  }
+  REQUIRE(fluffy::quatjulia::DistanceEstimate(P, Vector3{0.f, 0.5f, 0.f}) <= 0.f);
+
+  constexpr int Width  = 64;
+  constexpr int Height = 36;
+
+  Camera3D Camera{};
+  Camera.position = Vector3{10.f, 10.f, 10.f};
+  Camera.target   = Vector3{0.f, 0.f, 0.f};
+  Camera.up       = Vector3{0.f, 1.f, 0.f};
+
+  for (auto Projection : {CAMERA_PERSPECTIVE, CAMERA_ORTHOGRAPHIC}) {
+    Camera.projection = Projection;
+    Camera.fovy       = CAMERA_PERSPECTIVE == Projection ? 45.f : 12.f;
+
+    std::vector<Color> vOne(Width * Height);
+    std::vector<Color> vMany(Width * Height);
+    fluffy::quatjulia::RenderQuatJulia(P, Camera, Width, Height, vOne.data(), 1);
+    fluffy::quatjulia::RenderQuatJulia(P, Camera, Width, Height, vMany.data(), 7);
+
+    REQUIRE(0 == std::memcmp(vOne.data(), vMany.data(), vOne.size() * sizeof(Color)));
+    REQUIRE(vOne[(Height / 2) * Width + Width / 2].a == 0xFF); // The ball is in the middle.
+    REQUIRE(vOne[0].a == 0);                                   // Corner is background.
+  }
 }
 
 /**
@@ -0,0 +1,264 @@
+/**
+ * Golden image tests for the fractal renderer.
+ *
+ * A fixed set of views is rendered and compared with the images stored in
+ * tests/golden, so that optimizations can not change the pixels unnoticed. Each
+ * view also has a time budget, in units of a calibration loop that is timed on the
+ * same machine, so that the budgets do not depend on how fast the machine is.
+ *
+ * Set FLUFFY_UPDATE_GOLDEN=1 to write new golden images after an intended change
+ * of the output, and FLUFFY_SKIP_BUDGETS=1 to skip the time budgets, i.e. when
+ * running under a profiler. The budgets are only checked in optimized builds, where
+ * FLUFFY_TIME_BUDGETS is defined.
+ *
+ * MIT License - see at bottom of file.
+ * Copyright (c) 2023 Willy Clarke
+ */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/fractal.hpp"
+#include "../src/juliasoftware.hpp"
+
+#include "raylib.h"
+
+#ifndef FLUFFY_GOLDEN_DIR
+#define FLUFFY_GOLDEN_DIR "golden"
+#endif
+
+namespace {
+
+/**
+ * One view of the test set.
+ */
+struct golden_view {
+  char const*                     pName{};
+  fluffy::fractal::render_request Request{};
+  double                          Budget{}; //!< Max render time in calibration loops, ~4x a single core.
+};
+
+/**
+ * Max channel difference allowed per pixel, and the share of pixels allowed above it.
+ * Leaves room for other compilers and instruction sets rounding differently.
+ */
+constexpr int    Tolerance     = 8;
+constexpr double MaxDifferent  = 0.005;
+constexpr int    NumTimingRuns = 3;
+constexpr int    GoldenWidth   = 96;
+constexpr int    GoldenHeight  = 64;
+
+auto EnvSet(char const* pName) -> bool {
+  auto const* pValue = std::getenv(pName);
+  return pValue && *pValue && std::string(pValue) != "0";
+}
+
+/**
+ * Write the rgb channels as binary PPM.
+ */
+auto WritePpm(std::string const& FileName, std::vector<Color> const& vPixels, int Width, int Height) -> bool {
+  std::ofstream File(FileName, std::ios::binary);
+  if (!File)
+    return false;
+  File << "P6\n" << Width << " " << Height << "\n255\n";
+  for (auto const& C : vPixels)
+    File.put(char(C.r)).put(char(C.g)).put(char(C.b));
+  return bool(File);
+}
+
+/**
+ * Read a binary PPM written by WritePpm. Empty when the file is missing or not understood.
+ */
+auto ReadPpm(std::string const& FileName, int& Width, int& Height) -> std::vector<Color> {
+  std::ifstream File(FileName, std::ios::binary);
+  std::string   Magic{};
+  int           MaxValue{};
+  File >> Magic >> Width >> Height >> MaxValue;
+  File.get(); // Single whitespace before the pixels.
+  if (!File || Magic != "P6" || MaxValue != 255 || Width <= 0 || Height <= 0)
+    return {};
+
+  std::vector<Color> vPixels(size_t(Width) * size_t(Height));
+  for (auto& C : vPixels) {
+    char Rgb[3]{};
+    File.read(Rgb, 3);
+    C = Color{uint8_t(Rgb[0]), uint8_t(Rgb[1]), uint8_t(Rgb[2]), 0xFF};
+  }
+  return File ? vPixels : std::vector<Color>{};
+}
+
+/**
+ * Wrap pixels in an Image for juliasw::CompareImages.
+ */
+auto ImageView(std::vector<Color>& vPixels, int Width, int Height) -> Image {
+  Image Img{};
+  Img.data    = vPixels.data();
+  Img.width   = Width;
+  Img.height  = Height;
+  Img.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  Img.mipmaps = 1;
+  return Img;
+}
+
+/**
+ * Seconds used by a fixed scalar workload, the unit of the time budgets. The best of
+ * a few runs, to keep out the noise from other processes.
+ */
+auto CalibrationSeconds() -> double {
+  auto Best = 1e9;
+  for (int Run = 0; Run < 5; ++Run) {
+    auto const     Start = std::chrono::steady_clock::now();
+    volatile float Sink{};
+    for (int P = 0; P < 1000; ++P) {
+      float Zx = -1.5f + 0.003f * P;
+      float Zy = 0.f;
+      for (int Idx = 0; Idx < 1000; ++Idx) {
+        auto const Zr = Zx * Zx - Zy * Zy - 0.4f;
+        Zy            = 2.f * Zx * Zy + 0.6f;
+        Zx            = std::clamp(Zr, -2.f, 2.f);
+      }
+      Sink = Sink + Zx;
+    }
+    Best = std::min(Best, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+  }
+  return Best;
+}
+
+/**
+ * The views. Escape time uses several threads to cover the seams between the thread
+ * blocks. The density and MIIM renders are deterministic with one thread only.
+ */
+auto GoldenViews() -> std::vector<golden_view> {
+  auto ldaView = [](fluffy::fractal::render_mode Mode, double Cx, double Cy, double Zoom) {
+    fluffy::fractal::render_request Request{};
+    Request.Mode     = Mode;
+    Request.Constant = es::VectorDouble(Cx, Cy, 0.);
+    Request.Zoom     = Zoom;
+    Request.Width    = GoldenWidth;
+    Request.Height   = GoldenHeight;
+    Request.NThreads = 1;
+    return Request;
+  };
+
+  std::vector<golden_view> vViews{};
+
+  auto Dendrite     = ldaView(fluffy::fractal::render_mode::EscapeTime, 0., 1., 30.);
+  Dendrite.NThreads = 4;
+  vViews.push_back({"julia_dendrite", Dendrite, 2.});
+
+  auto Rabbit    = ldaView(fluffy::fractal::render_mode::EscapeTime, -0.123, 0.745, 40.);
+  Rabbit.Quality = fluffy::fractal::render_quality::Adaptive;
+  vViews.push_back({"julia_rabbit_adaptive", Rabbit, 40.});
+
+  auto Zoomed   = ldaView(fluffy::fractal::render_mode::EscapeTime, -0.4, 0.6, 400.);
+  Zoomed.Center = es::VectorDouble(0.3, 0.2, 0.);
+  vViews.push_back({"julia_zoomed", Zoomed, 2.});
+
+  auto Super                = ldaView(fluffy::fractal::render_mode::EscapeTime, -0.8, 0.156, 30.);
+  Super.Quality             = fluffy::fractal::render_quality::Supersample;
+  Super.SupersamplesPerAxis = 2;
+  vViews.push_back({"julia_supersample", Super, 8.});
+
+  auto Buddha                       = ldaView(fluffy::fractal::render_mode::Buddhabrot, 0., 0., 25.);
+  Buddha.Center                     = es::VectorDouble(-0.5, 0., 0.);
+  Buddha.Density.NumSamples         = 20000;
+  Buddha.Density.ImportanceSampling = false;
+  vViews.push_back({"buddhabrot", Buddha, 8.});
+
+  auto Miim = ldaView(fluffy::fractal::render_mode::InverseIteration, -0.123, 0.745, 30.);
+  vViews.push_back({"miim_rabbit", Miim, 2.});
+
+  return vViews;
+}
+
+}; // end of anonymous namespace
+
+/**
+ * Compare each view with its golden image, and check its time budget.
+ */
+TEST_CASE("GoldenImages", "[golden]") {
+  auto const Update      = EnvSet("FLUFFY_UPDATE_GOLDEN");
+  auto const Calibration = CalibrationSeconds();
+#ifdef FLUFFY_TIME_BUDGETS
+  auto const CheckBudget = !EnvSet("FLUFFY_SKIP_BUDGETS");
+#else
+  auto const CheckBudget = false;
+#endif
+
+  for (auto const& View : GoldenViews()) {
+    DYNAMIC_SECTION(View.pName) {
+      // ---
+      // NOTE: Render a few times and keep the fastest, the pixels must be the same every time.
+      // ---
+      fluffy::fractal::render_result Result{};
+      auto                           Best = 1e9;
+      for (int Run = 0; Run < NumTimingRuns; ++Run) {
+        auto const Start = std::chrono::steady_clock::now();
+        Result           = fluffy::fractal::RenderFractal(View.Request);
+        Best = std::min(Best, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+        REQUIRE(Result.Ok);
+      }
+
+      std::vector<Color> vPixels(size_t(Result.Width) * size_t(Result.Height));
+      for (int Y = 0; Y < Result.Height; ++Y)
+        std::copy_n(
+            Result.pPixels + size_t(Y) * Result.Stride, Result.Width, vPixels.begin() + size_t(Y) * Result.Width);
+
+      auto const FileName = std::string(FLUFFY_GOLDEN_DIR) + "/" + View.pName + ".ppm";
+      if (Update) {
+        REQUIRE(WritePpm(FileName, vPixels, Result.Width, Result.Height));
+        WARN("Updated " << FileName);
+      }
+
+      int  GoldenW{};
+      int  GoldenH{};
+      auto vGolden = ReadPpm(FileName, GoldenW, GoldenH);
+      INFO("Golden image " << FileName << ". Run with FLUFFY_UPDATE_GOLDEN=1 to create it.");
+      REQUIRE(!vGolden.empty());
+
+      auto const Diff = fluffy::juliasw::CompareImages(ImageView(vPixels, Result.Width, Result.Height),
+                                                       ImageView(vGolden, GoldenW, GoldenH),
+                                                       Tolerance);
+      INFO("Different pixels: " << Diff.NumDifferent << " of " << Diff.NumPixels
+                                << ". Max channel diff: " << Diff.MaxChannelDiff);
+      REQUIRE(!Diff.SizeMismatch);
+      REQUIRE(double(Diff.NumDifferent) <= MaxDifferent * double(Diff.NumPixels));
+
+      auto const Cost = Best / Calibration;
+      INFO("Render took " << Best * 1000. << " ms, " << Cost << " calibration loops. Budget " << View.Budget);
+      if (CheckBudget)
+        REQUIRE(Cost <= View.Budget);
+    }
+  }
+}
+
+/**
+MIT License
+
+Copyright (c) 2023 Willy Clarke
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -6,12 +6,14 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include <termios.h>
 #include <unistd.h> // For STDIN_FILENO
 
+#include "../../src/perfcounters.hpp"
 #include "appstate.hpp"
 #include "statemachine.hpp"
 
@@ -232,7 +234,16 @@ app::set_noncanonical_mode gSetCanonicalMode{};
 
 /**
  */
-auto main() -> int {
+auto main(int argc, char const* argv[]) -> int {
+
+  /* --perf <file.csv> measures the state callbacks with the hardware counters. */
+  std::string PerfFile{};
+  for (int Idx = 1; Idx < argc; ++Idx) {
+    auto const Arg = std::string(argv[Idx]);
+    if (Arg == "--perf" && Idx + 1 < argc)
+      PerfFile = argv[++Idx];
+  }
+  fluffy::perf::Enable(!PerfFile.empty());
 
   auto pAppState = std::make_shared<app::app_state>();
   if (!pAppState)
@@ -249,6 +260,12 @@ auto main() -> int {
 
   pAppState.reset();
 
+  if (!PerfFile.empty()) {
+    fluffy::perf::Report(std::cout);
+    if (!fluffy::perf::WriteCsv(PerfFile))
+      std::cerr << "Could not write " << PerfFile << std::endl;
+  }
+
   std::cout << __PRETTY_FUNCTION__ << " -> Normal exit ..." << std::endl;
 
   /* Try to clean up all globals as well */
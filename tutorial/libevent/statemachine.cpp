@@ -9,6 +9,7 @@
  * ******************************************************************************/
 #include <iostream>
 
+#include "../../src/perfcounters.hpp"
 #include "statemachine.hpp"
 
 /**
@@ -153,6 +154,8 @@ void fsm_statemachine::Trig(char C) {
  *
  */
 void fsm_statemachine::StateKeepAlive(evutil_socket_t Sockfd, short Event, void* pArg) {
+  fluffy::perf::region PerfRegion{"fsm.keepalive"};
+
   auto pFsm = (fsm_statemachine*)pArg;
 
   auto pAppState = pFsm->pAppState;
@@ -172,6 +175,8 @@ void fsm_statemachine::StateKeepAlive(evutil_socket_t Sockfd, short Event, void*
  *
  */
 void fsm_statemachine::StateInit(evutil_socket_t Sockfd, short Event, void* pArg) {
+  fluffy::perf::region PerfRegion{"fsm.init"};
+
   auto pFsm = (fsm_statemachine*)pArg;
   std::cout << pArg << " :: " << __PRETTY_FUNCTION__ << ". ID: " << pFsm->ID << std::endl;
 }
@@ -180,6 +185,8 @@ void fsm_statemachine::StateInit(evutil_socket_t Sockfd, short Event, void* pArg
  *
  */
 void fsm_statemachine::StateA(evutil_socket_t Sockfd, short Event, void* pArg) {
+  fluffy::perf::region PerfRegion{"fsm.statea"};
+
   auto pFsm = (fsm_statemachine*)pArg;
   std::cout << pArg << " :: " << __PRETTY_FUNCTION__ << ". ID: " << pFsm->ID << std::endl;
 }
@@ -188,6 +195,8 @@ void fsm_statemachine::StateA(evutil_socket_t Sockfd, short Event, void* pArg) {
  *
  */
 void fsm_statemachine::StateB(evutil_socket_t Sockfd, short Event, void* pArg) {
+  fluffy::perf::region PerfRegion{"fsm.stateb"};
+
   auto pFsm = (fsm_statemachine*)pArg;
   std::cout << pArg << " :: " << __PRETTY_FUNCTION__ << ". ID: " << pFsm->ID << std::endl;
 }
@@ -196,6 +205,8 @@ void fsm_statemachine::StateB(evutil_socket_t Sockfd, short Event, void* pArg) {
  *
  */
 void fsm_statemachine::StateC(evutil_socket_t Sockfd, short Event, void* pArg) {
+  fluffy::perf::region PerfRegion{"fsm.statec"};
+
   auto pFsm = (fsm_statemachine*)pArg;
   std::cout << pArg << " :: " << __PRETTY_FUNCTION__ << ". ID: " << pFsm->ID << std::endl;
 